@@ -0,0 +1,105 @@
+#include "BlockAllocator.h"
+
+#include <cstddef>
+#include <new>
+#include <thread>
+
+namespace BSE
+{
+    BlockAllocator::BlockAllocator(std::initializer_list<size_t> sizeClasses)
+    {
+        if (sizeClasses.size() > MaxSizeClasses)
+            throw std::runtime_error("BlockAllocator - too many size classes");
+
+        for (size_t blockSize : sizeClasses)
+        {
+            if (blockSize < sizeof(FreeBlock) || (blockSize & (blockSize - 1)) != 0 || blockSize > SlabSize
+                || (m_classCount > 0 && blockSize <= m_classes[m_classCount - 1].blockSize))
+                throw std::runtime_error("BlockAllocator - size classes must be ascending powers of two");
+
+            m_classes[m_classCount++].blockSize = blockSize;
+        }
+    }
+
+    void BlockAllocator::SizeClass::Lock()
+    {
+        while (lock.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    int BlockAllocator::FindSizeClass(size_t size, size_t align) const
+    {
+        if (align > BlockAlign)
+            return -1;
+
+        // Blocks are aligned to their size up to the slab's alignment
+        for (size_t i = 0; i < m_classCount; ++i)
+        {
+            if (size <= m_classes[i].blockSize && align <= m_classes[i].blockSize)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    void* BlockAllocator::Allocate(size_t size, size_t align)
+    {
+        const int index = FindSizeClass(size, align);
+        if (index < 0)
+            return ::operator new(size, std::align_val_t(std::max(align, alignof(std::max_align_t))));
+
+        SizeClass& sizeClass = m_classes[index];
+
+        sizeClass.Lock();
+        if (FreeBlock* block = sizeClass.head)
+        {
+            sizeClass.head = block->next;
+            sizeClass.Unlock();
+            return block;
+        }
+        sizeClass.Unlock();
+
+        // Carve a new slab, keep the first block and give the rest to the free list
+        const size_t blockSize = sizeClass.blockSize;
+        const size_t blockCount = SlabSize / blockSize;
+        unsigned char* slab = static_cast<unsigned char*>(::operator new(SlabSize, std::align_val_t(BlockAlign)));
+        if (blockCount < 2)
+            return slab;
+
+        FreeBlock* first = reinterpret_cast<FreeBlock*>(slab + blockSize);
+        FreeBlock* last = first;
+        for (size_t i = 2; i < blockCount; ++i)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+            last->next = block;
+            last = block;
+        }
+
+        sizeClass.Lock();
+        last->next = sizeClass.head;
+        sizeClass.head = first;
+        sizeClass.Unlock();
+
+        return slab;
+    }
+
+    void BlockAllocator::Free(void* block, size_t size, size_t align) noexcept
+    {
+        if (!block)
+            return;
+
+        const int index = FindSizeClass(size, align);
+        if (index < 0)
+        {
+            ::operator delete(block, std::align_val_t(std::max(align, alignof(std::max_align_t))));
+            return;
+        }
+
+        SizeClass& sizeClass = m_classes[index];
+        FreeBlock* freed = static_cast<FreeBlock*>(block);
+
+        sizeClass.Lock();
+        freed->next = sizeClass.head;
+        sizeClass.head = freed;
+        sizeClass.Unlock();
+    }
+}
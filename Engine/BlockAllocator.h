@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+
+#include <initializer_list>
+
+namespace BSE
+{
+    // Free lists of fixed size blocks carved from slabs that are never handed back, so after warm up an
+    // allocation is a free list pop. Sizes above the largest class and alignments above 64 bytes go to the
+    // global heap. Safe from any thread, each size class has its own spin lock.
+    class DLL_EXPORT BlockAllocator
+    {
+    public:
+        static constexpr size_t MaxSizeClasses = 8;
+        static constexpr size_t BlockAlign = 64;
+        static constexpr size_t SlabSize = 64 * 1024;
+
+        // Ascending powers of two up to SlabSize
+        explicit BlockAllocator(std::initializer_list<size_t> sizeClasses);
+
+        BlockAllocator(const BlockAllocator&) = delete;
+        BlockAllocator& operator=(const BlockAllocator&) = delete;
+
+        void* Allocate(size_t size, size_t align);
+        // size and align have to match the Allocate call
+        void Free(void* block, size_t size, size_t align) noexcept;
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        struct SizeClass
+        {
+            std::atomic_flag lock = ATOMIC_FLAG_INIT;
+            FreeBlock* head = nullptr;
+            size_t blockSize = 0;
+
+            void Lock();
+            void Unlock() { lock.clear(std::memory_order_release); }
+        };
+
+        int FindSizeClass(size_t size, size_t align) const;
+
+        std::array<SizeClass, MaxSizeClasses> m_classes;
+        size_t m_classCount = 0;
+    };
+}
@@ -0,0 +1,271 @@
+#include "DestructionQueue.h"
+
+#include "../Renderer/OpenGL.h"
+#include "../Sound/OpenAL.h"
+
+namespace BSE
+{
+    namespace
+    {
+        std::atomic<DestructionQueue*> s_currentQueue{ nullptr };
+
+        constexpr bool IsGL(GPUResource kind)
+        {
+            return kind != GPUResource::ALSource && kind != GPUResource::ALBuffer;
+        }
+    }
+
+    DestructionQueue::DestructionQueue(const DestructionSettings& settings)
+        : m_settings(settings)
+    {
+    }
+
+    DestructionQueue::~DestructionQueue()
+    {
+        DestructionQueue* self = this;
+        s_currentQueue.compare_exchange_strong(self, nullptr);
+        Flush();
+    }
+
+    void DestructionQueue::SetCurrent(DestructionQueue* queue)
+    {
+        s_currentQueue.store(queue, std::memory_order_release);
+    }
+
+    DestructionQueue* DestructionQueue::GetCurrent()
+    {
+        return s_currentQueue.load(std::memory_order_acquire);
+    }
+
+    void DestructionQueue::Release(GPUResource kind, uint32_t handle)
+    {
+        if (handle == 0)
+            return;
+
+        if (DestructionQueue* queue = GetCurrent())
+            queue->Enqueue(kind, handle);
+        else
+            DeleteHandles(kind, &handle, 1);
+    }
+
+    void DestructionQueue::Enqueue(GPUResource kind, uint32_t handle)
+    {
+        if (handle == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingHandles[static_cast<size_t>(kind)].push_back(handle);
+    }
+
+    void DestructionQueue::Enqueue(TaskFunction&& destroy)
+    {
+        if (!destroy)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingObjects.push_back(std::move(destroy));
+    }
+
+    void DestructionQueue::EndFrame()
+    {
+        const Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::micro>(m_settings.budgetMicros));
+
+        m_stats.releasedObjects = 0;
+        m_stats.releasedHandles = 0;
+
+        // Objects first, the handles they give up while dying join this frame's batch
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (TaskFunction& destroy : m_pendingObjects)
+                m_objects.push_back(std::move(destroy));
+            m_pendingObjects.clear();
+        }
+        ReleaseObjects(&deadline);
+
+        TakePending(m_settings.useFences);
+
+        while (!m_batches.empty() && IsDue(m_batches.front()))
+        {
+            const bool finished = ReleaseBatch(m_batches.front(), &deadline);
+            if (!finished)
+                break;
+
+            DestroyFence(m_batches.front());
+            m_batches.pop_front();
+
+            if (Clock::now() >= deadline)
+                break;
+        }
+
+        ++m_frame;
+
+        m_stats.pendingObjects = m_objects.size();
+        m_stats.pendingHandles = 0;
+        for (const Batch& batch : m_batches)
+        {
+            for (size_t kind = batch.nextKind; kind < batch.handles.size(); ++kind)
+                m_stats.pendingHandles += batch.handles[kind].size() - (kind == batch.nextKind ? batch.nextHandle : 0);
+        }
+    }
+
+    void DestructionQueue::Flush()
+    {
+        // Destroying objects may release more handles and objects, keep going until nothing is left
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (TaskFunction& destroy : m_pendingObjects)
+                    m_objects.push_back(std::move(destroy));
+                m_pendingObjects.clear();
+            }
+            ReleaseObjects(nullptr);
+
+            TakePending(false);
+            for (Batch& batch : m_batches)
+            {
+                ReleaseBatch(batch, nullptr);
+                DestroyFence(batch);
+            }
+            m_batches.clear();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const bool handlesLeft = std::any_of(m_pendingHandles.begin(), m_pendingHandles.end(), [](const std::vector<uint32_t>& handles) {
+                return !handles.empty();
+            });
+            if (m_pendingObjects.empty() && !handlesLeft)
+                break;
+        }
+
+        m_stats.pendingObjects = 0;
+        m_stats.pendingHandles = 0;
+    }
+
+    void DestructionQueue::TakePending(bool fence)
+    {
+        Batch batch;
+        bool empty = true;
+        bool hasGL = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t kind = 0; kind < m_pendingHandles.size(); ++kind)
+            {
+                if (m_pendingHandles[kind].empty())
+                    continue;
+
+                // Swapping keeps the capacity of both sides around for the next frames
+                batch.handles[kind].swap(m_pendingHandles[kind]);
+                empty = false;
+                hasGL = hasGL || IsGL(static_cast<GPUResource>(kind));
+            }
+        }
+
+        if (empty)
+            return;
+
+        batch.frame = m_frame;
+        if (fence && hasGL && glFenceSync)
+            batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_batches.push_back(std::move(batch));
+    }
+
+    bool DestructionQueue::IsDue(const Batch& batch) const
+    {
+        if (batch.fence)
+        {
+            const GLenum status = glClientWaitSync(static_cast<GLsync>(batch.fence), 0, 0);
+            return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED;
+        }
+        return m_frame - batch.frame >= m_settings.framesInFlight;
+    }
+
+    bool DestructionQueue::ReleaseObjects(const Clock::time_point* deadline)
+    {
+        while (!m_objects.empty())
+        {
+            // Taken off the queue first, destroy may enqueue more
+            TaskFunction destroy = std::move(m_objects.front());
+            m_objects.pop_front();
+            destroy();
+            ++m_stats.releasedObjects;
+
+            if (deadline && Clock::now() >= *deadline)
+                return m_objects.empty();
+        }
+        return true;
+    }
+
+    bool DestructionQueue::ReleaseBatch(Batch& batch, const Clock::time_point* deadline)
+    {
+        const size_t perCall = std::max<size_t>(m_settings.handlesPerCall, 1);
+        for (; batch.nextKind < batch.handles.size(); ++batch.nextKind, batch.nextHandle = 0)
+        {
+            const std::vector<uint32_t>& handles = batch.handles[batch.nextKind];
+            while (batch.nextHandle < handles.size())
+            {
+                const size_t count = std::min(perCall, handles.size() - batch.nextHandle);
+                DeleteHandles(static_cast<GPUResource>(batch.nextKind), handles.data() + batch.nextHandle, count);
+                batch.nextHandle += count;
+                m_stats.releasedHandles += count;
+
+                if (deadline && Clock::now() >= *deadline)
+                {
+                    if (batch.nextHandle < handles.size())
+                        return false;
+
+                    // Skip past empty kinds to tell whether anything is left
+                    size_t kind = batch.nextKind + 1;
+                    while (kind < batch.handles.size() && batch.handles[kind].empty())
+                        ++kind;
+                    if (kind == batch.handles.size())
+                        return true;
+
+                    batch.nextKind = kind;
+                    batch.nextHandle = 0;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void DestructionQueue::DestroyFence(Batch& batch)
+    {
+        if (batch.fence)
+            glDeleteSync(static_cast<GLsync>(batch.fence));
+        batch.fence = nullptr;
+    }
+
+    void DestructionQueue::DeleteHandles(GPUResource kind, const uint32_t* handles, size_t count)
+    {
+        switch (kind)
+        {
+        case GPUResource::ALSource:
+            alDeleteSources(static_cast<ALsizei>(count), handles);
+            break;
+        case GPUResource::ALBuffer:
+            alDeleteBuffers(static_cast<ALsizei>(count), handles);
+            break;
+        case GPUResource::GLVertexArray:
+            glDeleteVertexArrays(static_cast<GLsizei>(count), handles);
+            break;
+        case GPUResource::GLProgram:
+            for (size_t i = 0; i < count; ++i)
+                glDeleteProgram(handles[i]);
+            break;
+        case GPUResource::GLShader:
+            for (size_t i = 0; i < count; ++i)
+                glDeleteShader(handles[i]);
+            break;
+        case GPUResource::GLTexture:
+            glDeleteTextures(static_cast<GLsizei>(count), handles);
+            break;
+        case GPUResource::GLBuffer:
+            glDeleteBuffers(static_cast<GLsizei>(count), handles);
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+
+#include "../Threading/TaskFunction.h"
+
+#include <deque>
+
+namespace BSE
+{
+    // In release order, things holding on to others go first
+    enum class GPUResource : uint8_t
+    {
+        ALSource,
+        ALBuffer,
+        GLVertexArray,
+        GLProgram,
+        GLShader,
+        GLTexture,
+        GLBuffer,
+        Count
+    };
+
+    struct DLL_EXPORT DestructionSettings
+    {
+        // Main thread time per EndFrame spent releasing. At least one object and one call's worth of handles go
+        // when any are due.
+        double budgetMicros = 1000.0;
+
+        // Handles wait for a fence placed at the end of the frame that retired them, so the GPU is done with
+        // them. Without fences they wait this many frames instead.
+        bool useFences = true;
+        uint32_t framesInFlight = 2;
+
+        // Handles per glDelete*/alDelete* call
+        uint32_t handlesPerCall = 256;
+    };
+
+    struct DestructionStats
+    {
+        size_t pendingObjects = 0;
+        size_t pendingHandles = 0;
+        // Released by the last EndFrame
+        size_t releasedObjects = 0;
+        size_t releasedHandles = 0;
+    };
+
+    // Collects dead objects and GL/AL handles from any thread and releases them in batches at the end of a frame,
+    // spread over as many frames as the budget needs. Resource classes hand their handles to Release, which goes
+    // through the current queue when one is set and deletes right away otherwise.
+    class DLL_EXPORT DestructionQueue
+    {
+    public:
+        explicit DestructionQueue(const DestructionSettings& settings = DestructionSettings());
+        // Flushes, the GL and AL contexts must still be alive
+        ~DestructionQueue();
+
+        DestructionQueue(const DestructionQueue&) = delete;
+        DestructionQueue& operator=(const DestructionQueue&) = delete;
+
+        // Queue resource classes release into, nullptr to delete immediately again
+        static void SetCurrent(DestructionQueue* queue);
+        static DestructionQueue* GetCurrent();
+
+        // Handle 0 is ignored. Must be called on the GL/AL thread when no queue is current.
+        static void Release(GPUResource kind, uint32_t handle);
+
+        // Safe from any thread
+        void Enqueue(GPUResource kind, uint32_t handle);
+        // destroy runs on the main thread during a later EndFrame, typically it owns the object and lets go of it
+        void Enqueue(TaskFunction&& destroy);
+
+        // Main thread with the GL context current, after the frame's draw calls were issued
+        void EndFrame();
+
+        // Releases everything now regardless of fences and budget, for shutdown and level changes
+        void Flush();
+
+        void SetSettings(const DestructionSettings& settings) { m_settings = settings; }
+        const DestructionSettings& GetSettings() const { return m_settings; }
+        const DestructionStats& GetStats() const { return m_stats; }
+
+    private:
+        // Handles retired during one frame
+        struct Batch
+        {
+            uint64_t frame = 0;
+            // GLsync, null when the batch holds no GL handles or fences are off
+            void* fence = nullptr;
+            std::array<std::vector<uint32_t>, static_cast<size_t>(GPUResource::Count)> handles;
+
+            // Where a batch cut short by the budget resumes
+            size_t nextKind = 0;
+            size_t nextHandle = 0;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        void TakePending(bool fence);
+        bool IsDue(const Batch& batch) const;
+        // Both return false when the deadline passed before they were done, a null deadline means no budget
+        bool ReleaseObjects(const Clock::time_point* deadline);
+        bool ReleaseBatch(Batch& batch, const Clock::time_point* deadline);
+        static void DestroyFence(Batch& batch);
+
+        static void DeleteHandles(GPUResource kind, const uint32_t* handles, size_t count);
+
+        DestructionSettings m_settings;
+        DestructionStats m_stats;
+
+        std::mutex m_mutex;
+        std::vector<TaskFunction> m_pendingObjects;
+        std::array<std::vector<uint32_t>, static_cast<size_t>(GPUResource::Count)> m_pendingHandles;
+
+        // Objects are destroyed at the first EndFrame after they arrive, handles wait on their batch's fence
+        std::deque<TaskFunction> m_objects;
+        std::deque<Batch> m_batches;
+        uint64_t m_frame = 0;
+    };
+}
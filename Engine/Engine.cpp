@@ -1,4 +1,5 @@
 #include "Engine.h"
+#include "../Threading/CPUTopology.h"
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -48,8 +49,12 @@ namespace BSE
 
     unsigned int Engine::GetCPUThreadCount()
     {
-        unsigned int threads = std::thread::hardware_concurrency();
-        return threads > 0 ? threads : 1;
+        return static_cast<unsigned int>(std::max<size_t>(1, CPUTopology::Get().GetLogicalCount()));
+    }
+
+    unsigned int Engine::GetCPUCoreCount()
+    {
+        return static_cast<unsigned int>(std::max<size_t>(1, CPUTopology::Get().GetCoreCount()));
     }
 
     uint64_t Engine::GetTotalRAM()
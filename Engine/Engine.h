@@ -16,7 +16,10 @@ namespace BSE
 
         void DetectFrameAndTickRates(BSE::Time& time);
 
+        // Logical CPUs this process may run on
         static unsigned int GetCPUThreadCount();
+        // Physical cores among them, SMT siblings counted once
+        static unsigned int GetCPUCoreCount();
         static uint64_t GetTotalRAM();
         static uint64_t GetAvailableRAM();
     };
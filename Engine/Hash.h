@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+
+#include <string_view>
+
+namespace BSE
+{
+    // 64 bit FNV-1a, usable in constant expressions so literals hash at compile time
+    constexpr uint64_t FNV1a64Offset = 0xCBF29CE484222325ull;
+    constexpr uint64_t FNV1a64Prime = 0x100000001B3ull;
+
+    constexpr uint64_t HashFNV1a64(std::string_view text, uint64_t hash = FNV1a64Offset) noexcept
+    {
+        for (char c : text)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= FNV1a64Prime;
+        }
+        return hash;
+    }
+
+    constexpr uint32_t FNV1a32Offset = 0x811C9DC5u;
+    constexpr uint32_t FNV1a32Prime = 0x01000193u;
+
+    constexpr uint32_t HashFNV1a32(std::string_view text, uint32_t hash = FNV1a32Offset) noexcept
+    {
+        for (char c : text)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= FNV1a32Prime;
+        }
+        return hash;
+    }
+
+    constexpr uint64_t HashCombine(uint64_t seed, uint64_t value) noexcept
+    {
+        return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+#include "Time.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace BSE
+{
+    namespace Detail
+    {
+        inline float Blend(float a, float b, float t) { return a + (b - a) * t; }
+        inline glm::vec3 Blend(const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); }
+        inline glm::quat Blend(const glm::quat& a, const glm::quat& b, float t) { return glm::slerp(a, b, t); }
+    }
+
+    // A value as of the last two ticks of a Time. Set with the index of the tick doing the write keeps the value
+    // the previous tick ended with, Sample blends from it to the latest one by the render alpha. Values the last
+    // tick didn't write, or written since it closed, sample as they are, so resting objects and per frame input
+    // never lag. The first write jumps straight to its value instead of blending in from the initial one.
+    template<typename T>
+    class Interpolated
+    {
+    public:
+        Interpolated(const T& value = T())
+            : m_previous(value)
+            , m_current(value) {}
+
+        // tick is GetTickIndex() of the Time driving the value, Time::InvalidTick jumps to value like Snap
+        void Set(const T& value, uint64_t tick)
+        {
+            if (!m_written || tick == Time::InvalidTick)
+            {
+                Snap(value);
+                m_tick = tick;
+                return;
+            }
+
+            if (m_tick != tick)
+            {
+                m_previous = m_current;
+                m_tick = tick;
+            }
+            m_current = value;
+        }
+
+        // Jumps to value without blending, for teleports and spawns
+        void Snap(const T& value)
+        {
+            m_previous = value;
+            m_current = value;
+            m_written = true;
+        }
+
+        const T& Get() const { return m_current; }
+        const T& GetPrevious() const { return m_previous; }
+
+        bool IsBlending(uint64_t tick) const { return m_tick != Time::InvalidTick && m_tick + 1 == tick; }
+
+        T Sample(double alpha, uint64_t tick) const
+        {
+            if (!IsBlending(tick))
+                return m_current;
+            return Detail::Blend(m_previous, m_current, static_cast<float>(std::clamp(alpha, 0.0, 1.0)));
+        }
+
+    private:
+        T m_previous;
+        T m_current;
+        // Tick index when last written, the tick that index closes is the one that wrote it
+        uint64_t m_tick = Time::InvalidTick;
+        bool m_written = false;
+    };
+}
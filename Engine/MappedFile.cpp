@@ -0,0 +1,145 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BSE
+{
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        Close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#if defined(_WIN32) || defined(_WIN64)
+        m_file = std::exchange(other.m_file, nullptr);
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+        return *this;
+    }
+
+    void MappedFile::Prefault() const
+    {
+        constexpr size_t PageSize = 4096;
+
+        volatile uint8_t sink = 0;
+        for (size_t offset = 0; offset < m_size; offset += PageSize)
+            sink = sink + m_data[offset];
+        if (m_size > 0)
+            sink = sink + m_data[m_size - 1];
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            std::cerr << "[MappedFile] Failed to open file: " << path << std::endl;
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            std::cerr << "[MappedFile] Empty or unreadable file: " << path << std::endl;
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            std::cerr << "[MappedFile] Failed to map file: " << path << std::endl;
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_file = file;
+        m_mapping = mapping;
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(static_cast<HANDLE>(m_mapping));
+        if (m_file)
+            CloseHandle(static_cast<HANDLE>(m_file));
+
+        m_data = nullptr;
+        m_size = 0;
+        m_file = nullptr;
+        m_mapping = nullptr;
+    }
+#else
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            std::cerr << "[MappedFile] Failed to open file: " << path << std::endl;
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size <= 0)
+        {
+            std::cerr << "[MappedFile] Empty or unreadable file: " << path << std::endl;
+            close(file);
+            return false;
+        }
+
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        // The mapping keeps the file alive on its own
+        close(file);
+
+        if (view == MAP_FAILED)
+        {
+            std::cerr << "[MappedFile] Failed to map file: " << path << std::endl;
+            return false;
+        }
+
+        // Loaders read front to back, let the OS fetch ahead in large chunks
+        posix_madvise(view, size, POSIX_MADV_SEQUENTIAL);
+        posix_madvise(view, size, POSIX_MADV_WILLNEED);
+
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = size;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data)
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+
+namespace BSE
+{
+    // Read only view of a whole file mapped into memory. Pages are read in by the OS as they are touched,
+    // loaders can work straight out of GetData() instead of copying through stream buffers.
+    class DLL_EXPORT MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path) { Open(path); }
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // Empty files can't be mapped and fail to open
+        bool Open(const std::string& path);
+        void Close();
+
+        bool IsOpen() const { return m_data != nullptr; }
+        const uint8_t* GetData() const { return m_data; }
+        size_t GetSize() const { return m_size; }
+
+        // Touches every page so reads afterwards don't block on the disk, meant for loader threads
+        void Prefault() const;
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+
+#if defined(_WIN32) || defined(_WIN64)
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+    };
+}
@@ -1,5 +1,7 @@
 #include "Noise.h"
 
+#include "../Threading/ThreadingSystem.h"
+
 namespace BSE
 {
     const float SimpleNoise::F2 = 0.5f * (std::sqrt(3.0f) - 1.0f);
@@ -99,11 +101,59 @@ namespace BSE
         std::vector<float> map;
         map.resize(width * height);
 
+        GenerateRows(map, width, height, type, 0, height);
+
+        if (m_settings.normalize)
+            NormalizeMap(map);
+
+        for (auto &v : map) v = Sat(v);
+
+        return map;
+    }
+
+    std::vector<float> SimpleNoise::GenerateNoiseMap(int width, int height, NoiseType type, ThreadPool& pool)
+    {
+        assert(width > 0 && height > 0);
+        std::vector<float> map;
+        map.resize(width * height);
+
+        pool.ParallelForRange(0, static_cast<size_t>(height), [&](size_t rowBegin, size_t rowEnd) {
+            GenerateRows(map, width, height, type, static_cast<int>(rowBegin), static_cast<int>(rowEnd));
+        });
+
+        if (m_settings.normalize && !map.empty())
+        {
+            // Min and max are exact, so the chunked reduction matches NormalizeMap bit for bit
+            using Range = std::pair<float, float>;
+            const Range identity(std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity());
+            const Range range = pool.ParallelReduce(0, map.size(), identity,
+                [&](size_t i) { return Range(map[i], map[i]); },
+                [](const Range& a, const Range& b) { return Range(std::min(a.first, b.first), std::max(a.second, b.second)); });
+
+            const float minv = range.first;
+            const float maxv = range.second;
+            const bool flat = maxv - minv < 1e-8f;
+            const float invRange = flat ? 0.0f : 1.0f / (maxv - minv);
+
+            pool.ParallelFor(0, map.size(), [&](size_t i) {
+                map[i] = Sat(flat ? 0.5f : (map[i] - minv) * invRange);
+            });
+        }
+        else
+        {
+            pool.ParallelFor(0, map.size(), [&](size_t i) { map[i] = Sat(map[i]); });
+        }
+
+        return map;
+    }
+
+    void SimpleNoise::GenerateRows(std::vector<float>& map, int width, int height, NoiseType type, int rowBegin, int rowEnd)
+    {
         const auto s = m_settings;
         const float invW = 1.0f / std::max(1, width);
         const float invH = 1.0f / std::max(1, height);
 
-        for (int y = 0; y < height; ++y)
+        for (int y = rowBegin; y < rowEnd; ++y)
         {
             for (int x = 0; x < width; ++x)
             {
@@ -147,13 +197,6 @@ namespace BSE
                 map[y * width + x] = value;
             }
         }
-
-        if (m_settings.normalize)
-            NormalizeMap(map);
-
-        for (auto &v : map) v = Sat(v);
-
-        return map;
     }
 
     Texture2D SimpleNoise::GenerateTexture(int width, int height, NoiseType type, int channels)
@@ -7,6 +7,8 @@
 
 namespace BSE
 {
+    class ThreadPool;
+
     enum class NoiseType
     {
         White,
@@ -52,6 +54,8 @@ namespace BSE
         void SetNormalize(bool n) { m_settings.normalize = n; }
 
         std::vector<float> GenerateNoiseMap(int width, int height, NoiseType type);
+        // Splits rows across the pool, the map is bit identical to the serial overload
+        std::vector<float> GenerateNoiseMap(int width, int height, NoiseType type, ThreadPool& pool);
 
         Texture2D GenerateTexture(int width, int height, NoiseType type, int channels = 3);
 
@@ -84,6 +88,7 @@ namespace BSE
         static const float F2;
         static const float G2;
 
+        void GenerateRows(std::vector<float>& map, int width, int height, NoiseType type, int rowBegin, int rowEnd);
         void NormalizeMap(std::vector<float>& map);
 
         static inline float Sat(float v) { return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v); }
@@ -0,0 +1,21 @@
+#include "ObjectPool.h"
+#include "BlockAllocator.h"
+
+namespace BSE
+{
+    namespace
+    {
+        // Classes sized for container nodes, kept apart from task storage so the two don't contend
+        BlockAllocator& GetRecycledBlocks()
+        {
+            static BlockAllocator allocator({ 32, 64, 128, 256, 512, 1024, 2048, 4096 });
+            return allocator;
+        }
+    }
+
+    namespace Detail
+    {
+        void* AllocateRecycled(size_t size, size_t align) { return GetRecycledBlocks().Allocate(size, align); }
+        void FreeRecycled(void* block, size_t size, size_t align) noexcept { GetRecycledBlocks().Free(block, size, align); }
+    }
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+
+#include <new>
+#include <unordered_map>
+
+namespace BSE
+{
+    namespace Detail
+    {
+        // Process wide BlockAllocator for container nodes, sizes above the largest class go to the global heap
+        DLL_EXPORT void* AllocateRecycled(size_t size, size_t align);
+        DLL_EXPORT void FreeRecycled(void* block, size_t size, size_t align) noexcept;
+    }
+
+    // Standard allocator over the recycled blocks. Containers that grow and shrink with spawn and despawn waves
+    // stop touching the heap once their blocks have been allocated once.
+    template<typename T>
+    struct RecyclingAllocator
+    {
+        using value_type = T;
+
+        RecyclingAllocator() noexcept = default;
+
+        template<typename U>
+        RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {}
+
+        T* allocate(size_t count) { return static_cast<T*>(Detail::AllocateRecycled(count * sizeof(T), alignof(T))); }
+        void deallocate(T* block, size_t count) noexcept { Detail::FreeRecycled(block, count * sizeof(T), alignof(T)); }
+
+        template<typename U>
+        bool operator==(const RecyclingAllocator<U>&) const noexcept { return true; }
+    };
+
+    template<typename Key, typename Value>
+    using RecycledMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>, RecyclingAllocator<std::pair<const Key, Value>>>;
+
+    template<typename T>
+    struct Handle
+    {
+        static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+        uint32_t index = InvalidIndex;
+        uint32_t generation = 0;
+
+        bool IsValid() const noexcept { return index != InvalidIndex; }
+        bool operator==(const Handle&) const = default;
+    };
+
+    // Fixed size slots in chunks that never move, freed slots are reused first. Each slot counts how often it
+    // was freed, a handle only resolves while its generation matches, so stale handles fail with one compare.
+    // Create, Destroy and the last release of a shared object lock only around the free list, never while T is
+    // built or destroyed. Get does not lock, so pools used from several threads should Reserve up front to keep
+    // Create from growing them. The pool must outlive every object and
+    // shared_ptr it handed out.
+    template<typename T, size_t ChunkSize = 256>
+    class ObjectPool
+    {
+    public:
+        ObjectPool() = default;
+
+        ~ObjectPool()
+        {
+            if (m_liveCount != 0)
+                std::cerr << "[ObjectPool] Destroyed with " << m_liveCount << " live objects" << std::endl;
+
+            for (auto& chunk : m_chunks)
+            {
+                for (size_t i = 0; i < ChunkSize; ++i)
+                {
+                    if (chunk[i].alive)
+                        chunk[i].Object()->~T();
+                }
+            }
+        }
+
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+
+        template<typename... Args>
+        Handle<T> Create(Args&&... args)
+        {
+            Slot* slot = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                slot = &AcquireSlot();
+            }
+
+            // Built outside the lock so a constructor may create from this pool too
+            try
+            {
+                ::new (static_cast<void*>(slot->storage)) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ReleaseSlot(*slot);
+                throw;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            slot->alive = true;
+            ++m_liveCount;
+            return Handle<T>{ slot->index, slot->generation };
+        }
+
+        // Frees the slot when the last reference goes away. The control block comes from the recycled blocks,
+        // so after warm up neither allocation reaches the global heap. Pooled nodes still allocate for names
+        // longer than std::string's inline buffer and the first time a component name is interned.
+        template<typename... Args>
+        std::shared_ptr<T> CreateShared(Args&&... args)
+        {
+            const Handle<T> handle = Create(std::forward<Args>(args)...);
+            return std::shared_ptr<T>(Get(handle), SharedDeleter{ this, handle }, RecyclingAllocator<T>());
+        }
+
+        // The handle stops resolving before ~T runs, the slot only goes back on the free list after it returned.
+        // ~T runs outside the lock, so objects may own shared objects from the same pool.
+        bool Destroy(Handle<T> handle)
+        {
+            Slot* slot = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                slot = FindSlot(handle);
+                if (!slot)
+                    return false;
+
+                slot->alive = false;
+                ++slot->generation;
+                --m_liveCount;
+            }
+
+            slot->Object()->~T();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            PushFree(*slot);
+            return true;
+        }
+
+        T* Get(Handle<T> handle) const
+        {
+            Slot* slot = FindSlot(handle);
+            return slot ? slot->Object() : nullptr;
+        }
+
+        bool IsAlive(Handle<T> handle) const { return FindSlot(handle) != nullptr; }
+
+        // Handle of an object that lives in this pool, invalid for any other pointer
+        Handle<T> GetHandle(const T* object) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& chunk : m_chunks)
+            {
+                const Slot* first = chunk.get();
+                const unsigned char* address = reinterpret_cast<const unsigned char*>(object);
+                if (address < reinterpret_cast<const unsigned char*>(first) || address >= reinterpret_cast<const unsigned char*>(first + ChunkSize))
+                    continue;
+
+                const Slot& slot = first[(address - reinterpret_cast<const unsigned char*>(first)) / sizeof(Slot)];
+                if (slot.alive && slot.Object() == object)
+                    return Handle<T>{ slot.index, slot.generation };
+            }
+            return Handle<T>();
+        }
+
+        // Allocates chunks up front so spawning count objects never grows the pool
+        void Reserve(size_t count)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (m_chunks.size() * ChunkSize < count)
+                AddChunk();
+        }
+
+        size_t GetLiveCount() const { return m_liveCount; }
+        size_t GetCapacity() const { return m_chunks.size() * ChunkSize; }
+
+    private:
+        struct Slot
+        {
+            alignas(T) unsigned char storage[sizeof(T)];
+            uint32_t generation = 0;
+            uint32_t index = 0;
+            uint32_t nextFree = Handle<T>::InvalidIndex;
+            bool alive = false;
+
+            T* Object() const { return std::launder(reinterpret_cast<T*>(const_cast<unsigned char*>(storage))); }
+        };
+
+        struct SharedDeleter
+        {
+            ObjectPool* pool;
+            Handle<T> handle;
+
+            void operator()(T*) const { pool->Destroy(handle); }
+        };
+
+        Slot* FindSlot(Handle<T> handle) const
+        {
+            if (handle.index >= m_slotCount.load(std::memory_order_acquire))
+                return nullptr;
+
+            Slot& slot = m_chunks[handle.index / ChunkSize][handle.index % ChunkSize];
+            return slot.alive && slot.generation == handle.generation ? &slot : nullptr;
+        }
+
+        void AddChunk()
+        {
+            const uint32_t base = static_cast<uint32_t>(m_chunks.size() * ChunkSize);
+            m_chunks.push_back(std::make_unique<Slot[]>(ChunkSize));
+
+            Slot* chunk = m_chunks.back().get();
+            for (size_t i = ChunkSize; i-- > 0;)
+            {
+                chunk[i].index = base + static_cast<uint32_t>(i);
+                chunk[i].nextFree = m_freeHead;
+                m_freeHead = chunk[i].index;
+            }
+            m_slotCount.store(base + ChunkSize, std::memory_order_release);
+        }
+
+        Slot& AcquireSlot()
+        {
+            if (m_freeHead == Handle<T>::InvalidIndex)
+                AddChunk();
+
+            Slot& slot = m_chunks[m_freeHead / ChunkSize][m_freeHead % ChunkSize];
+            m_freeHead = slot.nextFree;
+            return slot;
+        }
+
+        void ReleaseSlot(Slot& slot)
+        {
+            ++slot.generation;
+            PushFree(slot);
+        }
+
+        void PushFree(Slot& slot)
+        {
+            slot.nextFree = m_freeHead;
+            m_freeHead = slot.index;
+        }
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<Slot[]>> m_chunks;
+        std::atomic<uint32_t> m_slotCount{ 0 };
+        uint32_t m_freeHead = Handle<T>::InvalidIndex;
+        size_t m_liveCount = 0;
+    };
+}
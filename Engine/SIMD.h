@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BSE_SIMD_SSE 1
+#endif
+
+namespace BSE
+{
+    // Four floats processed together, SSE where available and plain loops elsewhere. Code written against it
+    // handles four independent problems per call, one per lane.
+    struct Float4
+    {
+#if defined(BSE_SIMD_SSE)
+        __m128 v;
+
+        Float4() : v(_mm_setzero_ps()) {}
+        Float4(__m128 value) : v(value) {}
+        explicit Float4(float value) : v(_mm_set1_ps(value)) {}
+
+        static Float4 Load(const float* values) { return Float4(_mm_loadu_ps(values)); }
+        void Store(float* values) const { _mm_storeu_ps(values, v); }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+        friend Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+        friend Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+
+        friend Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+        friend Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+        friend Float4 Abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+
+        // Lane masks, all bits set where the comparison holds
+        friend Float4 operator>(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+        friend Float4 operator<=(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+        friend Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+        friend Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+
+        // Bit i set when lane i of a mask is set
+        int MoveMask() const { return _mm_movemask_ps(v); }
+#else
+        std::array<float, 4> v;
+
+        Float4() : v{ 0.0f, 0.0f, 0.0f, 0.0f } {}
+        explicit Float4(float value) : v{ value, value, value, value } {}
+
+        static Float4 Load(const float* values)
+        {
+            Float4 result;
+            std::copy(values, values + 4, result.v.begin());
+            return result;
+        }
+
+        void Store(float* values) const { std::copy(v.begin(), v.end(), values); }
+
+        template<typename Op>
+        static Float4 Apply(Float4 a, Float4 b, Op op)
+        {
+            Float4 result;
+            for (int i = 0; i < 4; ++i)
+                result.v[i] = op(a.v[i], b.v[i]);
+            return result;
+        }
+
+        static float MaskValue(bool set)
+        {
+            const uint32_t bits = set ? 0xFFFFFFFFu : 0u;
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        static bool MaskBit(float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits != 0;
+        }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return x + y; }); }
+        friend Float4 operator-(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return x - y; }); }
+        friend Float4 operator*(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return x * y; }); }
+
+        friend Float4 Min(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return std::min(x, y); }); }
+        friend Float4 Max(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return std::max(x, y); }); }
+        friend Float4 Abs(Float4 a) { return Apply(a, a, [](float x, float) { return std::fabs(x); }); }
+
+        friend Float4 operator>(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return MaskValue(x > y); }); }
+        friend Float4 operator<=(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return MaskValue(x <= y); }); }
+        friend Float4 operator|(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return MaskValue(MaskBit(x) || MaskBit(y)); }); }
+        friend Float4 operator&(Float4 a, Float4 b) { return Apply(a, b, [](float x, float y) { return MaskValue(MaskBit(x) && MaskBit(y)); }); }
+
+        int MoveMask() const
+        {
+            int mask = 0;
+            for (int i = 0; i < 4; ++i)
+                mask |= MaskBit(v[i]) ? 1 << i : 0;
+            return mask;
+        }
+#endif
+    };
+}
@@ -0,0 +1,86 @@
+#include "StringId.h"
+
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace BSE
+{
+    namespace
+    {
+#ifdef NDEBUG
+        // Generated or unique names would otherwise grow the table for as long as the program runs
+        constexpr size_t MaxStrings = 64 * 1024;
+#else
+        constexpr size_t MaxStrings = std::numeric_limits<size_t>::max();
+#endif
+
+        template<typename Value>
+        class StringTable
+        {
+        public:
+            void Intern(Value value, std::string_view text)
+            {
+                {
+                    std::shared_lock<std::shared_mutex> lock(m_mutex);
+                    auto it = m_strings.find(value);
+                    if (it != m_strings.end())
+                    {
+                        if (it->second != text)
+                            ReportCollision(it->second, text);
+                        return;
+                    }
+                }
+
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                if (m_strings.find(value) != m_strings.end())
+                    return;
+
+                if (m_strings.size() >= MaxStrings)
+                {
+                    if (!m_full)
+                        std::cerr << "[StringId] String table is full, new ids are only known by value" << std::endl;
+                    m_full = true;
+                    return;
+                }
+
+                // The deque never moves its elements, so views into it stay valid
+                m_storage.emplace_back(text);
+                m_strings.emplace(value, m_storage.back());
+            }
+
+            std::string_view Lookup(Value value) const
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                auto it = m_strings.find(value);
+                return it == m_strings.end() ? std::string_view() : it->second;
+            }
+
+        private:
+            static void ReportCollision(std::string_view existing, std::string_view text)
+            {
+                std::cerr << "[StringId] Hash collision between \"" << existing << "\" and \"" << text << "\"" << std::endl;
+            }
+
+            mutable std::shared_mutex m_mutex;
+            std::deque<std::string> m_storage;
+            std::unordered_map<Value, std::string_view> m_strings;
+            bool m_full = false;
+        };
+
+        template<typename Value>
+        StringTable<Value>& GetTable()
+        {
+            static StringTable<Value> table;
+            return table;
+        }
+    }
+
+    namespace Detail
+    {
+        void InternString(uint64_t value, std::string_view text) { GetTable<uint64_t>().Intern(value, text); }
+        void InternString(uint32_t value, std::string_view text) { GetTable<uint32_t>().Intern(value, text); }
+        std::string_view LookupString(uint64_t value) { return GetTable<uint64_t>().Lookup(value); }
+        std::string_view LookupString(uint32_t value) { return GetTable<uint32_t>().Lookup(value); }
+    }
+}
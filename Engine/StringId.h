@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Define.h"
+#include "StandardInclude.h"
+#include "Hash.h"
+
+#include <compare>
+
+namespace BSE
+{
+    namespace Detail
+    {
+        // Process wide tables so ids can be turned back into text for logs, tools and saved files. Release
+        // builds stop recording once the table is full.
+        DLL_EXPORT void InternString(uint64_t value, std::string_view text);
+        DLL_EXPORT void InternString(uint32_t value, std::string_view text);
+        DLL_EXPORT std::string_view LookupString(uint64_t value);
+        DLL_EXPORT std::string_view LookupString(uint32_t value);
+    }
+
+    // Hashed name. Comparing and hashing ids is a single integer operation. Building an id from text only
+    // hashes it, Intern also records the text so GetString can find it again. Intern where the text has to
+    // survive, like component names and loaded files, not for lookups.
+    template<typename Value>
+    class BasicStringId
+    {
+    public:
+        static_assert(std::is_same_v<Value, uint32_t> || std::is_same_v<Value, uint64_t>, "StringId is 32 or 64 bits");
+
+        constexpr BasicStringId() noexcept = default;
+
+        constexpr explicit BasicStringId(std::string_view text) noexcept
+            : m_value(Hash(text)) {}
+
+        static BasicStringId Intern(std::string_view text)
+        {
+            const BasicStringId id(text);
+            Detail::InternString(id.m_value, text);
+            return id;
+        }
+
+        static constexpr BasicStringId FromValue(Value value) noexcept
+        {
+            BasicStringId id;
+            id.m_value = value;
+            return id;
+        }
+
+        static constexpr Value Hash(std::string_view text) noexcept
+        {
+            if constexpr (sizeof(Value) == 8)
+                return HashFNV1a64(text);
+            else
+                return HashFNV1a32(text);
+        }
+
+        constexpr Value GetValue() const noexcept { return m_value; }
+        constexpr bool IsValid() const noexcept { return m_value != 0; }
+
+        // Empty when the text was never interned
+        std::string_view GetString() const { return Detail::LookupString(m_value); }
+
+        constexpr bool operator==(const BasicStringId&) const noexcept = default;
+        constexpr auto operator<=>(const BasicStringId&) const noexcept = default;
+
+    private:
+        Value m_value = 0;
+    };
+
+    using StringId = BasicStringId<uint64_t>;
+    using StringId32 = BasicStringId<uint32_t>;
+
+    constexpr StringId operator""_sid(const char* text, size_t length) noexcept
+    {
+        return StringId::FromValue(StringId::Hash(std::string_view(text, length)));
+    }
+
+    constexpr StringId32 operator""_sid32(const char* text, size_t length) noexcept
+    {
+        return StringId32::FromValue(StringId32::Hash(std::string_view(text, length)));
+    }
+}
+
+template<typename Value>
+struct std::hash<BSE::BasicStringId<Value>>
+{
+    size_t operator()(const BSE::BasicStringId<Value>& id) const noexcept { return static_cast<size_t>(id.GetValue()); }
+};
@@ -21,5 +21,6 @@ namespace BSE
     void Time::ConsumeTick()
     {
         m_accumulator -= m_timePerTick;
+        ++m_tickIndex;
     }
 }
\ No newline at end of file
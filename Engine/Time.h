@@ -23,12 +23,19 @@ namespace BSE
         double GetTimePerTick() const { return m_timePerTick; }
 
         double GetAlpha() const { return m_accumulator / m_timePerTick; } // Use for graphical updates
+
+        static constexpr uint64_t InvalidTick = 0xFFFFFFFFFFFFFFFFull;
+
+        // Ticks this Time closed with ConsumeTick so far. Call ConsumeTick after the tick's updates, Interpolated
+        // values written with the current index belong to the tick it closes.
+        uint64_t GetTickIndex() const { return m_tickIndex; }
     
     private:
         double m_tickRate;
         double m_timePerTick;
         double m_accumulator;
         double m_frameTime;
+        uint64_t m_tickIndex = 0;
 
         std::chrono::high_resolution_clock::time_point m_previousTime;
     };
@@ -0,0 +1,145 @@
+#include "ComponentAccess.h"
+#include "Node.h"
+
+#include <mutex>
+
+namespace BSE
+{
+    namespace
+    {
+        constexpr size_t NoUnit = static_cast<size_t>(-1);
+        constexpr size_t SeveralUnits = static_cast<size_t>(-2);
+
+        struct ResourceTouch
+        {
+            size_t writer = NoUnit;
+            size_t reader = NoUnit;
+        };
+
+        struct CurrentUpdate
+        {
+            size_t unit = NoUnit;
+            const Node* node = nullptr;
+            ComponentAccess access;
+        };
+
+        std::atomic<bool> s_enabled{ false };
+        std::atomic<size_t> s_violations{ 0 };
+
+        std::mutex s_mutex;
+        std::unordered_map<StringId, ResourceTouch> s_touches;
+
+        thread_local CurrentUpdate t_current;
+
+        std::string DescribeResource(StringId resource)
+        {
+            const std::string_view text = resource.GetString();
+            if (!text.empty())
+                return std::string(text);
+
+            std::ostringstream ss;
+            ss << "0x" << std::hex << resource.GetValue();
+            return ss.str();
+        }
+
+        void Report(const char* what, StringId resource)
+        {
+            s_violations.fetch_add(1, std::memory_order_relaxed);
+
+            const std::string nodeName = t_current.node ? t_current.node->GetName() : std::string("<unknown>");
+            std::cerr << "[AccessTracker] " << what << " '" << DescribeResource(resource) << "' by a component of node '" << nodeName << "'" << std::endl;
+        }
+
+        bool Tracking()
+        {
+            return s_enabled.load(std::memory_order_relaxed) && t_current.unit != NoUnit;
+        }
+    }
+
+    void AccessTracker::SetEnabled(bool enabled)
+    {
+        s_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool AccessTracker::IsEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    void AccessTracker::NoteRead(StringId resource)
+    {
+        if (!Tracking())
+            return;
+
+        if (!t_current.access.AllowsRead(resource))
+            Report("Undeclared read of", resource);
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        ResourceTouch& touch = s_touches[resource];
+
+        if (touch.writer != NoUnit && touch.writer != t_current.unit)
+            Report("Concurrent read of written resource", resource);
+
+        if (touch.reader == NoUnit)
+            touch.reader = t_current.unit;
+        else if (touch.reader != t_current.unit)
+            touch.reader = SeveralUnits;
+    }
+
+    void AccessTracker::NoteWrite(StringId resource)
+    {
+        if (!Tracking())
+            return;
+
+        if (!t_current.access.AllowsWrite(resource))
+            Report("Undeclared write of", resource);
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        ResourceTouch& touch = s_touches[resource];
+
+        if ((touch.writer != NoUnit && touch.writer != t_current.unit) || (touch.reader != NoUnit && touch.reader != t_current.unit))
+            Report("Concurrent write of shared resource", resource);
+
+        touch.writer = t_current.unit;
+    }
+
+    size_t AccessTracker::GetViolationCount()
+    {
+        return s_violations.load(std::memory_order_relaxed);
+    }
+
+    void AccessTracker::ResetViolationCount()
+    {
+        s_violations.store(0, std::memory_order_relaxed);
+    }
+
+    void AccessTracker::BeginBatch()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_touches.clear();
+    }
+
+    void AccessTracker::EndBatch()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_touches.clear();
+    }
+
+    void AccessTracker::BeginUnit(size_t unit)
+    {
+        t_current.unit = unit;
+        t_current.node = nullptr;
+        t_current.access = ComponentAccess::Serial();
+    }
+
+    void AccessTracker::EndUnit()
+    {
+        t_current = CurrentUpdate();
+    }
+
+    void AccessTracker::SetComponent(const Node* node, const ComponentAccess& access)
+    {
+        t_current.node = node;
+        t_current.access = access;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+#include "../Engine/StringId.h"
+
+namespace BSE
+{
+    class Node;
+
+    // Shared state a component touches during Update, beyond its own node and subtree. Resources are named by
+    // StringId and folded into 64 bit masks, two resources sharing a bit only cost parallelism, never safety.
+    // Serial is the default for components that declare nothing, such trees always run on the updating thread.
+    struct DLL_EXPORT ComponentAccess
+    {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        bool serial = false;
+
+        static constexpr uint64_t Bit(StringId resource) noexcept { return uint64_t(1) << (resource.GetValue() & 63); }
+
+        static ComponentAccess Serial()
+        {
+            ComponentAccess access;
+            access.serial = true;
+            return access;
+        }
+
+        // Only touches its own node
+        static ComponentAccess None() { return ComponentAccess(); }
+
+        ComponentAccess& Read(StringId resource)
+        {
+            reads |= Bit(resource);
+            return *this;
+        }
+
+        ComponentAccess& Write(StringId resource)
+        {
+            writes |= Bit(resource);
+            return *this;
+        }
+
+        void Merge(const ComponentAccess& other)
+        {
+            reads |= other.reads;
+            writes |= other.writes;
+            serial = serial || other.serial;
+        }
+
+        bool ConflictsWith(const ComponentAccess& other) const
+        {
+            if (serial || other.serial)
+                return true;
+
+            return (writes & (other.reads | other.writes)) != 0 || (other.writes & reads) != 0;
+        }
+
+        bool AllowsRead(StringId resource) const { return serial || ((reads | writes) & Bit(resource)) != 0; }
+        bool AllowsWrite(StringId resource) const { return serial || (writes & Bit(resource)) != 0; }
+    };
+
+    // Debug race detector for parallel scene updates. Code guarding shared state reports each access with
+    // NoteRead/NoteWrite, the tracker then flags accesses the running component did not declare and resources
+    // written by one tree while another tree of the same batch reads or writes them. Off by default, reports
+    // go to std::cerr.
+    class DLL_EXPORT AccessTracker
+    {
+    public:
+        static void SetEnabled(bool enabled);
+        static bool IsEnabled();
+
+        static void NoteRead(StringId resource);
+        static void NoteWrite(StringId resource);
+
+        static size_t GetViolationCount();
+        static void ResetViolationCount();
+
+        // Used by Scene and Node while updating, a unit is one top level tree of a batch
+        static void BeginBatch();
+        static void EndBatch();
+        static void BeginUnit(size_t unit);
+        static void EndUnit();
+        static void SetComponent(const Node* node, const ComponentAccess& access);
+    };
+}
@@ -0,0 +1,463 @@
+#include "ComponentCodecs.h"
+#include "SceneSnapshot.h"
+#include "../Renderer/AssimpModelLoader.h"
+
+#include <unordered_map>
+
+namespace BSE
+{
+    namespace
+    {
+        std::string ReadTextFile(const std::string& path)
+        {
+            std::ifstream in(path);
+            if (!in.is_open())
+                return {};
+
+            std::ostringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        }
+
+        // What the default loaders read and decode in the codecs' prepare step, so only uploads are left for load
+        struct PreparedModel
+        {
+            bool meshesLoaded = false;
+            std::vector<MeshData> meshes;
+            // Parsed, its textures are created from images on load
+            std::shared_ptr<Material> material;
+            std::unordered_map<std::string, ImageData> images;
+            std::string vertexSource;
+            std::string fragmentSource;
+        };
+
+        struct PreparedSound
+        {
+            bool loaded = false;
+            SoundData data;
+        };
+
+        struct ModelPaths
+        {
+            std::string model;
+            std::string material;
+            std::string vertexShader;
+            std::string fragmentShader;
+        };
+
+        bool ReadModelPaths(SnapshotReader& reader, ModelPaths& paths)
+        {
+            reader.ReadString(paths.model);
+            reader.ReadString(paths.material);
+            reader.ReadString(paths.vertexShader);
+            return reader.ReadString(paths.fragmentShader);
+        }
+
+        std::shared_ptr<Model> BuildModel(const PreparedModel& prepared, const std::string& path)
+        {
+            auto model = std::make_shared<Model>();
+            if (!prepared.meshesLoaded || !model->LoadFromMeshes(prepared.meshes))
+            {
+                std::cerr << "[ComponentCodecs] Failed to load model: " << path << std::endl;
+                return nullptr;
+            }
+            return model;
+        }
+
+        std::shared_ptr<Material> ParseMaterial(const std::string& path, std::unordered_map<std::string, ImageData>& images)
+        {
+            auto material = std::make_shared<Material>();
+            if (!material->ParseMaterialFile(path))
+            {
+                std::cerr << "[ComponentCodecs] Failed to load material: " << path << std::endl;
+                return nullptr;
+            }
+
+            for (const std::string* texture : { &material->diffusePath, &material->normalPath, &material->roughnessPath,
+                                                 &material->metallicPath, &material->aoPath, &material->emissivePath })
+            {
+                ImageData image;
+                if (!texture->empty() && !images.count(*texture) && Texture2D::LoadImageToMemory(*texture, image))
+                    images.emplace(*texture, std::move(image));
+            }
+            return material;
+        }
+
+        std::shared_ptr<ShaderProgram> BuildShaderProgram(const PreparedModel& prepared, const std::string& vertexPath, const std::string& fragmentPath)
+        {
+            if (prepared.vertexSource.empty() || prepared.fragmentSource.empty())
+            {
+                std::cerr << "[ComponentCodecs] Failed to read shaders: " << vertexPath << ", " << fragmentPath << std::endl;
+                return nullptr;
+            }
+
+            try
+            {
+                Shader vertex(prepared.vertexSource, ShaderType::Vertex);
+                Shader fragment(prepared.fragmentSource, ShaderType::Fragment);
+                return std::make_shared<ShaderProgram>(vertex, fragment);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "[ComponentCodecs] Failed to build shader program from " << vertexPath << ", " << fragmentPath
+                          << ": " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        // Values of the lights and cameras are written field by field so adding a member to the struct does not
+        // silently change the payload layout
+        void RegisterLights()
+        {
+            SceneSnapshot::RegisterComponent<DirectionalLightComponent>("DirectionalLightComponent",
+                [](const DirectionalLightComponent& light, SnapshotWriter& writer) {
+                    writer.Write(light.Direction);
+                    writer.Write(light.Color);
+                    writer.Write(light.Intensity);
+                },
+                [](SnapshotReader& reader) {
+                    auto light = std::make_shared<DirectionalLightComponent>();
+                    reader.Read(light->Direction);
+                    reader.Read(light->Color);
+                    reader.Read(light->Intensity);
+                    return light;
+                });
+
+            SceneSnapshot::RegisterComponent<PointLightComponent>("PointLightComponent",
+                [](const PointLightComponent& light, SnapshotWriter& writer) {
+                    writer.Write(light.Position);
+                    writer.Write(light.Color);
+                    writer.Write(light.Intensity);
+                    writer.Write(light.Radius);
+                },
+                [](SnapshotReader& reader) {
+                    auto light = std::make_shared<PointLightComponent>();
+                    reader.Read(light->Position);
+                    reader.Read(light->Color);
+                    reader.Read(light->Intensity);
+                    reader.Read(light->Radius);
+                    return light;
+                });
+
+            SceneSnapshot::RegisterComponent<SpotLightComponent>("SpotLightComponent",
+                [](const SpotLightComponent& light, SnapshotWriter& writer) {
+                    writer.Write(light.Position);
+                    writer.Write(light.Direction);
+                    writer.Write(light.Color);
+                    writer.Write(light.Intensity);
+                    writer.Write(light.InnerCone);
+                    writer.Write(light.OuterCone);
+                    writer.Write(light.Radius);
+                },
+                [](SnapshotReader& reader) {
+                    auto light = std::make_shared<SpotLightComponent>();
+                    reader.Read(light->Position);
+                    reader.Read(light->Direction);
+                    reader.Read(light->Color);
+                    reader.Read(light->Intensity);
+                    reader.Read(light->InnerCone);
+                    reader.Read(light->OuterCone);
+                    reader.Read(light->Radius);
+                    return light;
+                });
+
+            SceneSnapshot::RegisterComponent<AreaLightComponent>("AreaLightComponent",
+                [](const AreaLightComponent& light, SnapshotWriter& writer) {
+                    writer.Write(light.Position);
+                    writer.Write(light.Direction);
+                    writer.Write(light.Color);
+                    writer.Write(light.Intensity);
+                    writer.Write(light.AreaSize);
+                },
+                [](SnapshotReader& reader) {
+                    auto light = std::make_shared<AreaLightComponent>();
+                    reader.Read(light->Position);
+                    reader.Read(light->Direction);
+                    reader.Read(light->Color);
+                    reader.Read(light->Intensity);
+                    reader.Read(light->AreaSize);
+                    return light;
+                });
+        }
+
+        // Only the inputs are stored, the vectors and matrices are derived from them by Update
+        void RegisterCameras(const Time* time)
+        {
+            SceneSnapshot::RegisterComponent<Camera3DComponent>("Camera3DComponent",
+                [](const Camera3DComponent& camera, SnapshotWriter& writer) {
+                    writer.Write(camera.Position);
+                    writer.Write(camera.Yaw);
+                    writer.Write(camera.Pitch);
+                    writer.Write(camera.FOV);
+                    writer.Write(camera.NearPlane);
+                    writer.Write(camera.FarPlane);
+                    writer.Write(camera.AspectRatio);
+                },
+                [time](SnapshotReader& reader) -> std::shared_ptr<Camera3DComponent> {
+                    auto camera = std::make_shared<Camera3DComponent>();
+                    reader.Read(camera->Position);
+                    reader.Read(camera->Yaw);
+                    reader.Read(camera->Pitch);
+                    reader.Read(camera->FOV);
+                    reader.Read(camera->NearPlane);
+                    reader.Read(camera->FarPlane);
+                    if (!reader.Read(camera->AspectRatio))
+                        return nullptr;
+
+                    camera->Update(0.0);
+                    camera->SnapView();
+                    camera->SetTime(time);
+                    return camera;
+                });
+
+            SceneSnapshot::RegisterComponent<Camera2DComponent>("Camera2DComponent",
+                [](const Camera2DComponent& camera, SnapshotWriter& writer) {
+                    writer.Write(camera.Position);
+                    writer.Write(camera.Up);
+                    writer.Write(camera.Forward);
+                    writer.Write(camera.Left);
+                    writer.Write(camera.Right);
+                    writer.Write(camera.Bottom);
+                    writer.Write(camera.Top);
+                    writer.Write(camera.NearPlane);
+                    writer.Write(camera.FarPlane);
+                },
+                [time](SnapshotReader& reader) -> std::shared_ptr<Camera2DComponent> {
+                    auto camera = std::make_shared<Camera2DComponent>();
+                    reader.Read(camera->Position);
+                    reader.Read(camera->Up);
+                    reader.Read(camera->Forward);
+                    reader.Read(camera->Left);
+                    reader.Read(camera->Right);
+                    reader.Read(camera->Bottom);
+                    reader.Read(camera->Top);
+                    reader.Read(camera->NearPlane);
+                    if (!reader.Read(camera->FarPlane))
+                        return nullptr;
+
+                    camera->Update(0.0);
+                    camera->SnapView();
+                    camera->SetTime(time);
+                    return camera;
+                });
+        }
+
+        // The activator's host model belongs to another component and is not stored, reattach it after loading
+        void RegisterTriggers(TriggerSystem* triggerSystem)
+        {
+            SceneSnapshot::RegisterComponent<TriggerBoxComponent>("TriggerBoxComponent",
+                [](const TriggerBoxComponent& trigger, SnapshotWriter& writer) {
+                    writer.Write(trigger.position);
+                    writer.Write(trigger.scale);
+                    writer.Write(trigger.rotation);
+                },
+                [triggerSystem](SnapshotReader& reader) -> std::shared_ptr<TriggerBoxComponent> {
+                    auto trigger = std::make_shared<TriggerBoxComponent>();
+                    reader.Read(trigger->position);
+                    reader.Read(trigger->scale);
+                    if (!reader.Read(trigger->rotation))
+                        return nullptr;
+
+                    if (triggerSystem)
+                        trigger->RegisterWith(*triggerSystem);
+                    return trigger;
+                });
+
+            SceneSnapshot::RegisterComponent<TriggerSphereComponent>("TriggerSphereComponent",
+                [](const TriggerSphereComponent& trigger, SnapshotWriter& writer) {
+                    writer.Write(trigger.position);
+                    writer.Write(trigger.radius);
+                },
+                [triggerSystem](SnapshotReader& reader) -> std::shared_ptr<TriggerSphereComponent> {
+                    auto trigger = std::make_shared<TriggerSphereComponent>();
+                    reader.Read(trigger->position);
+                    if (!reader.Read(trigger->radius))
+                        return nullptr;
+
+                    if (triggerSystem)
+                        trigger->RegisterWith(*triggerSystem);
+                    return trigger;
+                });
+
+            SceneSnapshot::RegisterComponent<TriggerActivatorComponent>("TriggerActivatorComponent",
+                [](const TriggerActivatorComponent& activator, SnapshotWriter& writer) {
+                    writer.Write(activator.position);
+                    writer.Write(activator.scale);
+                    writer.Write(activator.rotation);
+                },
+                [triggerSystem](SnapshotReader& reader) -> std::shared_ptr<TriggerActivatorComponent> {
+                    auto activator = std::make_shared<TriggerActivatorComponent>();
+                    reader.Read(activator->position);
+                    reader.Read(activator->scale);
+                    if (!reader.Read(activator->rotation))
+                        return nullptr;
+
+                    if (triggerSystem)
+                        activator->RegisterWith(*triggerSystem);
+                    return activator;
+                });
+        }
+    }
+
+    void RegisterBuiltinComponentCodecs(const BuiltinComponentContext& context)
+    {
+        // Parts without a custom loader are read and decoded in prepare, custom loaders run in load
+        const bool decodeModel = !context.loadModel;
+        const bool decodeMaterial = !context.loadMaterial;
+        const bool decodeShader = !context.loadShader;
+        const bool decodeSound = !context.loadSound;
+
+        // Assets that fail to load leave the component in place without them, it skips rendering until they are set
+        SceneSnapshot::RegisterComponent<ModelComponent, PreparedModel>("ModelComponent",
+            [](const ModelComponent& component, SnapshotWriter& writer) {
+                writer.WriteString(component.modelPath);
+                writer.WriteString(component.materialPath);
+                writer.WriteString(component.vertexShaderPath);
+                writer.WriteString(component.fragmentShaderPath);
+
+                const bool hasModel = component.model != nullptr;
+                writer.Write(static_cast<uint8_t>(hasModel));
+                if (hasModel)
+                {
+                    writer.Write(component.model->GetPosition());
+                    writer.Write(component.model->GetRotation());
+                    writer.Write(component.model->GetScale());
+                }
+            },
+            [decodeModel, decodeMaterial, decodeShader](SnapshotReader& reader) -> std::shared_ptr<PreparedModel> {
+                ModelPaths paths;
+                if (!ReadModelPaths(reader, paths))
+                    return nullptr;
+
+                auto prepared = std::make_shared<PreparedModel>();
+                if (decodeModel && !paths.model.empty())
+                    prepared->meshesLoaded = LoadModelWithAssimp(paths.model, prepared->meshes);
+                if (decodeMaterial && !paths.material.empty())
+                    prepared->material = ParseMaterial(paths.material, prepared->images);
+                if (decodeShader && !paths.vertexShader.empty() && !paths.fragmentShader.empty())
+                {
+                    prepared->vertexSource = ReadTextFile(paths.vertexShader);
+                    prepared->fragmentSource = ReadTextFile(paths.fragmentShader);
+                }
+                return prepared;
+            },
+            [context, decodeModel, decodeMaterial, decodeShader](SnapshotReader& reader, PreparedModel* prepared) -> std::shared_ptr<ModelComponent> {
+                ModelPaths paths;
+                if (!prepared || !ReadModelPaths(reader, paths))
+                    return nullptr;
+
+                auto component = std::make_shared<ModelComponent>();
+                component->modelPath = std::move(paths.model);
+                component->materialPath = std::move(paths.material);
+                component->vertexShaderPath = std::move(paths.vertexShader);
+                component->fragmentShaderPath = std::move(paths.fragmentShader);
+
+                uint8_t hasModel = 0;
+                glm::vec3 position(0.0f);
+                glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+                glm::vec3 scale(1.0f);
+                if (!reader.Read(hasModel))
+                    return nullptr;
+                if (hasModel && (!reader.Read(position) || !reader.Read(rotation) || !reader.Read(scale)))
+                    return nullptr;
+
+                if (!component->modelPath.empty())
+                    component->model = decodeModel ? BuildModel(*prepared, component->modelPath) : context.loadModel(component->modelPath);
+                if (component->model)
+                {
+                    component->model->SetPosition(position);
+                    component->model->SetRotation(rotation);
+                    component->model->SetScale(scale);
+                    component->model->SnapTransform();
+                    component->model->SetTime(context.time);
+                }
+
+                if (component->materialPath.empty())
+                    component->mat = std::make_shared<Material>();
+                else if (!decodeMaterial)
+                    component->mat = context.loadMaterial(component->materialPath);
+                else if ((component->mat = prepared->material))
+                    component->mat->FinalizeTexturesFromImageData(prepared->images);
+
+                if (!component->vertexShaderPath.empty() && !component->fragmentShaderPath.empty())
+                {
+                    component->shaProg = decodeShader ? BuildShaderProgram(*prepared, component->vertexShaderPath, component->fragmentShaderPath)
+                                                      : context.loadShader(component->vertexShaderPath, component->fragmentShaderPath);
+                }
+
+                component->renderer = context.renderer;
+                return component;
+            });
+
+        SceneSnapshot::RegisterComponent<SoundComponent, PreparedSound>("SoundComponent",
+            [](const SoundComponent& component, SnapshotWriter& writer) {
+                writer.Write(component.SoundID);
+                writer.WriteString(component.soundPath);
+                writer.Write(static_cast<uint8_t>(component.loop));
+                writer.Write(component.gain);
+                writer.Write(component.pitch);
+                writer.Write(component.position);
+                writer.Write(component.velocity);
+            },
+            [decodeSound](SnapshotReader& reader) -> std::shared_ptr<PreparedSound> {
+                unsigned int soundId = 0;
+                std::string path;
+                reader.Read(soundId);
+                if (!reader.ReadString(path))
+                    return nullptr;
+
+                auto prepared = std::make_shared<PreparedSound>();
+                if (decodeSound && !path.empty())
+                    prepared->loaded = SoundBuffer::LoadSoundToMemory(path, prepared->data);
+                return prepared;
+            },
+            [context, decodeSound](SnapshotReader& reader, PreparedSound* prepared) -> std::shared_ptr<SoundComponent> {
+                auto component = std::make_shared<SoundComponent>();
+                uint8_t loop = 0;
+                float gain = 1.0f;
+                float pitch = 1.0f;
+                glm::vec3 position(0.0f);
+                glm::vec3 velocity(0.0f);
+
+                reader.Read(component->SoundID);
+                reader.ReadString(component->soundPath);
+                reader.Read(loop);
+                reader.Read(gain);
+                reader.Read(pitch);
+                reader.Read(position);
+                if (!prepared || !reader.Read(velocity))
+                    return nullptr;
+
+                std::shared_ptr<SoundBuffer> buffer;
+                if (!component->soundPath.empty() && !decodeSound)
+                    buffer = context.loadSound(component->soundPath);
+                else if (prepared->loaded)
+                {
+                    buffer = std::make_shared<SoundBuffer>();
+                    buffer->SetData(prepared->data);
+                }
+
+                component->SetSoundData(std::move(buffer), std::make_shared<SoundSource>());
+                component->SetSoundProperties(loop != 0, gain, pitch, position, velocity);
+                return component;
+            });
+
+        RegisterLights();
+        RegisterCameras(context.time);
+        RegisterTriggers(context.triggerSystem);
+
+        if (ScriptSystem* scriptSystem = context.scriptSystem)
+        {
+            SceneSnapshot::RegisterComponent<ScriptComponent>("ScriptComponent",
+                [](const ScriptComponent& component, SnapshotWriter& writer) {
+                    writer.WriteString(component.scriptPath);
+                },
+                [scriptSystem](SnapshotReader& reader) -> std::shared_ptr<ScriptComponent> {
+                    std::string path;
+                    if (!reader.ReadString(path))
+                        return nullptr;
+                    return std::make_shared<ScriptComponent>(*scriptSystem, std::move(path));
+                });
+        }
+    }
+}
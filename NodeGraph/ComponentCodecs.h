@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include "Components.h"
+
+namespace BSE
+{
+    // What the built-in components need to come back from a snapshot but cannot keep in their payload. Assets
+    // are stored by path and rebuilt through the loaders. Models carry their own transform and must not be shared,
+    // materials, shaders and sounds may come from a cache. Loaders run on the thread building the nodes, which
+    // has to own the GL and AL contexts. Without a loader the file is read each time and decoded in the codec's
+    // prepare step, see StagedSnapshot, leaving only the upload to the building thread.
+    struct DLL_EXPORT BuiltinComponentContext
+    {
+        std::function<std::shared_ptr<Model>(const std::string& path)> loadModel;
+        std::function<std::shared_ptr<Material>(const std::string& path)> loadMaterial;
+        std::function<std::shared_ptr<ShaderProgram>(const std::string& vertexPath, const std::string& fragmentPath)> loadShader;
+        std::function<std::shared_ptr<SoundBuffer>(const std::string& path)> loadSound;
+
+        // Given to loaded ModelComponents, the view projection still comes from SetExtras
+        ModelRenderer* renderer = nullptr;
+        // Loaded models and cameras blend over its ticks when set
+        const Time* time = nullptr;
+        // Loaded trigger components register with it when set
+        TriggerSystem* triggerSystem = nullptr;
+        // ScriptComponent only gets a codec with one, without it script components are skipped like any
+        // type without a codec. The script's Lua state is not saved, the instance starts over on InitScene.
+        ScriptSystem* scriptSystem = nullptr;
+    };
+
+    // Registers SceneSnapshot codecs for ModelComponent, the cameras, lights, trigger components, SoundComponent
+    // and ScriptComponent. Calling it again replaces the codecs with ones using the new context, except that a
+    // script codec from an earlier call stays when the new context has no script system.
+    DLL_EXPORT void RegisterBuiltinComponentCodecs(const BuiltinComponentContext& context = BuiltinComponentContext());
+}
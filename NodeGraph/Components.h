@@ -7,10 +7,16 @@
 
 #include "../Sound/Sound.h"
 
+#include "../Scripting/ScriptSystem.h"
+
 #include "Node.h"
+#include "TriggerSystem.h"
 
 namespace BSE
 {
+    struct Camera3DComponent;
+    struct Camera2DComponent;
+
     struct ModelComponent : Component
     {
         virtual ~ModelComponent() {}
@@ -22,38 +28,66 @@ namespace BSE
         std::shared_ptr<Material> mat;
         std::shared_ptr<ShaderProgram> shaProg;
 
+        // Where the assets came from, what scene snapshots store in place of them. Empty for assets built in code.
+        std::string modelPath;
+        std::string materialPath;
+        std::string vertexShaderPath;
+        std::string fragmentShaderPath;
+
         void SetModelData(std::shared_ptr<Model> model, std::shared_ptr<Material> mat, std::shared_ptr<ShaderProgram> shaProg)
         {
             this->model = model;
             this->mat = mat;
             this->shaProg = shaProg;
+            MarkModified();
         }
 
-        ModelRenderer* renderer;
-        glm::mat4 viewProjMatrix;
+        void SetAssetPaths(const std::string& model, const std::string& material, const std::string& vertexShader, const std::string& fragmentShader)
+        {
+            modelPath = model;
+            materialPath = material;
+            vertexShaderPath = vertexShader;
+            fragmentShaderPath = fragmentShader;
+            MarkModified();
+        }
+
+        ModelRenderer* renderer = nullptr;
+        glm::mat4 viewProjMatrix = glm::mat4(1.0f);
+        // Set by the camera overloads of SetExtras, used in place of viewProjMatrix
+        const Camera3DComponent* camera3D = nullptr;
+        const Camera2DComponent* camera2D = nullptr;
 
         void SetExtras(ModelRenderer& renderer, glm::mat4 viewProjMatrix)
         {
             this->renderer = &renderer;
             this->viewProjMatrix = viewProjMatrix;
+            this->camera3D = nullptr;
+            this->camera2D = nullptr;
         }
 
-        virtual void Update(double Tick) override
+        // Draws with the camera's view blended by the render alpha, so the model and the view move together.
+        // The camera must outlive the component or be replaced by another SetExtras.
+        void SetExtras(ModelRenderer& renderer, const Camera3DComponent& camera)
         {
-            this->model->UpdateRenderTransforms();
+            this->renderer = &renderer;
+            this->camera3D = &camera;
+            this->camera2D = nullptr;
         }
 
-        virtual void Render(double Alpha) override
+        void SetExtras(ModelRenderer& renderer, const Camera2DComponent& camera)
         {
-            this->shaProg->Bind();
-            this->mat->Bind(this->shaProg->GetID());
-            if (Lighting::ShaderUsesLighting(this->shaProg->GetID()))
-            {
-                Lighting::Apply(this->shaProg->GetID());
-            }
-            this->model->Render(*this->renderer, this->viewProjMatrix, this->shaProg->GetID());
-            this->shaProg->Unbind();
+            this->renderer = &renderer;
+            this->camera3D = nullptr;
+            this->camera2D = &camera;
         }
+
+        virtual void Update(double Tick) override
+        {
+            if (this->model)
+                this->model->UpdateRenderTransforms();
+        }
+
+        virtual void Render(double Alpha) override;
     };
     
     struct DirectionalLightComponent : Component
@@ -164,13 +198,47 @@ namespace BSE
             UpdateViewMatrix();
             UpdateProjectionMatrix();
             ViewProjMatrix = ProjectionMatrix * ViewMatrix;
+
+            const uint64_t tick = GetTick();
+            renderPosition.Set(Position, tick);
+            renderForward.Set(Forward, tick);
+            renderUp.Set(Up, tick);
         }
 
         glm::mat4 GetViewMatrix() const       { return ViewMatrix; }
         glm::mat4 GetProjectionMatrix() const { return ProjectionMatrix; }
         glm::mat4 GetViewProjMatrix() const   { return ViewProjMatrix; }
 
+        // Time whose ticks the view is blended over, without one the alpha overloads return the latest view
+        void SetTime(const Time* time) { this->time = time; }
+
+        // Between the last two ticks by GetAlpha() of the camera's Time, what models rendered with an alpha should
+        // be drawn with
+        glm::mat4 GetViewMatrix(double Alpha) const
+        {
+            const uint64_t tick = GetTick();
+            const glm::vec3 position = renderPosition.Sample(Alpha, tick);
+            return glm::lookAt(position, position + glm::normalize(renderForward.Sample(Alpha, tick)), glm::normalize(renderUp.Sample(Alpha, tick)));
+        }
+
+        glm::mat4 GetViewProjMatrix(double Alpha) const { return ProjectionMatrix * GetViewMatrix(Alpha); }
+
+        // Drops the blend from the previous tick, for cuts and teleports
+        void SnapView()
+        {
+            renderPosition.Snap(Position);
+            renderForward.Snap(Forward);
+            renderUp.Snap(Up);
+        }
+
     private:
+        const Time* time = nullptr;
+        Interpolated<glm::vec3> renderPosition{ glm::vec3(0.0f) };
+        Interpolated<glm::vec3> renderForward{ glm::vec3(0.0f, 0.0f, -1.0f) };
+        Interpolated<glm::vec3> renderUp{ glm::vec3(0.0f, 1.0f, 0.0f) };
+
+        uint64_t GetTick() const { return time ? time->GetTickIndex() : Time::InvalidTick; }
+
         void UpdateCameraVectors()
         {
             glm::vec3 front;
@@ -217,13 +285,34 @@ namespace BSE
             UpdateViewMatrix();
             UpdateProjectionMatrix();
             ViewProjMatrix = ProjectionMatrix * ViewMatrix;
+
+            renderPosition.Set(Position, GetTick());
         }
 
         glm::mat4 GetViewMatrix() const       { return ViewMatrix; }
         glm::mat4 GetProjectionMatrix() const { return ProjectionMatrix; }
         glm::mat4 GetViewProjMatrix() const   { return ViewProjMatrix; }
 
+        // Time whose ticks the view is blended over, without one the alpha overloads return the latest view
+        void SetTime(const Time* time) { this->time = time; }
+
+        // Between the last two ticks by GetAlpha() of the camera's Time
+        glm::mat4 GetViewMatrix(double Alpha) const
+        {
+            const glm::vec3 position = renderPosition.Sample(Alpha, GetTick());
+            return glm::lookAt(position, position + Forward, Up);
+        }
+
+        glm::mat4 GetViewProjMatrix(double Alpha) const { return ProjectionMatrix * GetViewMatrix(Alpha); }
+
+        void SnapView() { renderPosition.Snap(Position); }
+
     private:
+        const Time* time = nullptr;
+        Interpolated<glm::vec3> renderPosition{ glm::vec3(0.0f) };
+
+        uint64_t GetTick() const { return time ? time->GetTickIndex() : Time::InvalidTick; }
+
         void UpdateViewMatrix()
         {
             ViewMatrix = glm::lookAt(Position, Position + Forward, Up);
@@ -235,10 +324,42 @@ namespace BSE
         }
     };
 
+    inline void ModelComponent::Render(double Alpha)
+    {
+        // Loaded from a snapshot whose assets failed to load
+        if (!this->model || !this->mat || !this->shaProg || !this->renderer)
+            return;
+
+        glm::mat4 viewProj = this->viewProjMatrix;
+        if (this->camera3D)
+            viewProj = this->camera3D->GetViewProjMatrix(Alpha);
+        else if (this->camera2D)
+            viewProj = this->camera2D->GetViewProjMatrix(Alpha);
+
+        this->shaProg->Bind();
+        this->mat->Bind(this->shaProg->GetID());
+        if (Lighting::ShaderUsesLighting(this->shaProg->GetID()))
+        {
+            Lighting::Apply(this->shaProg->GetID());
+        }
+        this->model->Render(*this->renderer, viewProj, this->shaProg->GetID(), Alpha);
+        this->shaProg->Unbind();
+    }
+
     struct SoundComponent : Component
     {
         unsigned int SoundID = 0;
 
+        // The buffer's file, what scene snapshots store in place of it
+        std::string soundPath;
+
+        // Last values given to SetSoundProperties
+        bool loop = false;
+        float gain = 1.0f;
+        float pitch = 1.0f;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 velocity = glm::vec3(0.0f);
+
         void SetSoundData(std::shared_ptr<SoundBuffer> buffer, std::shared_ptr<SoundSource> source)
         {
             this->buffer = buffer;
@@ -248,10 +369,18 @@ namespace BSE
             {
                 this->source->AttachBuffer(*this->buffer);
             }
+            MarkModified();
         }
 
         void SetSoundProperties(bool loop, float gain, float pitch, const glm::vec3& position, const glm::vec3& velocity)
         {
+            this->loop = loop;
+            this->gain = gain;
+            this->pitch = pitch;
+            this->position = position;
+            this->velocity = velocity;
+            MarkModified();
+
             if (source)
             {
                 source->SetLooping(loop);
@@ -307,14 +436,16 @@ namespace BSE
         void SetScale(float s)
         {
             scale = s;
+            MarkModified();
         }
 
         void SyncWithHostModel()
         {
-            if (hostModel)
+            if (hostModel && (position != hostModel->GetPosition() || rotation != hostModel->GetRotation()))
             {
                 position = hostModel->GetPosition();
                 rotation = hostModel->GetRotation();
+                MarkModified();
             }
         }
 
@@ -335,10 +466,35 @@ namespace BSE
             return vertices;
         }
 
+        // Keeps the activator in system from now on, events carry this component as user data
+        void RegisterWith(TriggerSystem& system)
+        {
+            Unregister();
+            triggerSystem = &system;
+            activatorId = system.AddActivator(position, glm::vec3(scale * 0.5f), rotation, this);
+        }
+
+        void Unregister()
+        {
+            if (triggerSystem)
+                triggerSystem->RemoveActivator(activatorId);
+
+            triggerSystem = nullptr;
+            activatorId = TriggerSystem::InvalidId;
+        }
+
+        virtual ~TriggerActivatorComponent() { Unregister(); }
+
         virtual void Update(double Tick) override
         {
             SyncWithHostModel();
+
+            if (triggerSystem)
+                triggerSystem->SetActivator(activatorId, position, glm::vec3(scale * 0.5f), rotation);
         }
+
+        TriggerSystem* triggerSystem = nullptr;
+        uint32_t activatorId = TriggerSystem::InvalidId;
     };
 
     struct TriggerBoxComponent : Component
@@ -350,16 +506,19 @@ namespace BSE
         void SetPosition(const glm::vec3& pos)
         {
             position = pos;
+            MarkModified();
         }
 
         void SetScale(float s)
         {
             scale = s;
+            MarkModified();
         }
 
         void SetRotation(const glm::quat& rot)
         {
             rotation = rot;
+            MarkModified();
         }
 
         std::array<glm::vec3, 8> GetAABBVertices() const
@@ -379,6 +538,35 @@ namespace BSE
             return vertices;
         }
 
+        // Keeps the box in system from now on, events carry this component as user data
+        void RegisterWith(TriggerSystem& system)
+        {
+            Unregister();
+            triggerSystem = &system;
+            triggerId = system.AddBoxTrigger(position, glm::vec3(scale * 0.5f), rotation, this);
+        }
+
+        void Unregister()
+        {
+            if (triggerSystem)
+                triggerSystem->RemoveTrigger(triggerId);
+
+            triggerSystem = nullptr;
+            triggerId = TriggerSystem::InvalidId;
+        }
+
+        virtual ~TriggerBoxComponent() { Unregister(); }
+
+        virtual void Update(double Tick) override
+        {
+            if (triggerSystem)
+                triggerSystem->SetBoxTrigger(triggerId, position, glm::vec3(scale * 0.5f), rotation);
+        }
+
+        TriggerSystem* triggerSystem = nullptr;
+        uint32_t triggerId = TriggerSystem::InvalidId;
+
+        // Pairwise test, TriggerSystem handles many triggers at once and reports enter/stay/exit
         bool CheckIfOverlaps(const TriggerActivatorComponent& activator) const
         {
             auto boxVertices = GetAABBVertices();
@@ -414,13 +602,44 @@ namespace BSE
         void SetPosition(const glm::vec3& pos)
         {
             position = pos;
+            MarkModified();
         }
 
         void SetRadius(float r)
         {
             radius = r;
+            MarkModified();
+        }
+
+        // Keeps the sphere in system from now on, events carry this component as user data
+        void RegisterWith(TriggerSystem& system)
+        {
+            Unregister();
+            triggerSystem = &system;
+            triggerId = system.AddSphereTrigger(position, radius, this);
+        }
+
+        void Unregister()
+        {
+            if (triggerSystem)
+                triggerSystem->RemoveTrigger(triggerId);
+
+            triggerSystem = nullptr;
+            triggerId = TriggerSystem::InvalidId;
+        }
+
+        virtual ~TriggerSphereComponent() { Unregister(); }
+
+        virtual void Update(double Tick) override
+        {
+            if (triggerSystem)
+                triggerSystem->SetSphereTrigger(triggerId, position, radius);
         }
 
+        TriggerSystem* triggerSystem = nullptr;
+        uint32_t triggerId = TriggerSystem::InvalidId;
+
+        // Pairwise test, TriggerSystem handles many triggers at once and reports enter/stay/exit
         bool CheckIfOverlaps(const TriggerActivatorComponent& activator) const
         {
             auto activatorVertices = activator.GetAABBVertices();
@@ -439,4 +658,43 @@ namespace BSE
             return closestDistSq <= (radius * radius);
         }
     };
+
+    // Runs a Lua script on the node, see ScriptSystem for what a script looks like. Updates are batched by
+    // ScriptSystem::Update, the node's own update leaves the component alone.
+    struct ScriptComponent : Component
+    {
+        ScriptComponent(ScriptSystem& system, std::string path)
+            : scriptSystem(&system)
+            , scriptPath(std::move(path)) {}
+
+        virtual ~ScriptComponent() { Unregister(); }
+
+        virtual void InitComponent() override
+        {
+            if (!scriptSystem || handle != ScriptSystem::InvalidHandle)
+                return;
+
+            const uint32_t script = scriptSystem->LoadScript(scriptPath);
+            if (script != ScriptSystem::InvalidScript)
+                handle = scriptSystem->AddInstance(script, *this);
+        }
+
+        virtual void DeleteComponentData() override { Unregister(); }
+
+        virtual ComponentAccess GetAccess() const override { return ComponentAccess::None(); }
+
+        void Unregister()
+        {
+            if (scriptSystem && handle != ScriptSystem::InvalidHandle)
+                scriptSystem->RemoveInstance(handle);
+            handle = ScriptSystem::InvalidHandle;
+        }
+
+        // False before InitComponent and after the script raised an error
+        bool IsRunning() const { return scriptSystem && scriptSystem->IsRunning(handle); }
+
+        ScriptSystem* scriptSystem = nullptr;
+        std::string scriptPath;
+        uint32_t handle = ScriptSystem::InvalidHandle;
+    };
 }
@@ -0,0 +1,350 @@
+#include "EntityStore.h"
+
+namespace BSE
+{
+    namespace
+    {
+        size_t AlignUp(size_t value, size_t align)
+        {
+            return (value + align - 1) & ~(align - 1);
+        }
+    }
+
+    Archetype::Archetype(std::vector<const ComponentTypeInfo*> types)
+        : m_types(std::move(types))
+    {
+        size_t rowBytes = sizeof(Entity);
+        size_t padding = 0;
+        for (const ComponentTypeInfo* type : m_types)
+        {
+            rowBytes += type->size;
+            padding += type->align;
+        }
+
+        m_capacity = std::max<size_t>(1, (ChunkBytes - std::min(ChunkBytes, padding)) / rowBytes);
+
+        // Entity ids first, then one array per type
+        size_t offset = m_capacity * sizeof(Entity);
+        m_offsets.reserve(m_types.size());
+        for (const ComponentTypeInfo* type : m_types)
+        {
+            if (type->align > ChunkAlign)
+                throw std::runtime_error("Archetype - entity data may not be aligned to more than 64 bytes");
+
+            offset = AlignUp(offset, type->align);
+            m_offsets.push_back(offset);
+            offset += m_capacity * type->size;
+        }
+        m_chunkBytes = std::max<size_t>(offset, 1);
+    }
+
+    size_t Archetype::GetEntityCount() const
+    {
+        if (m_chunks.empty())
+            return 0;
+
+        // Every chunk but the last one is full
+        return (m_chunks.size() - 1) * m_capacity + m_chunks.back().count;
+    }
+
+    int Archetype::FindColumn(TypeId id) const
+    {
+        auto it = std::lower_bound(m_types.begin(), m_types.end(), id, [](const ComponentTypeInfo* type, TypeId value) {
+            return type->id < value;
+        });
+
+        if (it == m_types.end() || (*it)->id != id)
+            return -1;
+        return static_cast<int>(it - m_types.begin());
+    }
+
+    bool Archetype::HasAll(const TypeId* ids, size_t count) const
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (FindColumn(ids[i]) < 0)
+                return false;
+        }
+        return true;
+    }
+
+    EntityStore::EntityStore()
+    {
+        m_emptyArchetype = GetOrCreateArchetype({});
+    }
+
+    EntityStore::~EntityStore()
+    {
+        for (const std::unique_ptr<Archetype>& archetype : m_archetypes)
+        {
+            for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+            {
+                for (size_t column = 0; column < archetype->m_types.size(); ++column)
+                {
+                    for (size_t row = 0; row < archetype->GetCount(chunk); ++row)
+                        archetype->m_types[column]->destroy(archetype->GetValue(chunk, column, row));
+                }
+            }
+        }
+    }
+
+    EntityStore& EntityStore::GetDefault()
+    {
+        static EntityStore store;
+        return store;
+    }
+
+    Entity EntityStore::Create()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        uint32_t index = m_freeRecord;
+        if (index != Entity::InvalidIndex)
+        {
+            m_freeRecord = m_records[index].nextFree;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_records.size());
+            m_records.emplace_back();
+        }
+
+        EntityRecord& record = m_records[index];
+        record.archetype = m_emptyArchetype;
+        record.nextFree = Entity::InvalidIndex;
+
+        const Entity entity{ index, record.generation };
+        AllocateRow(*m_emptyArchetype, entity, record.chunk, record.row);
+
+        ++m_aliveCount;
+        return entity;
+    }
+
+    void EntityStore::Destroy(Entity entity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        EntityRecord* record = FindRecord(entity);
+        if (!record)
+            return;
+
+        ReleaseRow(*record->archetype, record->chunk, record->row, true);
+
+        record->archetype = nullptr;
+        ++record->generation;
+        record->nextFree = m_freeRecord;
+        m_freeRecord = entity.index;
+
+        --m_aliveCount;
+    }
+
+    bool EntityStore::IsAlive(Entity entity) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return const_cast<EntityStore*>(this)->FindRecord(entity) != nullptr;
+    }
+
+    EntityStore::EntityRecord* EntityStore::FindRecord(Entity entity)
+    {
+        if (entity.index >= m_records.size())
+            return nullptr;
+
+        EntityRecord& record = m_records[entity.index];
+        return record.archetype != nullptr && record.generation == entity.generation ? &record : nullptr;
+    }
+
+    void* EntityStore::FindValue(Entity entity, TypeId id)
+    {
+        EntityRecord* record = FindRecord(entity);
+        if (!record)
+            return nullptr;
+
+        const int column = record->archetype->FindColumn(id);
+        if (column < 0)
+            return nullptr;
+
+        return record->archetype->GetValue(record->chunk, static_cast<size_t>(column), record->row);
+    }
+
+    void* EntityStore::AddRaw(Entity entity, const ComponentTypeInfo& type)
+    {
+        EntityRecord* record = FindRecord(entity);
+        if (!record)
+            throw std::runtime_error("EntityStore::Add - entity is not alive");
+
+        Archetype* target = GetAddTarget(*record->archetype, type);
+        MoveEntity(*record, *target);
+
+        return target->GetValue(record->chunk, static_cast<size_t>(target->FindColumn(type.id)), record->row);
+    }
+
+    bool EntityStore::RemoveRaw(Entity entity, TypeId id)
+    {
+        EntityRecord* record = FindRecord(entity);
+        if (!record || record->archetype->FindColumn(id) < 0)
+            return false;
+
+        MoveEntity(*record, *GetRemoveTarget(*record->archetype, id));
+        return true;
+    }
+
+    void* EntityStore::GetRaw(Entity entity, TypeId id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return FindValue(entity, id);
+    }
+
+    void EntityStore::ReleaseSpareChunks()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const std::unique_ptr<Archetype>& archetype : m_archetypes)
+        {
+            archetype->m_spareChunks.clear();
+            archetype->m_spareChunks.shrink_to_fit();
+        }
+    }
+
+    Archetype* EntityStore::GetOrCreateArchetype(std::vector<const ComponentTypeInfo*> types)
+    {
+        std::sort(types.begin(), types.end(), [](const ComponentTypeInfo* a, const ComponentTypeInfo* b) {
+            return a->id < b->id;
+        });
+
+        std::vector<TypeId> key;
+        key.reserve(types.size());
+        for (const ComponentTypeInfo* type : types)
+            key.push_back(type->id);
+
+        auto it = m_archetypeIndex.find(key);
+        if (it != m_archetypeIndex.end())
+            return it->second;
+
+        m_archetypes.push_back(std::make_unique<Archetype>(std::move(types)));
+        Archetype* archetype = m_archetypes.back().get();
+        m_archetypeIndex.emplace(std::move(key), archetype);
+        return archetype;
+    }
+
+    Archetype* EntityStore::GetAddTarget(Archetype& from, const ComponentTypeInfo& type)
+    {
+        auto it = from.m_addEdges.find(type.id);
+        if (it != from.m_addEdges.end())
+            return it->second;
+
+        std::vector<const ComponentTypeInfo*> types = from.m_types;
+        types.push_back(&type);
+
+        Archetype* target = GetOrCreateArchetype(std::move(types));
+        from.m_addEdges.emplace(type.id, target);
+        target->m_removeEdges.emplace(type.id, &from);
+        return target;
+    }
+
+    Archetype* EntityStore::GetRemoveTarget(Archetype& from, TypeId id)
+    {
+        auto it = from.m_removeEdges.find(id);
+        if (it != from.m_removeEdges.end())
+            return it->second;
+
+        std::vector<const ComponentTypeInfo*> types;
+        types.reserve(from.m_types.size());
+        for (const ComponentTypeInfo* type : from.m_types)
+        {
+            if (type->id != id)
+                types.push_back(type);
+        }
+
+        Archetype* target = GetOrCreateArchetype(std::move(types));
+        from.m_removeEdges.emplace(id, target);
+        target->m_addEdges.emplace(id, &from);
+        return target;
+    }
+
+    void EntityStore::AllocateRow(Archetype& archetype, Entity entity, uint32_t& chunk, uint32_t& row)
+    {
+        if (archetype.m_chunks.empty() || archetype.m_chunks.back().count == archetype.m_capacity)
+        {
+            if (!archetype.m_spareChunks.empty())
+            {
+                archetype.m_chunks.push_back(std::move(archetype.m_spareChunks.back()));
+                archetype.m_spareChunks.pop_back();
+            }
+            else
+            {
+                Archetype::Chunk fresh;
+                fresh.data.reset(static_cast<unsigned char*>(::operator new(archetype.m_chunkBytes, std::align_val_t(Archetype::ChunkAlign))));
+                archetype.m_chunks.push_back(std::move(fresh));
+            }
+        }
+
+        chunk = static_cast<uint32_t>(archetype.m_chunks.size() - 1);
+        row = static_cast<uint32_t>(archetype.m_chunks.back().count++);
+        archetype.GetEntities(chunk)[row] = entity;
+    }
+
+    void EntityStore::ReleaseRow(Archetype& archetype, uint32_t chunk, uint32_t row, bool destroyValues)
+    {
+        if (destroyValues)
+        {
+            for (size_t column = 0; column < archetype.m_types.size(); ++column)
+                archetype.m_types[column]->destroy(archetype.GetValue(chunk, column, row));
+        }
+
+        const uint32_t lastChunk = static_cast<uint32_t>(archetype.m_chunks.size() - 1);
+        const uint32_t lastRow = static_cast<uint32_t>(archetype.m_chunks.back().count - 1);
+
+        // Keep chunks dense by moving the very last row into the hole
+        if (chunk != lastChunk || row != lastRow)
+        {
+            for (size_t column = 0; column < archetype.m_types.size(); ++column)
+                archetype.m_types[column]->relocate(archetype.GetValue(chunk, column, row), archetype.GetValue(lastChunk, column, lastRow));
+
+            const Entity moved = archetype.GetEntities(lastChunk)[lastRow];
+            archetype.GetEntities(chunk)[row] = moved;
+
+            EntityRecord& movedRecord = m_records[moved.index];
+            movedRecord.chunk = chunk;
+            movedRecord.row = row;
+        }
+
+        if (--archetype.m_chunks.back().count == 0)
+        {
+            archetype.m_spareChunks.push_back(std::move(archetype.m_chunks.back()));
+            archetype.m_chunks.pop_back();
+        }
+    }
+
+    void EntityStore::MoveEntity(EntityRecord& record, Archetype& target)
+    {
+        Archetype& source = *record.archetype;
+        if (&source == &target)
+            return;
+
+        const uint32_t sourceChunk = record.chunk;
+        const uint32_t sourceRow = record.row;
+        const Entity entity = source.GetEntities(sourceChunk)[sourceRow];
+
+        uint32_t targetChunk;
+        uint32_t targetRow;
+        AllocateRow(target, entity, targetChunk, targetRow);
+
+        // Shared types move over, types the target lacks are destroyed, new types stay uninitialized
+        for (size_t column = 0; column < source.m_types.size(); ++column)
+        {
+            const ComponentTypeInfo* type = source.m_types[column];
+            void* value = source.GetValue(sourceChunk, column, sourceRow);
+
+            const int targetColumn = target.FindColumn(type->id);
+            if (targetColumn >= 0)
+                type->relocate(target.GetValue(targetChunk, static_cast<size_t>(targetColumn), targetRow), value);
+            else
+                type->destroy(value);
+        }
+
+        ReleaseRow(source, sourceChunk, sourceRow, false);
+
+        record.archetype = &target;
+        record.chunk = targetChunk;
+        record.row = targetRow;
+    }
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include "../Threading/ThreadingSystem.h"
+
+#include "TypeId.h"
+
+#include <map>
+#include <new>
+
+namespace BSE
+{
+    struct DLL_EXPORT Entity
+    {
+        static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+        uint32_t index = InvalidIndex;
+        uint32_t generation = 0;
+
+        bool IsValid() const noexcept { return index != InvalidIndex; }
+        bool operator==(const Entity&) const = default;
+    };
+
+    // Type erased operations on one component type, columns only ever move and destroy their values
+    struct DLL_EXPORT ComponentTypeInfo
+    {
+        TypeId id = 0;
+        size_t size = 0;
+        size_t align = 0;
+        // Move constructs into raw memory and destroys the source
+        void (*relocate)(void* destination, void* source) = nullptr;
+        void (*destroy)(void* object) = nullptr;
+
+        template<typename T>
+        static const ComponentTypeInfo& Get()
+        {
+            static_assert(std::is_move_constructible_v<T>, "Entity data must be move constructible");
+
+            static const ComponentTypeInfo info{
+                GetTypeId<T>(),
+                sizeof(T),
+                alignof(T),
+                [](void* destination, void* source) {
+                    T* from = std::launder(static_cast<T*>(source));
+                    ::new (destination) T(std::move(*from));
+                    from->~T();
+                },
+                [](void* object) { std::launder(static_cast<T*>(object))->~T(); }
+            };
+            return info;
+        }
+    };
+
+    // Every entity with exactly the same set of data types lives in one archetype. Its rows are packed into
+    // fixed size chunks, each chunk holding one contiguous array per type, so systems walk plain arrays.
+    class DLL_EXPORT Archetype
+    {
+    public:
+        static constexpr size_t ChunkBytes = 16 * 1024;
+        static constexpr size_t ChunkAlign = 64;
+
+        struct ChunkDeleter
+        {
+            void operator()(unsigned char* data) const { ::operator delete(data, std::align_val_t(ChunkAlign)); }
+        };
+
+        struct Chunk
+        {
+            std::unique_ptr<unsigned char[], ChunkDeleter> data;
+            size_t count = 0;
+        };
+
+        explicit Archetype(std::vector<const ComponentTypeInfo*> types);
+
+        const std::vector<const ComponentTypeInfo*>& GetTypes() const { return m_types; }
+        size_t GetChunkCapacity() const { return m_capacity; }
+        size_t GetChunkCount() const { return m_chunks.size(); }
+        size_t GetEntityCount() const;
+
+        // -1 when the archetype has no column of that type
+        int FindColumn(TypeId id) const;
+        bool HasAll(const TypeId* ids, size_t count) const;
+
+        Entity* GetEntities(size_t chunk) { return reinterpret_cast<Entity*>(m_chunks[chunk].data.get()); }
+        size_t GetCount(size_t chunk) const { return m_chunks[chunk].count; }
+
+        void* GetColumn(size_t chunk, size_t column) { return m_chunks[chunk].data.get() + m_offsets[column]; }
+        void* GetValue(size_t chunk, size_t column, size_t row) { return static_cast<unsigned char*>(GetColumn(chunk, column)) + row * m_types[column]->size; }
+
+    private:
+        friend class EntityStore;
+
+        std::vector<const ComponentTypeInfo*> m_types;
+        std::vector<size_t> m_offsets;
+        size_t m_capacity = 1;
+        size_t m_chunkBytes = 0;
+        std::vector<Chunk> m_chunks;
+        // Emptied chunks kept for reuse, so spawn and despawn waves stop allocating once warmed up
+        std::vector<Chunk> m_spareChunks;
+
+        // Cached archetype graph edges for adding or removing one type
+        std::unordered_map<TypeId, Archetype*> m_addEdges;
+        std::unordered_map<TypeId, Archetype*> m_removeEdges;
+    };
+
+    // Archetype based entity/component storage. Data types are plain structs without virtual update, systems
+    // iterate them with ForEach. Create, Destroy, Add, Remove and Get lock the store, so nodes may come and go
+    // on any thread. Iteration must not overlap structural changes, and a returned reference only stays valid
+    // until the next structural change touching its archetype.
+    class DLL_EXPORT EntityStore
+    {
+    public:
+        EntityStore();
+        ~EntityStore();
+
+        EntityStore(const EntityStore&) = delete;
+        EntityStore& operator=(const EntityStore&) = delete;
+
+        // Store used by nodes and scenes that were not given one
+        static EntityStore& GetDefault();
+
+        Entity Create();
+        void Destroy(Entity entity);
+        bool IsAlive(Entity entity) const;
+
+        // Replaces the value when the entity already has a T. The value is built before the store is locked or
+        // the entity changes archetype, so a throwing constructor leaves the entity untouched.
+        template<typename T, typename... Args>
+        T& Add(Entity entity, Args&&... args)
+        {
+            T value(std::forward<Args>(args)...);
+
+            // Held while moving in, another thread's Destroy could otherwise move the row under us
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (T* existing = static_cast<T*>(FindValue(entity, GetTypeId<T>())))
+            {
+                *existing = std::move(value);
+                return *existing;
+            }
+
+            const ComponentTypeInfo& type = ComponentTypeInfo::Get<T>();
+            void* slot = AddRaw(entity, type);
+            return *::new (slot) T(std::move(value));
+        }
+
+        template<typename T>
+        bool Remove(Entity entity)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return RemoveRaw(entity, GetTypeId<T>());
+        }
+
+        template<typename T>
+        T* Get(Entity entity)
+        {
+            return static_cast<T*>(GetRaw(entity, GetTypeId<T>()));
+        }
+
+        template<typename T>
+        const T* Get(Entity entity) const
+        {
+            return static_cast<const T*>(const_cast<EntityStore*>(this)->GetRaw(entity, GetTypeId<T>()));
+        }
+
+        template<typename T>
+        bool Has(Entity entity) const
+        {
+            return Get<T>(entity) != nullptr;
+        }
+
+        // func(count, entities, Ts* columns...) once per chunk holding every T
+        template<typename... Ts, typename Func>
+        void ForEachChunk(Func&& func)
+        {
+            constexpr std::array<TypeId, sizeof...(Ts)> ids = { GetTypeId<Ts>()... };
+
+            for (const std::unique_ptr<Archetype>& archetype : m_archetypes)
+            {
+                if (!archetype->HasAll(ids.data(), ids.size()))
+                    continue;
+
+                for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+                    InvokeChunk<Ts...>(*archetype, chunk, func, std::index_sequence_for<Ts...>());
+            }
+        }
+
+        // func(Ts&...) or func(Entity, Ts&...) for every entity holding every T
+        template<typename... Ts, typename Func>
+        void ForEach(Func&& func)
+        {
+            ForEachChunk<Ts...>([&](size_t count, const Entity* entities, Ts*... columns) {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if constexpr (std::is_invocable_v<Func&, Entity, Ts&...>)
+                        func(entities[i], columns[i]...);
+                    else
+                        func(columns[i]...);
+                }
+            });
+        }
+
+        // Same as ForEach with chunks spread over the pool, func must only touch the entity it was given
+        template<typename... Ts, typename Func>
+        void ParallelForEach(ThreadPool& pool, Func&& func)
+        {
+            constexpr std::array<TypeId, sizeof...(Ts)> ids = { GetTypeId<Ts>()... };
+
+            std::vector<std::pair<Archetype*, size_t>> chunks;
+            for (const std::unique_ptr<Archetype>& archetype : m_archetypes)
+            {
+                if (!archetype->HasAll(ids.data(), ids.size()))
+                    continue;
+
+                for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+                    chunks.emplace_back(archetype.get(), chunk);
+            }
+
+            pool.ParallelFor(0, chunks.size(), [&](size_t i) {
+                InvokeChunk<Ts...>(*chunks[i].first, chunks[i].second, [&](size_t count, const Entity* entities, Ts*... columns) {
+                    for (size_t row = 0; row < count; ++row)
+                    {
+                        if constexpr (std::is_invocable_v<Func&, Entity, Ts&...>)
+                            func(entities[row], columns[row]...);
+                        else
+                            func(columns[row]...);
+                    }
+                }, std::index_sequence_for<Ts...>());
+            }, 1);
+        }
+
+        size_t GetEntityCount() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_aliveCount;
+        }
+        size_t GetArchetypeCount() const { return m_archetypes.size(); }
+
+        // Frees the chunks archetypes kept after they emptied, for level changes
+        void ReleaseSpareChunks();
+
+    private:
+        struct EntityRecord
+        {
+            Archetype* archetype = nullptr;
+            uint32_t chunk = 0;
+            uint32_t row = 0;
+            uint32_t generation = 0;
+            uint32_t nextFree = Entity::InvalidIndex;
+        };
+
+        template<typename... Ts, typename Func, size_t... Indices>
+        static void InvokeChunk(Archetype& archetype, size_t chunk, Func&& func, std::index_sequence<Indices...>)
+        {
+            const std::array<int, sizeof...(Ts)> columns = { archetype.FindColumn(GetTypeId<Ts>())... };
+            func(archetype.GetCount(chunk), archetype.GetEntities(chunk), static_cast<Ts*>(archetype.GetColumn(chunk, columns[Indices]))...);
+        }
+
+        // Everything below expects m_mutex to be held
+        EntityRecord* FindRecord(Entity entity);
+        void* FindValue(Entity entity, TypeId id);
+
+        void* AddRaw(Entity entity, const ComponentTypeInfo& type);
+        bool RemoveRaw(Entity entity, TypeId id);
+
+        // Locks
+        void* GetRaw(Entity entity, TypeId id);
+
+        Archetype* GetOrCreateArchetype(std::vector<const ComponentTypeInfo*> types);
+        Archetype* GetAddTarget(Archetype& from, const ComponentTypeInfo& type);
+        Archetype* GetRemoveTarget(Archetype& from, TypeId id);
+
+        // Appends a row for entity, columns are left uninitialized
+        void AllocateRow(Archetype& archetype, Entity entity, uint32_t& chunk, uint32_t& row);
+        // Fills the hole with the archetype's last row, destroyValues first destroys what is still in the hole
+        void ReleaseRow(Archetype& archetype, uint32_t chunk, uint32_t row, bool destroyValues);
+        void MoveEntity(EntityRecord& record, Archetype& target);
+
+        mutable std::mutex m_mutex;
+
+        std::vector<std::unique_ptr<Archetype>> m_archetypes;
+        std::map<std::vector<TypeId>, Archetype*> m_archetypeIndex;
+        Archetype* m_emptyArchetype = nullptr;
+
+        std::vector<EntityRecord> m_records;
+        uint32_t m_freeRecord = Entity::InvalidIndex;
+        size_t m_aliveCount = 0;
+    };
+}
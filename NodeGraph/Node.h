@@ -2,6 +2,14 @@
 
 #include "../Engine/Define.h"
 #include "../Engine/StandardInclude.h"
+#include "../Engine/ObjectPool.h"
+#include "../Engine/StringId.h"
+
+#include "ComponentAccess.h"
+#include "EntityStore.h"
+#include "SpatialIndex.h"
+#include "Transform.h"
+#include "UpdateScheduler.h"
 
 namespace BSE
 {
@@ -15,14 +23,44 @@ namespace BSE
             // but render wise can run at a much larger framerate without breaking the update code by running too fast
         virtual void Update(double Tick) {}
         virtual void Render(double Alpha) {}
+
+        // Shared state Update touches outside the owning subtree, components declaring nothing run serially
+        virtual ComponentAccess GetAccess() const { return ComponentAccess::Serial(); }
+
+        // Call when state the component's snapshot codec saves changed, SceneJournal only saves components again
+        // once their revision moved
+        void MarkModified() { ++revision; }
+
+        // Set by the node the component was added to
+        Node* owner = nullptr;
+        TypeId componentType = 0;
+        uint32_t revision = 0;
     };
 
     class DLL_EXPORT Node : public std::enable_shared_from_this<Node>
     {
     public:
-        explicit Node(std::string name)
-            : name(std::move(name)) {}
-        virtual ~Node() = default;
+        explicit Node(std::string name, EntityStore& store = EntityStore::GetDefault())
+            : name(std::move(name))
+            , nameId(this->name)
+            , store(&store)
+            , entity(store.Create()) {}
+
+        virtual ~Node()
+        {
+            // Nodes normally leave through RemoveChild or the scene, which detach them first. One dropped while
+            // still linked must not leave a spatial proxy pointing at it, nor a top level node its range.
+            if (TransformHierarchy* hierarchy = transform.GetHierarchy())
+            {
+                hierarchy->MarkStructureDirty(transform.GetIndex());
+                hierarchy->RemoveRoot(this);
+                TransformHierarchy::Detach(*this);
+            }
+            store->Destroy(entity);
+        }
+
+        Node(const Node&) = delete;
+        Node& operator=(const Node&) = delete;
 
         virtual bool InitNode()
         {
@@ -57,20 +95,67 @@ namespace BSE
 
         virtual void UpdateNode(double Tick)
         {
-            for (auto& pair : components)
+            UpdateComponents(Tick);
+
+            for (auto& pair : childrenByName)
             {
-                if (pair.second)
-                    pair.second->Update(Tick);
+                auto& child = pair.second;
+                if (child)
+                    child->UpdateNode(Tick);
             }
+        }
+
+        // What scenes call, the subtree only updates where its update policies say so this tick
+        void UpdateNodeScheduled(double Tick, UpdateScheduler& scheduler, const UpdateDecision& parent)
+        {
+            const UpdateDecision decision = scheduler.Schedule(*this, Tick, parent);
+            if (decision.due)
+                UpdateComponents(decision.elapsed);
 
             for (auto& pair : childrenByName)
             {
                 auto& child = pair.second;
                 if (child)
-                    child->UpdateNode(Tick);
+                    child->UpdateNodeScheduled(Tick, scheduler, decision);
             }
         }
 
+        // Children keep their own policies, the default one follows the parent
+        void SetUpdatePolicy(const UpdatePolicy& policy)
+        {
+            updatePolicy = policy;
+            updateState = UpdateState();
+            ++revision;
+            if (policy.rate == UpdateRate::Dormant)
+                Sleep();
+        }
+
+        const UpdatePolicy& GetUpdatePolicy() const { return updatePolicy; }
+
+        // A sleeping node skips its components, and those of children inheriting its policy, until woken.
+        // Safe to call from any thread, including from another node's Update.
+        void Sleep() { asleep.store(true, std::memory_order_relaxed); }
+        void Wake() { asleep.store(false, std::memory_order_relaxed); }
+        bool IsAsleep() const { return asleep.load(std::memory_order_relaxed); }
+
+        // Union of what every component in this subtree declared
+        ComponentAccess GatherAccess() const
+        {
+            ComponentAccess access;
+            for (auto& pair : components)
+            {
+                if (pair.second)
+                    access.Merge(pair.second->GetAccess());
+            }
+
+            for (auto& pair : childrenByName)
+            {
+                if (pair.second)
+                    access.Merge(pair.second->GatherAccess());
+            }
+            return access;
+        }
+
         virtual void RenderNode(double Alpha)
         {
             for (auto& pair : components)
@@ -87,92 +172,392 @@ namespace BSE
             }
         }
 
-        std::string GetName() const { return name; }
+        const std::string& GetName() const { return name; }
+
+        Transform& GetTransform() { return transform; }
+        const Transform& GetTransform() const { return transform; }
+
+        // Local space bounds, nodes with bounds are kept in their scene's spatial index
+        void SetBounds(const AABB& localBounds)
+        {
+            bounds = localBounds;
+            transform.MarkDirty();
+            ++revision;
+        }
+
+        void ClearBounds()
+        {
+            bounds.reset();
+            transform.MarkDirty();
+            ++revision;
+        }
+
+        const std::optional<AABB>& GetBounds() const { return bounds; }
+        int32_t GetSpatialProxy() const { return spatialProxy; }
+        StringId GetNameId() const { return nameId; }
 
-        bool HasChild(const std::string& childName) const
+        // Bumped whenever children or components are added or removed and by bounds and update policy changes.
+        // Transforms and component state keep their own revisions.
+        uint32_t GetRevision() const { return revision; }
+
+        // Every name based call has a StringId overload, hot code should keep ids around instead of strings
+        bool HasChild(StringId childId) const
         {
-            return childrenByName.find(childName) != childrenByName.end();
+            return childrenByName.find(childId) != childrenByName.end();
         }
 
+        bool HasChild(const std::string& childName) const { return HasChild(StringId(childName)); }
+
         bool AddChild(std::shared_ptr<Node> node)
         {
             if (!node)
                 return false;
 
-            const auto& nodeName = node->GetName();
-            if (HasChild(nodeName))
+            const StringId childId = node->GetNameId();
+            if (!childrenByName.try_emplace(childId, std::move(node)).second)
                 return false;
 
-            childrenByName[nodeName] = std::move(node);
+            ++revision;
+            if (transform.GetHierarchy())
+                transform.GetHierarchy()->MarkStructureDirty(transform.GetIndex());
             return true;
         }
 
-        bool RemoveChild(const std::string& childName)
+        std::shared_ptr<Node> GetChild(StringId childId) const
         {
-            return childrenByName.erase(childName) > 0;
+            auto it = childrenByName.find(childId);
+            return (it == childrenByName.end()) ? nullptr : it->second;
+        }
+
+        std::shared_ptr<Node> GetChild(const std::string& childName) const { return GetChild(StringId(childName)); }
+
+        bool RemoveChild(StringId childId)
+        {
+            auto it = childrenByName.find(childId);
+            if (it == childrenByName.end())
+                return false;
+
+            if (it->second)
+                TransformHierarchy::Detach(*it->second);
+            if (transform.GetHierarchy())
+                transform.GetHierarchy()->MarkStructureDirty(transform.GetIndex());
+
+            childrenByName.erase(it);
+            ++revision;
+            return true;
         }
 
-        bool HasComponent(const std::string& compName) const
+        bool RemoveChild(const std::string& childName) { return RemoveChild(StringId(childName)); }
+
+        template<typename Func>
+        void ForEachChild(Func&& func) const
         {
-            return components.find(compName) != components.end();
+            for (auto& pair : childrenByName)
+            {
+                if (pair.second)
+                    func(pair.second);
+            }
         }
 
-        bool AddComponent(std::shared_ptr<Component> component, const std::string& compName)
+        bool HasComponent(StringId compId) const
         {
+            return components.find(compId) != components.end();
+        }
+
+        bool HasComponent(const std::string& compName) const { return HasComponent(StringId(compName)); }
+
+        // The static type of component is what Get<T>() finds it by
+        template<typename T>
+        bool AddComponent(std::shared_ptr<T> component, StringId compId)
+        {
+            static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
             if (!component)
                 return false;
 
-            if (HasComponent(compName))
+            T* raw = component.get();
+            if (!components.try_emplace(compId, std::move(component)).second)
                 return false;
 
-            components[compName] = std::move(component);
+            AttachComponent(raw, GetTypeId<T>());
             return true;
         }
 
+        template<typename T>
+        bool AddComponent(std::shared_ptr<T> component, const std::string& compName)
+        {
+            return AddComponent(std::move(component), StringId::Intern(compName));
+        }
+
         template<typename T, typename... Args>
-        std::shared_ptr<T> AddComponent(const std::string& compName, Args&&... args)
+        std::shared_ptr<T> AddComponent(StringId compId, Args&&... args)
         {
             static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
-            if (HasComponent(compName))
+            if (HasComponent(compId))
                 return nullptr;
 
             auto comp = std::make_shared<T>(std::forward<Args>(args)...);
-            components[compName] = comp;
+            components.emplace(compId, comp);
+            AttachComponent(comp.get(), GetTypeId<T>());
             return comp;
         }
 
-        std::shared_ptr<Component> GetComponent(const std::string& compName)
+        template<typename T, typename... Args>
+        std::shared_ptr<T> AddComponent(const std::string& compName, Args&&... args)
         {
-            auto it = components.find(compName);
+            return AddComponent<T>(StringId::Intern(compName), std::forward<Args>(args)...);
+        }
+
+        std::shared_ptr<Component> GetComponent(StringId compId)
+        {
+            auto it = components.find(compId);
             return (it == components.end()) ? nullptr : it->second;
         }
 
+        std::shared_ptr<Component> GetComponent(const std::string& compName) { return GetComponent(StringId(compName)); }
+
+        template<typename T>
+        std::shared_ptr<T> GetComponentAs(StringId compId)
+        {
+            static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+            return std::dynamic_pointer_cast<T>(GetComponent(compId));
+        }
+
         template<typename T>
-        std::shared_ptr<T> GetComponentAs(const std::string& compName)
+        std::shared_ptr<T> GetComponentAs(const std::string& compName) { return GetComponentAs<T>(StringId(compName)); }
+
+        // Non-owning typed access without hashing or RTTI. Finds components by the exact type they were added
+        // as, the first one added wins when several share a type. Valid while the component stays on the node.
+        template<typename T>
+        T* Get() const
         {
             static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
-            return std::dynamic_pointer_cast<T>(GetComponent(compName));
+            constexpr TypeId id = GetTypeId<T>();
+
+            if ((typeMask & TypeBit(id)) == 0)
+                return nullptr;
+
+            for (uint32_t i = 0; i < typedCount; ++i)
+            {
+                if (typedComponents[i].type == id)
+                    return static_cast<T*>(typedComponents[i].component);
+            }
+
+            for (const TypedComponent& typed : typedOverflow)
+            {
+                if (typed.type == id)
+                    return static_cast<T*>(typed.component);
+            }
+            return nullptr;
+        }
+
+        template<typename T>
+        bool Has() const { return Get<T>() != nullptr; }
+
+        // func(compId, component), in no particular order
+        template<typename Func>
+        void ForEachComponent(Func&& func) const
+        {
+            for (auto& pair : components)
+            {
+                if (pair.second)
+                    func(pair.first, pair.second);
+            }
         }
 
-        bool RemoveComponent(const std::string& compName)
+        bool RemoveComponent(StringId compId)
         {
-            return components.erase(compName) > 0;
+            auto it = components.find(compId);
+            if (it == components.end())
+                return false;
+
+            auto comp = std::move(it->second);
+            components.erase(it);
+            DetachComponent(comp.get());
+            return true;
         }
 
-        std::shared_ptr<Component> ExtractComponent(const std::string& compName)
+        bool RemoveComponent(const std::string& compName) { return RemoveComponent(StringId(compName)); }
+
+        std::shared_ptr<Component> ExtractComponent(StringId compId)
         {
-            auto it = components.find(compName);
+            auto it = components.find(compId);
             if (it == components.end())
                 return nullptr;
 
-            auto comp = it->second;
+            auto comp = std::move(it->second);
             components.erase(it);
+            DetachComponent(comp.get());
             return comp;
         }
 
+        std::shared_ptr<Component> ExtractComponent(const std::string& compName) { return ExtractComponent(StringId(compName)); }
+
+        // Plain data lives in the entity store next to the same data of other nodes, systems iterate it
+        // there without touching the node. Pointers stay valid until data is added or removed, or a node with
+        // the same set of data types goes away, since rows are kept dense.
+        template<typename T, typename... Args>
+        T& AddData(Args&&... args)
+        {
+            return store->Add<T>(entity, std::forward<Args>(args)...);
+        }
+
+        template<typename T>
+        T* GetData()
+        {
+            return store->Get<T>(entity);
+        }
+
+        template<typename T>
+        const T* GetData() const
+        {
+            return static_cast<const EntityStore*>(store)->Get<T>(entity);
+        }
+
+        template<typename T>
+        bool HasData() const
+        {
+            return store->Has<T>(entity);
+        }
+
+        template<typename T>
+        bool RemoveData()
+        {
+            return store->Remove<T>(entity);
+        }
+
+        Entity GetEntity() const { return entity; }
+        EntityStore& GetEntityStore() const { return *store; }
+
     private:
+        struct TypedComponent
+        {
+            TypeId type = 0;
+            Component* component = nullptr;
+        };
+
+        static constexpr uint32_t InlineTypedComponents = 8;
+
+        static constexpr uint64_t TypeBit(TypeId id) { return uint64_t(1) << (id & 63); }
+
+        void UpdateComponents(double Tick)
+        {
+            const bool tracking = AccessTracker::IsEnabled();
+            for (auto& pair : components)
+            {
+                if (!pair.second)
+                    continue;
+
+                if (tracking)
+                    AccessTracker::SetComponent(this, pair.second->GetAccess());
+                pair.second->Update(Tick);
+            }
+        }
+
+        void AttachComponent(Component* component, TypeId type)
+        {
+            component->owner = this;
+            component->componentType = type;
+            ++revision;
+
+            // Keep the first component of a type
+            if ((typeMask & TypeBit(type)) != 0 && FindTyped(type) != nullptr)
+                return;
+
+            const TypedComponent typed{ type, component };
+            if (typedCount < InlineTypedComponents)
+                typedComponents[typedCount++] = typed;
+            else
+                typedOverflow.push_back(typed);
+
+            typeMask |= TypeBit(type);
+        }
+
+        void DetachComponent(Component* component)
+        {
+            if (!component)
+                return;
+
+            const TypeId type = component->componentType;
+            component->owner = nullptr;
+            ++revision;
+
+            if (FindTyped(type) != component)
+                return;
+
+            for (uint32_t i = 0; i < typedCount; ++i)
+            {
+                if (typedComponents[i].component == component)
+                {
+                    typedComponents[i] = typedComponents[--typedCount];
+                    typedComponents[typedCount] = TypedComponent();
+                    if (!typedOverflow.empty())
+                    {
+                        typedComponents[typedCount++] = typedOverflow.back();
+                        typedOverflow.pop_back();
+                    }
+                    break;
+                }
+            }
+
+            typedOverflow.erase(std::remove_if(typedOverflow.begin(), typedOverflow.end(), [component](const TypedComponent& typed) {
+                return typed.component == component;
+            }), typedOverflow.end());
+
+            typeMask = 0;
+            for (uint32_t i = 0; i < typedCount; ++i)
+                typeMask |= TypeBit(typedComponents[i].type);
+            for (const TypedComponent& typed : typedOverflow)
+                typeMask |= TypeBit(typed.type);
+
+            // Another component of the same type takes over the slot
+            for (auto& pair : components)
+            {
+                if (pair.second && pair.second->componentType == type)
+                {
+                    AttachComponent(pair.second.get(), type);
+                    break;
+                }
+            }
+        }
+
+        Component* FindTyped(TypeId type) const
+        {
+            for (uint32_t i = 0; i < typedCount; ++i)
+            {
+                if (typedComponents[i].type == type)
+                    return typedComponents[i].component;
+            }
+
+            for (const TypedComponent& typed : typedOverflow)
+            {
+                if (typed.type == type)
+                    return typed.component;
+            }
+            return nullptr;
+        }
+
+        friend class TransformHierarchy;
+        friend class Scene;
+        friend class UpdateScheduler;
+
         std::string name;
-        std::unordered_map<std::string, std::shared_ptr<Node>> childrenByName;
-        std::unordered_map<std::string, std::shared_ptr<Component>> components;
+        StringId nameId;
+        Transform transform;
+        std::optional<AABB> bounds;
+        int32_t spatialProxy = SpatialIndex::NullProxy;
+        UpdatePolicy updatePolicy;
+        UpdateState updateState;
+        uint32_t revision = 0;
+        std::atomic<bool> asleep{ false };
+        EntityStore* store;
+        Entity entity;
+        RecycledMap<StringId, std::shared_ptr<Node>> childrenByName;
+        RecycledMap<StringId, std::shared_ptr<Component>> components;
+
+        std::array<TypedComponent, InlineTypedComponents> typedComponents{};
+        uint32_t typedCount = 0;
+        std::vector<TypedComponent> typedOverflow;
+        // One bit per type id modulo 64, a clear bit rules a type out without scanning
+        uint64_t typeMask = 0;
     };
 }
@@ -3,6 +3,7 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include "../Engine/DestructionQueue.h"
 #include "Node.h"
 
 namespace BSE
@@ -10,10 +11,36 @@ namespace BSE
     class DLL_EXPORT Scene
     {
     public:
-        Scene(std::string name)
-            : name(std::move(name)) {}
+        // Systems run over the scene's entity store before node updates, in the order they were added
+        using System = std::function<void(EntityStore&, double)>;
+
+        Scene(std::string name, EntityStore& store = EntityStore::GetDefault())
+            : name(std::move(name))
+            , entityStore(&store)
+        {
+            transforms.SetSpatialIndex(&spatialIndex);
+        }
         ~Scene() = default;
 
+        EntityStore& GetEntityStore() { return *entityStore; }
+
+        // World matrices of every node, refreshed at the end of Update
+        TransformHierarchy& GetTransforms() { return transforms; }
+        const TransformHierarchy& GetTransforms() const { return transforms; }
+
+        // World bounds of every node with bounds, as of the end of the last Update. User data is the Node*.
+        SpatialIndex& GetSpatialIndex() { return spatialIndex; }
+        const SpatialIndex& GetSpatialIndex() const { return spatialIndex; }
+
+        // Decides which nodes update each tick, set its observer to the camera for distance scaled policies
+        UpdateScheduler& GetUpdateScheduler() { return scheduler; }
+
+        void AddSystem(System system)
+        {
+            if (system)
+                systems.push_back(std::move(system));
+        }
+
         void InitScene()
         {
             for (auto& pair : nodesListUnique)
@@ -34,33 +61,89 @@ namespace BSE
             for (auto& pair : nodesListUnique)
             {
                 if (pair.second)
-                    pair.second->DeleteNode();
+                    RetireNode(std::move(pair.second));
             }
             nodesListUnique.clear();
 
             for (auto& pair : nodesListShared)
             {
                 if (pair.second)
-                    pair.second->DeleteNode();
+                    RetireNode(std::move(pair.second));
             }
             nodesListShared.clear();
         }
 
+        // Removed nodes leave the scene at once but get DeleteNode and are destroyed during the queue's EndFrame,
+        // nullptr deletes them on the spot
+        void SetDestructionQueue(DestructionQueue* queue) { destructionQueue = queue; }
+        DestructionQueue* GetDestructionQueue() const { return destructionQueue; }
+
         void Update(double Tick)
         {
+            for (auto& system : systems)
+                system(*entityStore, Tick);
+
+            scheduler.BeginTick();
+            const UpdateDecision root{ true, Tick };
+
             for (auto& pair : nodesListUnique)
             {
                 if (pair.second)
-                    pair.second->UpdateNode(Tick);
+                    pair.second->UpdateNodeScheduled(Tick, scheduler, root);
             }
 
             for (auto& pair : nodesListShared)
             {
                 if (pair.second)
-                    pair.second->UpdateNode(Tick);
+                    pair.second->UpdateNodeScheduled(Tick, scheduler, root);
+            }
+
+            transforms.Update();
+            SyncSpatialIndex();
+        }
+
+        // Top level trees run on the pool in batches, trees sharing a batch declared no conflicting access.
+        // Trees holding a component without a declaration are updated afterwards on the calling thread.
+        void Update(double Tick, ThreadPool& pool)
+        {
+            for (auto& system : systems)
+                system(*entityStore, Tick);
+
+            PlanUpdateBatches();
+            scheduler.BeginTick();
+            const UpdateDecision root{ true, Tick };
+
+            const bool tracking = AccessTracker::IsEnabled();
+            for (size_t batch = 0; batch < updateBatchCount; ++batch)
+            {
+                const std::vector<Node*>& trees = updateBatches[batch].trees;
+
+                if (tracking)
+                    AccessTracker::BeginBatch();
+
+                pool.ParallelFor(0, trees.size(), [&](size_t i) {
+                    if (tracking)
+                        AccessTracker::BeginUnit(i);
+
+                    trees[i]->UpdateNodeScheduled(Tick, scheduler, root);
+
+                    if (tracking)
+                        AccessTracker::EndUnit();
+                }, 1);
+
+                if (tracking)
+                    AccessTracker::EndBatch();
             }
+
+            for (Node* node : serialTrees)
+                node->UpdateNodeScheduled(Tick, scheduler, root);
+
+            transforms.Update();
+            SyncSpatialIndex();
         }
 
+        size_t GetUpdateBatchCount() const { return updateBatchCount; }
+
         void Render(double Alpha)
         {
             for (auto& pair : nodesListUnique)
@@ -78,64 +161,209 @@ namespace BSE
         
         void AddNodeUnique(std::unique_ptr<Node> node)
         {
-            if (!node)
-                return;
-
-            const std::string nodeName = node->GetName();
-            if (nodeName.empty())
+            if (!node || node->GetName().empty())
                 return;
 
-            if (nodesListUnique.find(nodeName) != nodesListUnique.end())
-                return;
-            if (nodesListShared.find(nodeName) != nodesListShared.end())
+            const StringId nodeId = node->GetNameId();
+            if (nodesListShared.find(nodeId) != nodesListShared.end())
                 return;
 
-            nodesListUnique.emplace(nodeName, std::move(node));
+            auto result = nodesListUnique.try_emplace(nodeId, std::move(node));
+            if (result.second)
+                transforms.AddRoot(result.first->second.get());
         }
 
         void AddNodeShared(std::shared_ptr<Node> node)
         {
-            if (!node)
+            if (!node || node->GetName().empty())
                 return;
 
-            const std::string nodeName = node->GetName();
-            if (nodeName.empty())
+            const StringId nodeId = node->GetNameId();
+            if (nodesListUnique.find(nodeId) != nodesListUnique.end())
                 return;
 
-            if (nodesListShared.find(nodeName) != nodesListShared.end())
-                return;
-            if (nodesListUnique.find(nodeName) != nodesListUnique.end())
-                return;
+            auto result = nodesListShared.try_emplace(nodeId, std::move(node));
+            if (result.second)
+                transforms.AddRoot(result.first->second.get());
+        }
+
+        // func(node, shared) for every top level node, shared tells which list it was added through
+        template<typename Func>
+        void ForEachRootNode(Func&& func) const
+        {
+            for (auto& pair : nodesListUnique)
+            {
+                if (pair.second)
+                    func(*pair.second, false);
+            }
 
-            nodesListShared.emplace(nodeName, std::move(node));
+            for (auto& pair : nodesListShared)
+            {
+                if (pair.second)
+                    func(*pair.second, true);
+            }
         }
 
-        void RemoveNode(std::string name)
+        // Top level nodes only
+        Node* FindNode(StringId nodeId) const
         {
-            if (name.empty())
-                return;
+            auto itU = nodesListUnique.find(nodeId);
+            if (itU != nodesListUnique.end())
+                return itU->second.get();
 
-            auto itU = nodesListUnique.find(name);
+            auto itS = nodesListShared.find(nodeId);
+            return itS == nodesListShared.end() ? nullptr : itS->second.get();
+        }
+
+        Node* FindNode(const std::string& nodeName) const { return FindNode(StringId(nodeName)); }
+
+        void RemoveNode(const std::string& nodeName)
+        {
+            if (!nodeName.empty())
+                RemoveNode(StringId(nodeName));
+        }
+
+        void RemoveNode(StringId nodeId) { RemoveRootNode(nodeId, true); }
+
+        // Drops the node without DeleteNode, for nodes whose components never ran InitComponent such as ones
+        // built before InitScene
+        void DiscardNode(StringId nodeId) { RemoveRootNode(nodeId, false); }
+
+    private:
+        void RemoveRootNode(StringId nodeId, bool deleteNode)
+        {
+            auto itU = nodesListUnique.find(nodeId);
             if (itU != nodesListUnique.end())
             {
                 if (itU->second)
-                    itU->second->DeleteNode();
+                    RetireNode(std::move(itU->second), deleteNode);
                 nodesListUnique.erase(itU);
             }
 
-            auto itS = nodesListShared.find(name);
+            auto itS = nodesListShared.find(nodeId);
             if (itS != nodesListShared.end())
             {
                 if (itS->second)
-                    itS->second->DeleteNode();
+                    RetireNode(std::move(itS->second), deleteNode);
                 nodesListShared.erase(itS);
             }
         }
 
-    private:
+        template<typename NodePtr>
+        void RetireNode(NodePtr node, bool deleteNode = true)
+        {
+            transforms.RemoveRoot(node.get());
+
+            if (!deleteNode)
+                return;
+
+            if (!destructionQueue)
+            {
+                node->DeleteNode();
+                return;
+            }
+
+            destructionQueue->Enqueue([node = std::move(node)]() mutable {
+                node->DeleteNode();
+                node.reset();
+            });
+        }
+
+        struct UpdateBatch
+        {
+            std::vector<Node*> trees;
+            ComponentAccess access;
+        };
+
+        // Greedy first fit, access is gathered every frame since components may come and go
+        void PlanUpdateBatches()
+        {
+            for (UpdateBatch& batch : updateBatches)
+            {
+                batch.trees.clear();
+                batch.access = ComponentAccess();
+            }
+            updateBatchCount = 0;
+            serialTrees.clear();
+
+            auto place = [this](Node* node) {
+                if (!node)
+                    return;
+
+                const ComponentAccess access = node->GatherAccess();
+                if (access.serial)
+                {
+                    serialTrees.push_back(node);
+                    return;
+                }
+
+                size_t batch = 0;
+                while (batch < updateBatchCount && updateBatches[batch].access.ConflictsWith(access))
+                    ++batch;
+
+                if (batch == updateBatchCount)
+                {
+                    if (updateBatchCount == updateBatches.size())
+                        updateBatches.emplace_back();
+                    ++updateBatchCount;
+                }
+
+                updateBatches[batch].trees.push_back(node);
+                updateBatches[batch].access.Merge(access);
+            };
+
+            for (auto& pair : nodesListUnique)
+                place(pair.second.get());
+
+            for (auto& pair : nodesListShared)
+                place(pair.second.get());
+        }
+
+        // Follows the transform pass, only nodes whose world matrix changed are touched. Nodes leaving the scene
+        // already dropped their proxies through the hierarchy's Detach.
+        void SyncSpatialIndex()
+        {
+            const std::vector<Node*>& nodes = transforms.GetNodes();
+            for (uint32_t slot : transforms.GetLastRecomputed())
+            {
+                Node* node = nodes[slot];
+                const bool linked = spatialIndex.IsValid(node->spatialProxy) && spatialIndex.GetUserData(node->spatialProxy) == node;
+
+                if (!node->bounds)
+                {
+                    if (linked)
+                        spatialIndex.Remove(node->spatialProxy);
+                    node->spatialProxy = SpatialIndex::NullProxy;
+                    continue;
+                }
+
+                const AABB world = node->bounds->Transformed(transforms.GetWorldMatrix(slot));
+                if (linked)
+                    spatialIndex.Move(node->spatialProxy, world);
+                else
+                    node->spatialProxy = spatialIndex.Insert(world, node);
+            }
+        }
+
         std::string name;
 
-        std::unordered_map<std::string, std::unique_ptr<Node>> nodesListUnique;
-        std::unordered_map<std::string, std::shared_ptr<Node>> nodesListShared;
+        EntityStore* entityStore;
+        DestructionQueue* destructionQueue = nullptr;
+        std::vector<System> systems;
+        UpdateScheduler scheduler;
+
+        RecycledMap<StringId, std::unique_ptr<Node>> nodesListUnique;
+        RecycledMap<StringId, std::shared_ptr<Node>> nodesListShared;
+
+        // Kept between frames to reuse their storage
+        std::vector<UpdateBatch> updateBatches;
+        size_t updateBatchCount = 0;
+        std::vector<Node*> serialTrees;
+
+        // Outlives the hierarchy, which drops proxies as it lets go of the nodes
+        SpatialIndex spatialIndex;
+
+        // Declared after the node lists so it is destroyed, and lets go of the nodes, first
+        TransformHierarchy transforms;
     };
 }
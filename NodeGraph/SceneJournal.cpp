@@ -0,0 +1,865 @@
+#include "SceneJournal.h"
+#include "SceneSnapshot.h"
+#include "../Engine/Hash.h"
+#include "../Engine/MappedFile.h"
+
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace BSE
+{
+    namespace
+    {
+        constexpr uint32_t FrameMagic = 0x4A455342; // "BSEJ"
+        constexpr uint32_t FrameVersion = 1;
+
+        // Precedes every change set in a journal file, the hash covers the ops so a torn write is caught
+        struct FrameHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t size;
+            uint64_t hash;
+        };
+
+        enum class JournalOp : uint8_t
+        {
+            // parent key (0 for top level), shared, name, state
+            AddNode,
+            // key, the node's subtree goes with it
+            RemoveNode,
+            // key, state
+            SetNode,
+            // node key, component name, component id, type name, payload, replaces a component with the same id
+            SetComponent,
+            // node key, component id
+            RemoveComponent
+        };
+
+        // What is journaled about a node itself, all 4 byte fields so states compare bytewise
+        struct NodeState
+        {
+            float position[3];
+            // w, x, y, z
+            float rotation[4];
+            float scale[3];
+            float boundsMin[3];
+            float boundsMax[3];
+            uint32_t hasBounds;
+
+            uint32_t updateRate;
+            uint32_t updateInterval;
+            float nearDistance;
+            float farDistance;
+        };
+
+        static_assert(std::is_trivially_copyable_v<FrameHeader>);
+        static_assert(std::is_trivially_copyable_v<NodeState> && sizeof(NodeState) == 21 * 4);
+
+        // Keys follow the path of names from the top, top level nodes hang off RootKey
+        constexpr uint64_t RootKey = FNV1a64Offset;
+
+        uint64_t ChildKey(uint64_t parentKey, StringId nameId)
+        {
+            return HashCombine(parentKey == 0 ? RootKey : parentKey, nameId.GetValue());
+        }
+
+        uint64_t HashBytes(const uint8_t* data, size_t size)
+        {
+            return HashFNV1a64(std::string_view(reinterpret_cast<const char*>(data), size));
+        }
+
+        NodeState CaptureState(const Node& node)
+        {
+            NodeState state{};
+            const Transform& transform = node.GetTransform();
+            const glm::vec3& position = transform.GetPosition();
+            const glm::quat& rotation = transform.GetRotation();
+            const glm::vec3& scale = transform.GetScale();
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                state.position[axis] = position[axis];
+                state.scale[axis] = scale[axis];
+            }
+            state.rotation[0] = rotation.w;
+            state.rotation[1] = rotation.x;
+            state.rotation[2] = rotation.y;
+            state.rotation[3] = rotation.z;
+
+            if (const std::optional<AABB>& bounds = node.GetBounds())
+            {
+                state.hasBounds = 1;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    state.boundsMin[axis] = bounds->min[axis];
+                    state.boundsMax[axis] = bounds->max[axis];
+                }
+            }
+
+            const UpdatePolicy& policy = node.GetUpdatePolicy();
+            state.updateRate = static_cast<uint32_t>(policy.rate);
+            state.updateInterval = policy.interval;
+            state.nearDistance = policy.nearDistance;
+            state.farDistance = policy.farDistance;
+            return state;
+        }
+
+        bool SameState(const NodeState& a, const NodeState& b)
+        {
+            return std::memcmp(&a, &b, sizeof(NodeState)) == 0;
+        }
+
+        // Bounds and policy are only touched when they differ, setting the policy restarts the node's schedule
+        bool ApplyState(Node& node, const NodeState& state)
+        {
+            if (state.updateRate > static_cast<uint32_t>(UpdateRate::Dormant))
+                return false;
+
+            Transform& transform = node.GetTransform();
+            transform.SetPosition(glm::vec3(state.position[0], state.position[1], state.position[2]));
+            transform.SetRotation(glm::quat(state.rotation[0], state.rotation[1], state.rotation[2], state.rotation[3]));
+            transform.SetScale(glm::vec3(state.scale[0], state.scale[1], state.scale[2]));
+
+            const NodeState current = CaptureState(node);
+            if (state.hasBounds == 0 && current.hasBounds != 0)
+                node.ClearBounds();
+            else if (state.hasBounds != 0 && (current.hasBounds == 0 || std::memcmp(current.boundsMin, state.boundsMin, sizeof(state.boundsMin)) != 0
+                                              || std::memcmp(current.boundsMax, state.boundsMax, sizeof(state.boundsMax)) != 0))
+            {
+                node.SetBounds(AABB{ glm::vec3(state.boundsMin[0], state.boundsMin[1], state.boundsMin[2]),
+                                     glm::vec3(state.boundsMax[0], state.boundsMax[1], state.boundsMax[2]) });
+            }
+
+            if (current.updateRate != state.updateRate || current.updateInterval != state.updateInterval
+                || current.nearDistance != state.nearDistance || current.farDistance != state.farDistance)
+            {
+                UpdatePolicy policy;
+                policy.rate = static_cast<UpdateRate>(state.updateRate);
+                policy.interval = std::max(state.updateInterval, 1u);
+                policy.nearDistance = state.nearDistance;
+                policy.farDistance = state.farDistance;
+                node.SetUpdatePolicy(policy);
+            }
+            return true;
+        }
+
+        void WriteAddNode(SnapshotWriter& writer, uint64_t parentKey, bool shared, std::string_view name, const NodeState& state)
+        {
+            writer.Write(JournalOp::AddNode);
+            writer.Write(parentKey);
+            writer.Write(static_cast<uint8_t>(shared ? 1 : 0));
+            writer.WriteString(name);
+            writer.Write(state);
+        }
+
+        void WriteRemoveNode(SnapshotWriter& writer, uint64_t key)
+        {
+            writer.Write(JournalOp::RemoveNode);
+            writer.Write(key);
+        }
+
+        void WriteSetNode(SnapshotWriter& writer, uint64_t key, const NodeState& state)
+        {
+            writer.Write(JournalOp::SetNode);
+            writer.Write(key);
+            writer.Write(state);
+        }
+
+        void WriteSetComponent(SnapshotWriter& writer, uint64_t nodeKey, StringId compId, std::string_view typeName, const std::vector<uint8_t>& payload)
+        {
+            writer.Write(JournalOp::SetComponent);
+            writer.Write(nodeKey);
+            writer.WriteString(compId.GetString());
+            writer.Write(compId.GetValue());
+            writer.WriteString(typeName);
+            writer.Write(static_cast<uint32_t>(payload.size()));
+            writer.WriteBytes(payload.data(), payload.size());
+        }
+
+        void WriteRemoveComponent(SnapshotWriter& writer, uint64_t nodeKey, StringId compId)
+        {
+            writer.Write(JournalOp::RemoveComponent);
+            writer.Write(nodeKey);
+            writer.Write(compId.GetValue());
+        }
+    }
+
+    // The scene as of the last Record, entries only point at live objects while the scene still holds them.
+    // Entities tell a node apart from a different one that took its place under the same path.
+    struct SceneJournal::Baseline
+    {
+        struct ComponentEntry
+        {
+            StringId id;
+            const Component* component = nullptr;
+            uint32_t revision = 0;
+            std::string typeName;
+            std::vector<uint8_t> payload;
+        };
+
+        struct NodeEntry
+        {
+            // 0 for top level nodes
+            uint64_t parent = 0;
+            Entity entity;
+            bool shared = false;
+            std::string name;
+            NodeState state{};
+            uint32_t revision = 0;
+            uint32_t transformRevision = 0;
+            // Only components with a codec
+            std::vector<ComponentEntry> components;
+            std::vector<uint64_t> children;
+            uint64_t seen = 0;
+        };
+
+        std::unordered_map<uint64_t, NodeEntry> nodes;
+        uint64_t epoch = 0;
+
+        // Reused between Records
+        std::string typeName;
+        std::vector<uint8_t> payload;
+        std::vector<uint64_t> gone;
+        std::vector<std::pair<size_t, size_t>> undoUnits;
+    };
+
+    SceneJournal::SceneJournal(Scene& scene, const JournalSettings& settings)
+        : m_scene(scene)
+        , m_settings(settings)
+        , m_baseline(std::make_unique<Baseline>())
+    {
+        Checkpoint();
+    }
+
+    SceneJournal::~SceneJournal() = default;
+
+    void SceneJournal::Checkpoint()
+    {
+        m_baseline->nodes.clear();
+        Diff(nullptr);
+
+        m_history.clear();
+        m_cursor = 0;
+        m_unsaved.clear();
+        m_stats = JournalStats();
+    }
+
+    bool SceneJournal::SaveCheckpoint(const std::string& snapshotPath, const std::string& journalPath)
+    {
+        if (!SceneSnapshot::Save(m_scene, snapshotPath))
+            return false;
+
+        std::ofstream out(journalPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cerr << "[SceneJournal] Failed to open file for writing: " << journalPath << std::endl;
+            return false;
+        }
+
+        Checkpoint();
+        return true;
+    }
+
+    bool SceneJournal::Record()
+    {
+        ChangeSet set;
+        Diff(&set);
+        m_stats.changeSetBytes = set.forward.size() + set.backward.size();
+        if (set.forward.empty())
+            return false;
+
+        QueueForFile(set.forward);
+
+        m_history.erase(m_history.begin() + static_cast<std::ptrdiff_t>(m_cursor), m_history.end());
+        m_history.push_back(std::move(set));
+        ++m_cursor;
+        while (m_history.size() > m_settings.maxUndo)
+        {
+            m_history.pop_front();
+            --m_cursor;
+        }
+        return true;
+    }
+
+    bool SceneJournal::Undo()
+    {
+        // Changes since the last Record become the change set undone
+        Record();
+        if (!CanUndo())
+            return false;
+
+        --m_cursor;
+        const bool applied = Apply(m_scene, m_history[m_cursor].backward.data(), m_history[m_cursor].backward.size(), true, "undo");
+
+        // The file gets what actually changed, also when the undo stopped part way
+        ChangeSet result;
+        Diff(&result);
+        if (!result.forward.empty())
+            QueueForFile(result.forward);
+        return applied;
+    }
+
+    bool SceneJournal::Redo()
+    {
+        Record();
+        if (!CanRedo())
+            return false;
+
+        const bool applied = Apply(m_scene, m_history[m_cursor].forward.data(), m_history[m_cursor].forward.size(), true, "redo");
+        ++m_cursor;
+
+        ChangeSet result;
+        Diff(&result);
+        if (!result.forward.empty())
+            QueueForFile(result.forward);
+        return applied;
+    }
+
+    void SceneJournal::QueueForFile(const std::vector<uint8_t>& ops)
+    {
+        FrameHeader header{};
+        header.magic = FrameMagic;
+        header.version = FrameVersion;
+        header.size = ops.size();
+        header.hash = HashBytes(ops.data(), ops.size());
+
+        SnapshotWriter writer(m_unsaved);
+        writer.Write(header);
+        writer.WriteBytes(ops.data(), ops.size());
+        m_stats.unsavedBytes = m_unsaved.size();
+    }
+
+    bool SceneJournal::AppendTo(const std::string& path)
+    {
+        if (m_unsaved.empty())
+            return true;
+
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        if (!out)
+        {
+            std::cerr << "[SceneJournal] Failed to open file for writing: " << path << std::endl;
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(m_unsaved.data()), static_cast<std::streamsize>(m_unsaved.size()));
+        if (!out)
+        {
+            std::cerr << "[SceneJournal] Failed to write file: " << path << std::endl;
+            return false;
+        }
+
+        m_unsaved.clear();
+        m_stats.unsavedBytes = 0;
+        return true;
+    }
+
+    void SceneJournal::Diff(ChangeSet* set)
+    {
+        Baseline& baseline = *m_baseline;
+        const uint64_t epoch = ++baseline.epoch;
+
+        std::vector<uint8_t> backward;
+        baseline.undoUnits.clear();
+
+        std::vector<uint8_t> scratch;
+        SnapshotWriter forwardWriter(set ? set->forward : scratch);
+        SnapshotWriter backwardWriter(backward);
+
+        // Every change's inverse is one unit, units are undone last to first
+        auto beginUndo = [&]() { baseline.undoUnits.emplace_back(backward.size(), 0); };
+        auto endUndo = [&]() { baseline.undoUnits.back().second = backward.size(); };
+
+        JournalStats& stats = m_stats;
+        stats.visitedNodes = stats.savedComponents = stats.addedNodes = stats.removedNodes = 0;
+        stats.modifiedNodes = stats.changedComponents = 0;
+
+        auto saveComponent = [&](const Component& component) {
+            ++stats.savedComponents;
+            return SceneSnapshot::SaveComponent(component, baseline.typeName, baseline.payload);
+        };
+
+        // Re-adds a remembered subtree, for the inverse of removing it
+        std::function<void(uint64_t)> writeRemembered = [&](uint64_t key) {
+            auto it = baseline.nodes.find(key);
+            if (it == baseline.nodes.end())
+                return;
+
+            const Baseline::NodeEntry& entry = it->second;
+            WriteAddNode(backwardWriter, entry.parent, entry.shared, entry.name, entry.state);
+            for (const Baseline::ComponentEntry& comp : entry.components)
+                WriteSetComponent(backwardWriter, key, comp.id, comp.typeName, comp.payload);
+            for (uint64_t child : entry.children)
+                writeRemembered(child);
+        };
+
+        std::function<void(uint64_t)> forget = [&](uint64_t key) {
+            auto it = baseline.nodes.find(key);
+            if (it == baseline.nodes.end())
+                return;
+
+            std::vector<uint64_t> children = std::move(it->second.children);
+            baseline.nodes.erase(it);
+            for (uint64_t child : children)
+                forget(child);
+        };
+
+        auto removeRemembered = [&](uint64_t key) {
+            if (set)
+            {
+                WriteRemoveNode(forwardWriter, key);
+                beginUndo();
+                writeRemembered(key);
+                endUndo();
+            }
+            forget(key);
+            ++stats.removedNodes;
+        };
+
+        std::function<void(const Node&, uint64_t, uint64_t, bool, bool)> addNew = [&](const Node& node, uint64_t key, uint64_t parentKey, bool shared, bool top) {
+            ++stats.visitedNodes;
+
+            Baseline::NodeEntry& entry = baseline.nodes[key];
+            entry = Baseline::NodeEntry();
+            entry.parent = parentKey;
+            entry.entity = node.GetEntity();
+            entry.shared = shared;
+            entry.name = node.GetName();
+            entry.state = CaptureState(node);
+            entry.revision = node.GetRevision();
+            entry.transformRevision = node.GetTransform().GetRevision();
+            entry.seen = epoch;
+
+            if (set)
+            {
+                WriteAddNode(forwardWriter, parentKey, shared, entry.name, entry.state);
+                if (top)
+                {
+                    beginUndo();
+                    WriteRemoveNode(backwardWriter, key);
+                    endUndo();
+                }
+            }
+
+            node.ForEachComponent([&](StringId compId, const std::shared_ptr<Component>& component) {
+                if (!saveComponent(*component))
+                    return;
+
+                Baseline::ComponentEntry& comp = entry.components.emplace_back();
+                comp.id = compId;
+                comp.component = component.get();
+                comp.revision = component->revision;
+                comp.typeName = baseline.typeName;
+                comp.payload = baseline.payload;
+
+                if (set)
+                    WriteSetComponent(forwardWriter, key, compId, comp.typeName, comp.payload);
+            });
+
+            node.ForEachChild([&](const std::shared_ptr<Node>& child) {
+                const uint64_t childKey = ChildKey(key, child->GetNameId());
+                entry.children.push_back(childKey);
+                addNew(*child, childKey, key, true, false);
+            });
+
+            ++stats.addedNodes;
+        };
+
+        // One component that may have changed, entry is null when it wasn't there before. Returns false when the
+        // component can't be saved. After a structural change a new component may sit where an old one was, so
+        // revisions are only trusted without one.
+        auto diffComponent = [&](uint64_t key, StringId compId, const Component& component, Baseline::ComponentEntry* entry,
+                                 bool structural, std::vector<Baseline::ComponentEntry>& out) {
+            if (entry && !structural && entry->revision == component.revision)
+            {
+                out.push_back(std::move(*entry));
+                return true;
+            }
+
+            if (!saveComponent(component))
+                return false;
+
+            Baseline::ComponentEntry& comp = out.emplace_back();
+            comp.id = compId;
+            comp.component = &component;
+            comp.revision = component.revision;
+
+            const bool same = entry && entry->typeName == baseline.typeName && entry->payload == baseline.payload;
+            if (same)
+            {
+                comp.typeName = std::move(entry->typeName);
+                comp.payload = std::move(entry->payload);
+                return true;
+            }
+
+            comp.typeName = baseline.typeName;
+            comp.payload = baseline.payload;
+            ++stats.changedComponents;
+
+            if (!set)
+                return true;
+
+            WriteSetComponent(forwardWriter, key, compId, comp.typeName, comp.payload);
+            beginUndo();
+            if (entry)
+                WriteSetComponent(backwardWriter, key, compId, entry->typeName, entry->payload);
+            else
+                WriteRemoveComponent(backwardWriter, key, compId);
+            endUndo();
+            return true;
+        };
+
+        std::vector<Baseline::ComponentEntry> components;
+        std::function<void(const Node&, uint64_t, uint64_t, bool)> visit = [&](const Node& node, uint64_t key, uint64_t parentKey, bool shared) {
+            auto it = baseline.nodes.find(key);
+            if (it != baseline.nodes.end() && it->second.entity != node.GetEntity())
+            {
+                removeRemembered(key);
+                it = baseline.nodes.end();
+            }
+
+            if (it == baseline.nodes.end())
+            {
+                addNew(node, key, parentKey, shared, true);
+                return;
+            }
+
+            ++stats.visitedNodes;
+            Baseline::NodeEntry& entry = it->second;
+            entry.seen = epoch;
+
+            const bool structural = entry.revision != node.GetRevision();
+            if (structural || entry.transformRevision != node.GetTransform().GetRevision())
+            {
+                const NodeState state = CaptureState(node);
+                if (!SameState(state, entry.state))
+                {
+                    if (set)
+                    {
+                        WriteSetNode(forwardWriter, key, state);
+                        beginUndo();
+                        WriteSetNode(backwardWriter, key, entry.state);
+                        endUndo();
+                    }
+                    entry.state = state;
+                    ++stats.modifiedNodes;
+                }
+
+                entry.revision = node.GetRevision();
+                entry.transformRevision = node.GetTransform().GetRevision();
+            }
+
+            // Without a structural change the same component objects are still there
+            components.clear();
+            node.ForEachComponent([&](StringId compId, const std::shared_ptr<Component>& component) {
+                auto found = std::find_if(entry.components.begin(), entry.components.end(), [compId](const Baseline::ComponentEntry& comp) {
+                    return comp.id == compId;
+                });
+
+                if (!structural && found == entry.components.end())
+                    return;
+
+                Baseline::ComponentEntry* previous = found == entry.components.end() ? nullptr : &*found;
+                if (diffComponent(key, compId, *component, previous, structural, components) && previous)
+                    previous->component = nullptr;
+            });
+
+            if (structural)
+            {
+                for (Baseline::ComponentEntry& comp : entry.components)
+                {
+                    if (!comp.component)
+                        continue;
+
+                    ++stats.changedComponents;
+                    if (set)
+                    {
+                        WriteRemoveComponent(forwardWriter, key, comp.id);
+                        beginUndo();
+                        WriteSetComponent(backwardWriter, key, comp.id, comp.typeName, comp.payload);
+                        endUndo();
+                    }
+                }
+                entry.children.clear();
+            }
+            entry.components.swap(components);
+
+            // entry stays valid, the map only gains and loses other nodes from here on
+            node.ForEachChild([&](const std::shared_ptr<Node>& child) {
+                const uint64_t childKey = ChildKey(key, child->GetNameId());
+                if (structural)
+                    entry.children.push_back(childKey);
+                visit(*child, childKey, key, true);
+            });
+        };
+
+        m_scene.ForEachRootNode([&](const Node& node, bool shared) {
+            visit(node, ChildKey(0, node.GetNameId()), 0, shared);
+        });
+
+        // Nodes not seen are gone, only the top of each removed subtree is journaled
+        baseline.gone.clear();
+        for (const auto& pair : baseline.nodes)
+        {
+            if (pair.second.seen == epoch)
+                continue;
+
+            auto parent = baseline.nodes.find(pair.second.parent);
+            if (pair.second.parent == 0 || (parent != baseline.nodes.end() && parent->second.seen == epoch))
+                baseline.gone.push_back(pair.first);
+        }
+
+        for (uint64_t key : baseline.gone)
+            removeRemembered(key);
+
+        for (auto it = baseline.nodes.begin(); it != baseline.nodes.end();)
+            it = it->second.seen == epoch ? std::next(it) : baseline.nodes.erase(it);
+
+        if (!set)
+            return;
+
+        for (auto unit = baseline.undoUnits.rbegin(); unit != baseline.undoUnits.rend(); ++unit)
+            set->backward.insert(set->backward.end(), backward.begin() + unit->first, backward.begin() + unit->second);
+    }
+
+    bool SceneJournal::Replay(Scene& scene, const std::string& path)
+    {
+        // A journal nothing was appended to yet is empty, which can't be mapped
+        std::error_code error;
+        if (std::filesystem::exists(path, error) && std::filesystem::file_size(path, error) == 0)
+            return true;
+
+        MappedFile file(path);
+        if (!file.IsOpen())
+            return false;
+
+        return ReplayFromMemory(scene, file.GetData(), file.GetSize(), path);
+    }
+
+    bool SceneJournal::ReplayFromMemory(Scene& scene, const uint8_t* data, size_t size, const std::string& source)
+    {
+        size_t offset = 0;
+        while (offset < size)
+        {
+            FrameHeader header{};
+            if (size - offset < sizeof(FrameHeader))
+            {
+                std::cerr << "[SceneJournal] Torn change set at the end ignored: " << source << std::endl;
+                break;
+            }
+
+            std::memcpy(&header, data + offset, sizeof(FrameHeader));
+            offset += sizeof(FrameHeader);
+
+            if (header.magic != FrameMagic || header.version != FrameVersion)
+            {
+                std::cerr << "[SceneJournal] Not a journal or unsupported version, the rest is ignored: " << source << std::endl;
+                break;
+            }
+
+            if (header.size > size - offset || HashBytes(data + offset, static_cast<size_t>(header.size)) != header.hash)
+            {
+                std::cerr << "[SceneJournal] Torn change set at the end ignored: " << source << std::endl;
+                break;
+            }
+
+            if (!Apply(scene, data + offset, static_cast<size_t>(header.size), false, source))
+                return false;
+            offset += static_cast<size_t>(header.size);
+        }
+        return true;
+    }
+
+    bool SceneJournal::Apply(Scene& scene, const uint8_t* data, size_t size, bool live, const std::string& source)
+    {
+        auto fail = [&source](const char* reason) {
+            std::cerr << "[SceneJournal] " << reason << ", the change set stopped part way: " << source << std::endl;
+            return false;
+        };
+
+        // Node and parent by key
+        std::unordered_map<uint64_t, std::pair<Node*, Node*>> nodes;
+        std::function<void(Node&, Node*, uint64_t)> index = [&](Node& node, Node* parent, uint64_t key) {
+            nodes[key] = { &node, parent };
+            node.ForEachChild([&](const std::shared_ptr<Node>& child) {
+                index(*child, &node, ChildKey(key, child->GetNameId()));
+            });
+        };
+
+        scene.ForEachRootNode([&](Node& node, bool) {
+            index(node, nullptr, ChildKey(0, node.GetNameId()));
+        });
+
+        std::function<void(Node&, uint64_t)> unindex = [&](Node& node, uint64_t key) {
+            nodes.erase(key);
+            node.ForEachChild([&](const std::shared_ptr<Node>& child) {
+                unindex(*child, ChildKey(key, child->GetNameId()));
+            });
+        };
+
+        // Added nodes get InitNode once their components and children are in
+        std::unordered_set<uint64_t> added;
+        std::vector<uint64_t> addedTops;
+
+        SnapshotReader reader(data, size);
+        while (reader.GetRemaining() > 0)
+        {
+            JournalOp op{};
+            uint64_t key = 0;
+            if (!reader.Read(op) || !reader.Read(key))
+                return fail("Truncated op");
+
+            if (op == JournalOp::AddNode)
+            {
+                uint8_t shared = 0;
+                std::string name;
+                NodeState state{};
+                if (!reader.Read(shared) || !reader.ReadString(name) || !reader.Read(state))
+                    return fail("Truncated op");
+                if (name.empty())
+                    return fail("Bad node name");
+
+                const StringId nameId(name);
+                const uint64_t nodeKey = ChildKey(key, nameId);
+                Node* parent = nullptr;
+                if (key != 0)
+                {
+                    auto it = nodes.find(key);
+                    if (it == nodes.end())
+                        return fail("Parent of an added node not found");
+                    parent = it->second.first;
+                }
+
+                Node* raw = nullptr;
+                if (parent)
+                {
+                    auto node = std::make_shared<Node>(name, scene.GetEntityStore());
+                    raw = node.get();
+                    if (!ApplyState(*raw, state))
+                        return fail("Bad node state");
+                    if (!parent->AddChild(std::move(node)))
+                        return fail("Duplicate child name");
+                }
+                else if (scene.FindNode(nameId))
+                    return fail("Duplicate top level node name");
+                else if (shared)
+                {
+                    auto node = std::make_shared<Node>(name, scene.GetEntityStore());
+                    raw = node.get();
+                    if (!ApplyState(*raw, state))
+                        return fail("Bad node state");
+                    scene.AddNodeShared(std::move(node));
+                }
+                else
+                {
+                    auto node = std::make_unique<Node>(name, scene.GetEntityStore());
+                    raw = node.get();
+                    if (!ApplyState(*raw, state))
+                        return fail("Bad node state");
+                    scene.AddNodeUnique(std::move(node));
+                }
+
+                nodes[nodeKey] = { raw, parent };
+                if (added.insert(nodeKey).second && added.find(key) == added.end())
+                    addedTops.push_back(nodeKey);
+                continue;
+            }
+
+            auto it = nodes.find(key);
+            if (it == nodes.end())
+                return fail("Node not found");
+            Node& node = *it->second.first;
+            Node* parent = it->second.second;
+
+            switch (op)
+            {
+            case JournalOp::RemoveNode:
+            {
+                const StringId nameId = node.GetNameId();
+                unindex(node, key);
+                if (!parent)
+                {
+                    if (live)
+                        scene.RemoveNode(nameId);
+                    else
+                        scene.DiscardNode(nameId);
+                }
+                else
+                {
+                    if (live)
+                        node.DeleteNode();
+                    parent->RemoveChild(nameId);
+                }
+                break;
+            }
+            case JournalOp::SetNode:
+            {
+                NodeState state{};
+                if (!reader.Read(state))
+                    return fail("Truncated op");
+                if (!ApplyState(node, state))
+                    return fail("Bad node state");
+                break;
+            }
+            case JournalOp::SetComponent:
+            {
+                std::string compName;
+                uint64_t compValue = 0;
+                std::string typeName;
+                uint32_t payloadSize = 0;
+                if (!reader.ReadString(compName) || !reader.Read(compValue) || !reader.ReadString(typeName) || !reader.Read(payloadSize))
+                    return fail("Truncated op");
+
+                const uint8_t* payload = reader.ReadBytes(payloadSize);
+                if (!payload)
+                    return fail("Truncated op");
+
+                const StringId compId = compName.empty() ? StringId::FromValue(compValue) : StringId::Intern(compName);
+                const bool init = live && added.find(key) == added.end();
+                if (std::shared_ptr<Component> old = node.GetComponent(compId))
+                {
+                    if (init)
+                        old->DeleteComponentData();
+                    node.RemoveComponent(compId);
+                }
+
+                if (!SceneSnapshot::LoadComponent(node, compId, typeName, payload, payloadSize))
+                    return fail("Bad component data");
+
+                if (init)
+                {
+                    if (std::shared_ptr<Component> component = node.GetComponent(compId))
+                        component->InitComponent();
+                }
+                break;
+            }
+            case JournalOp::RemoveComponent:
+            {
+                uint64_t compValue = 0;
+                if (!reader.Read(compValue))
+                    return fail("Truncated op");
+
+                const StringId compId = StringId::FromValue(compValue);
+                std::shared_ptr<Component> old = node.GetComponent(compId);
+                if (old && live && added.find(key) == added.end())
+                    old->DeleteComponentData();
+                node.RemoveComponent(compId);
+                break;
+            }
+            default:
+                return fail("Unknown op");
+            }
+        }
+
+        if (live)
+        {
+            for (uint64_t key : addedTops)
+            {
+                auto it = nodes.find(key);
+                if (it != nodes.end())
+                    it->second.first->InitNode();
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <deque>
+
+#include "Scene.h"
+
+namespace BSE
+{
+    struct DLL_EXPORT JournalSettings
+    {
+        // Change sets kept for Undo, the oldest are dropped past this
+        size_t maxUndo = 128;
+    };
+
+    struct JournalStats
+    {
+        // Of the last Record
+        size_t visitedNodes = 0;
+        size_t savedComponents = 0;
+        size_t addedNodes = 0;
+        size_t removedNodes = 0;
+        size_t modifiedNodes = 0;
+        size_t changedComponents = 0;
+        size_t changeSetBytes = 0;
+
+        // Waiting for the next AppendTo
+        size_t unsavedBytes = 0;
+    };
+
+    // Tracks what changed in a scene since a checkpoint. Record walks the node tree comparing revision counters
+    // against the state remembered at the last Record and only saves the nodes and components that moved,
+    // through the SceneSnapshot codecs, into a change set holding the changes and their inverse.
+    //
+    // Change sets drive Undo and Redo, and AppendTo writes the ones not yet written to the end of a journal file
+    // so an autosave costs as much as what changed. Replay brings a scene loaded from the checkpoint's snapshot
+    // up to date with such a file, a torn change set at the end from a crash is ignored.
+    //
+    // Components have to call MarkModified when state their codec saves changes, components without a codec are
+    // not tracked. The built-in components do so in their setters, code writing their public fields directly,
+    // such as a light's Color or a camera's Position, or moving a ModelComponent's model has to call it too.
+    // Nodes are told apart by their path of names, a node moved to another parent is journaled as removed and
+    // added again. Whether a node is asleep is not tracked.
+    class DLL_EXPORT SceneJournal
+    {
+    public:
+        explicit SceneJournal(Scene& scene, const JournalSettings& settings = JournalSettings());
+        ~SceneJournal();
+
+        SceneJournal(const SceneJournal&) = delete;
+        SceneJournal& operator=(const SceneJournal&) = delete;
+
+        // Remembers the scene as it is now, saving every component once, and forgets history and unsaved changes
+        void Checkpoint();
+
+        // Saves the scene as a snapshot, starts an empty journal file next to it and checkpoints
+        bool SaveCheckpoint(const std::string& snapshotPath, const std::string& journalPath);
+
+        // Main thread between updates. Makes a change set out of everything that changed since the last Record,
+        // returns false when nothing did.
+        bool Record();
+
+        // Nodes restored by Undo and Redo get InitNode, removed ones DeleteNode, like adding them by hand
+        bool Undo();
+        bool Redo();
+        bool CanUndo() const { return m_cursor > 0; }
+        bool CanRedo() const { return m_cursor < m_history.size(); }
+
+        // Appends the change sets recorded, undone or redone since the last call
+        bool AppendTo(const std::string& path);
+
+        // Applies every change set of a journal file, call InitScene afterwards as after SceneSnapshot::Load
+        static bool Replay(Scene& scene, const std::string& path);
+        static bool ReplayFromMemory(Scene& scene, const uint8_t* data, size_t size, const std::string& source = "memory");
+
+        void SetSettings(const JournalSettings& settings) { m_settings = settings; }
+        const JournalSettings& GetSettings() const { return m_settings; }
+        const JournalStats& GetStats() const { return m_stats; }
+
+    private:
+        struct ChangeSet
+        {
+            std::vector<uint8_t> forward;
+            std::vector<uint8_t> backward;
+        };
+
+        struct Baseline;
+
+        // Brings the baseline up to date with the scene, writing the differences when set is given
+        void Diff(ChangeSet* set);
+
+        // Ops of one change set, live scenes get InitNode and DeleteNode as nodes come and go
+        static bool Apply(Scene& scene, const uint8_t* data, size_t size, bool live, const std::string& source);
+
+        void QueueForFile(const std::vector<uint8_t>& ops);
+
+        Scene& m_scene;
+        JournalSettings m_settings;
+        JournalStats m_stats;
+
+        std::unique_ptr<Baseline> m_baseline;
+
+        // Change sets up to m_cursor are applied, the ones after it were undone
+        std::deque<ChangeSet> m_history;
+        size_t m_cursor = 0;
+
+        // Framed change sets waiting for AppendTo
+        std::vector<uint8_t> m_unsaved;
+    };
+}
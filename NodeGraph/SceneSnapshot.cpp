@@ -0,0 +1,654 @@
+#include "SceneSnapshot.h"
+#include "../Engine/MappedFile.h"
+
+#include <unordered_map>
+
+namespace BSE
+{
+    namespace
+    {
+        constexpr uint32_t SnapshotMagic = 0x53455342; // "BSES"
+
+        enum NodeFlags : uint32_t
+        {
+            NodeShared = 1u << 0,
+            NodeHasBounds = 1u << 1,
+            NodeAsleep = 1u << 2
+        };
+
+        // Offsets are from the start of the file, every section starts 8 byte aligned
+        struct FileHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t nodeCount;
+            uint32_t componentCount;
+            uint32_t typeCount;
+            uint32_t reserved;
+            uint64_t stringsOffset;
+            uint64_t stringsSize;
+            uint64_t typesOffset;
+            uint64_t nodesOffset;
+            uint64_t componentsOffset;
+            uint64_t payloadOffset;
+            uint64_t payloadSize;
+        };
+
+        // Into the string table
+        struct StringRef
+        {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        struct TypeRecord
+        {
+            StringRef name;
+        };
+
+        struct NodeRecord
+        {
+            // Index of an earlier record, -1 for top level nodes
+            int32_t parent;
+            uint32_t flags;
+            StringRef name;
+            uint32_t firstComponent;
+            uint32_t componentCount;
+
+            float position[3];
+            // w, x, y, z
+            float rotation[4];
+            float scale[3];
+            float boundsMin[3];
+            float boundsMax[3];
+
+            uint32_t updateRate;
+            uint32_t updateInterval;
+            float nearDistance;
+            float farDistance;
+        };
+
+        struct ComponentRecord
+        {
+            uint64_t id;
+            // Empty when the id's text was not known at save time
+            StringRef name;
+            uint32_t type;
+            uint32_t reserved;
+            // Into the payload section
+            uint64_t payloadOffset;
+            uint64_t payloadSize;
+        };
+
+        static_assert(std::is_trivially_copyable_v<FileHeader> && sizeof(FileHeader) % 8 == 0);
+        static_assert(std::is_trivially_copyable_v<TypeRecord> && sizeof(TypeRecord) % 8 == 0);
+        static_assert(std::is_trivially_copyable_v<NodeRecord> && sizeof(NodeRecord) % 8 == 0);
+        static_assert(std::is_trivially_copyable_v<ComponentRecord> && sizeof(ComponentRecord) % 8 == 0);
+
+        void PadTo8(std::vector<uint8_t>& bytes)
+        {
+            bytes.resize((bytes.size() + 7) & ~size_t(7), 0);
+        }
+
+        template<typename T>
+        uint64_t AppendSection(std::vector<uint8_t>& file, const std::vector<T>& records)
+        {
+            PadTo8(file);
+            const uint64_t offset = file.size();
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(records.data());
+            file.insert(file.end(), bytes, bytes + records.size() * sizeof(T));
+            return offset;
+        }
+
+        // Section lies inside the file and can be read in place
+        bool SectionFits(uint64_t offset, uint64_t count, uint64_t stride, size_t size)
+        {
+            if (offset % 8 != 0 || offset > size)
+                return false;
+            return stride == 0 || count <= (size - offset) / stride;
+        }
+
+        class StringTable
+        {
+        public:
+            StringRef Add(std::string_view text)
+            {
+                if (text.empty())
+                    return StringRef{ 0, 0 };
+
+                auto it = m_offsets.find(std::string(text));
+                if (it != m_offsets.end())
+                    return StringRef{ it->second, static_cast<uint32_t>(text.size()) };
+
+                const uint32_t offset = static_cast<uint32_t>(m_bytes.size());
+                m_bytes.insert(m_bytes.end(), text.begin(), text.end());
+                m_offsets.emplace(std::string(text), offset);
+                return StringRef{ offset, static_cast<uint32_t>(text.size()) };
+            }
+
+            const std::vector<uint8_t>& GetBytes() const { return m_bytes; }
+
+        private:
+            std::vector<uint8_t> m_bytes;
+            std::unordered_map<std::string, uint32_t> m_offsets;
+        };
+    }
+
+    // Codecs are shared so loads and saves can run them without holding the lock
+    struct SceneSnapshot::Registry
+    {
+        std::mutex mutex;
+        std::unordered_map<TypeId, std::shared_ptr<const ComponentCodec>> byType;
+        std::unordered_map<std::string, std::shared_ptr<const ComponentCodec>> byName;
+
+        std::shared_ptr<const ComponentCodec> Find(TypeId type)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = byType.find(type);
+            return it == byType.end() ? nullptr : it->second;
+        }
+
+        std::shared_ptr<const ComponentCodec> Find(const std::string& typeName)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = byName.find(typeName);
+            return it == byName.end() ? nullptr : it->second;
+        }
+    };
+
+    SceneSnapshot::Registry& SceneSnapshot::GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    void SceneSnapshot::AddCodec(ComponentCodec codec)
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        auto named = registry.byName.find(codec.typeName);
+        if (named != registry.byName.end() && named->second->type != codec.type)
+        {
+            std::cerr << "[SceneSnapshot] Component type name registered twice: " << codec.typeName << std::endl;
+            return;
+        }
+
+        auto shared = std::make_shared<const ComponentCodec>(std::move(codec));
+        auto typed = registry.byType.find(shared->type);
+        if (typed != registry.byType.end() && typed->second->typeName != shared->typeName)
+            registry.byName.erase(typed->second->typeName);
+
+        registry.byType[shared->type] = shared;
+        registry.byName[shared->typeName] = shared;
+    }
+
+    bool SceneSnapshot::IsRegistered(TypeId type)
+    {
+        return GetRegistry().Find(type) != nullptr;
+    }
+
+    bool SceneSnapshot::SaveComponent(const Component& component, std::string& typeName, std::vector<uint8_t>& payload)
+    {
+        std::shared_ptr<const ComponentCodec> codec = GetRegistry().Find(component.componentType);
+        if (!codec)
+            return false;
+
+        typeName = codec->typeName;
+        payload.clear();
+        SnapshotWriter writer(payload);
+        codec->save(component, writer);
+        return true;
+    }
+
+    bool SceneSnapshot::LoadComponent(Node& node, StringId compId, const std::string& typeName, const uint8_t* data, size_t size)
+    {
+        std::shared_ptr<const ComponentCodec> codec = GetRegistry().Find(typeName);
+        if (!codec)
+        {
+            std::cerr << "[SceneSnapshot] No codec for component type '" << typeName << "'" << std::endl;
+            return false;
+        }
+
+        SnapshotReader reader(data, size);
+        return codec->load(node, compId, reader, nullptr);
+    }
+
+    bool SceneSnapshot::Save(const Scene& scene, const std::string& path)
+    {
+        Registry& registry = GetRegistry();
+
+        StringTable strings;
+        std::vector<TypeRecord> types;
+        std::unordered_map<TypeId, uint32_t> typeIndices;
+        std::vector<NodeRecord> nodes;
+        std::vector<ComponentRecord> components;
+        std::vector<uint8_t> payload;
+
+        // Preorder, so parents always come before their children and a node's components are contiguous
+        std::function<void(const Node&, int32_t, bool)> writeNode = [&](const Node& node, int32_t parent, bool shared) {
+            NodeRecord record{};
+            record.parent = parent;
+            record.name = strings.Add(node.GetName());
+            record.firstComponent = static_cast<uint32_t>(components.size());
+
+            const Transform& transform = node.GetTransform();
+            const glm::vec3& position = transform.GetPosition();
+            const glm::quat& rotation = transform.GetRotation();
+            const glm::vec3& scale = transform.GetScale();
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                record.position[axis] = position[axis];
+                record.scale[axis] = scale[axis];
+            }
+            record.rotation[0] = rotation.w;
+            record.rotation[1] = rotation.x;
+            record.rotation[2] = rotation.y;
+            record.rotation[3] = rotation.z;
+
+            if (const std::optional<AABB>& bounds = node.GetBounds())
+            {
+                record.flags |= NodeHasBounds;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    record.boundsMin[axis] = bounds->min[axis];
+                    record.boundsMax[axis] = bounds->max[axis];
+                }
+            }
+
+            if (shared)
+                record.flags |= NodeShared;
+            if (node.IsAsleep())
+                record.flags |= NodeAsleep;
+
+            const UpdatePolicy& policy = node.GetUpdatePolicy();
+            record.updateRate = static_cast<uint32_t>(policy.rate);
+            record.updateInterval = policy.interval;
+            record.nearDistance = policy.nearDistance;
+            record.farDistance = policy.farDistance;
+
+            node.ForEachComponent([&](StringId compId, const std::shared_ptr<Component>& component) {
+                std::shared_ptr<const ComponentCodec> codec = registry.Find(component->componentType);
+                if (!codec)
+                {
+                    std::cerr << "[SceneSnapshot] No codec for component '" << compId.GetString() << "' on node '"
+                              << node.GetName() << "', skipped" << std::endl;
+                    return;
+                }
+
+                auto typeIt = typeIndices.find(codec->type);
+                if (typeIt == typeIndices.end())
+                {
+                    typeIt = typeIndices.emplace(codec->type, static_cast<uint32_t>(types.size())).first;
+                    types.push_back(TypeRecord{ strings.Add(codec->typeName) });
+                }
+
+                // Payloads start aligned so loaders may read plain arrays out of them in place
+                PadTo8(payload);
+                ComponentRecord compRecord{};
+                compRecord.id = compId.GetValue();
+                compRecord.name = strings.Add(compId.GetString());
+                compRecord.type = typeIt->second;
+                compRecord.payloadOffset = payload.size();
+
+                SnapshotWriter writer(payload);
+                codec->save(*component, writer);
+                compRecord.payloadSize = payload.size() - compRecord.payloadOffset;
+                components.push_back(compRecord);
+            });
+
+            record.componentCount = static_cast<uint32_t>(components.size()) - record.firstComponent;
+            nodes.push_back(record);
+
+            const int32_t index = static_cast<int32_t>(nodes.size() - 1);
+            node.ForEachChild([&](const std::shared_ptr<Node>& child) {
+                writeNode(*child, index, false);
+            });
+        };
+
+        scene.ForEachRootNode([&](const Node& node, bool shared) {
+            writeNode(node, -1, shared);
+        });
+
+        FileHeader header{};
+        header.magic = SnapshotMagic;
+        header.version = Version;
+        header.nodeCount = static_cast<uint32_t>(nodes.size());
+        header.componentCount = static_cast<uint32_t>(components.size());
+        header.typeCount = static_cast<uint32_t>(types.size());
+
+        std::vector<uint8_t> file(sizeof(FileHeader), 0);
+        header.stringsOffset = AppendSection(file, strings.GetBytes());
+        header.stringsSize = strings.GetBytes().size();
+        header.typesOffset = AppendSection(file, types);
+        header.nodesOffset = AppendSection(file, nodes);
+        header.componentsOffset = AppendSection(file, components);
+        header.payloadOffset = AppendSection(file, payload);
+        header.payloadSize = payload.size();
+        std::memcpy(file.data(), &header, sizeof(FileHeader));
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cerr << "[SceneSnapshot] Failed to open file for writing: " << path << std::endl;
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+        if (!out)
+        {
+            std::cerr << "[SceneSnapshot] Failed to write file: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool SceneSnapshot::Load(Scene& scene, const std::string& path)
+    {
+        MappedFile file(path);
+        if (!file.IsOpen())
+            return false;
+
+        return LoadFromMemory(scene, file.GetData(), file.GetSize(), path);
+    }
+
+    bool SceneSnapshot::LoadFromMemory(Scene& scene, const uint8_t* data, size_t size, const std::string& source)
+    {
+        std::vector<std::unique_ptr<Node>> uniqueRoots;
+        std::vector<std::shared_ptr<Node>> sharedRoots;
+        if (!BuildNodes(scene.GetEntityStore(), data, size, source, false, uniqueRoots, sharedRoots))
+            return false;
+
+        for (std::unique_ptr<Node>& node : uniqueRoots)
+            scene.AddNodeUnique(std::move(node));
+        for (std::shared_ptr<Node>& node : sharedRoots)
+            scene.AddNodeShared(std::move(node));
+        return true;
+    }
+
+    bool SceneSnapshot::Instantiate(EntityStore& store, const uint8_t* data, size_t size, std::vector<std::shared_ptr<Node>>& roots,
+                                    const std::string& source)
+    {
+        std::vector<std::unique_ptr<Node>> uniqueRoots;
+        std::vector<std::shared_ptr<Node>> sharedRoots;
+        if (!BuildNodes(store, data, size, source, true, uniqueRoots, sharedRoots))
+            return false;
+
+        roots.insert(roots.end(), std::make_move_iterator(sharedRoots.begin()), std::make_move_iterator(sharedRoots.end()));
+        return true;
+    }
+
+    struct SceneSnapshot::Layout
+    {
+        const FileHeader* header = nullptr;
+        const char* strings = nullptr;
+        const TypeRecord* types = nullptr;
+        const NodeRecord* nodes = nullptr;
+        const ComponentRecord* components = nullptr;
+        const uint8_t* payload = nullptr;
+
+        // Resolved once per type rather than per component, empty for types without a codec
+        std::vector<std::shared_ptr<const ComponentCodec>> codecs;
+        std::string source;
+
+        std::string_view View(const StringRef& ref) const { return std::string_view(strings + ref.offset, ref.length); }
+    };
+
+    bool SceneSnapshot::ReadLayout(const uint8_t* data, size_t size, const std::string& source, Layout& layout)
+    {
+        auto fail = [&source](const char* reason) {
+            std::cerr << "[SceneSnapshot] " << reason << ": " << source << std::endl;
+            return false;
+        };
+
+        if (!data || size < sizeof(FileHeader))
+            return fail("Truncated snapshot");
+        if (reinterpret_cast<uintptr_t>(data) % 8 != 0)
+            return fail("Snapshot data is not 8 byte aligned");
+
+        const FileHeader& header = *reinterpret_cast<const FileHeader*>(data);
+        if (header.magic != SnapshotMagic)
+            return fail("Not a scene snapshot");
+        if (header.version != Version)
+            return fail("Unsupported snapshot version");
+
+        if (header.stringsOffset > size || header.stringsSize > size - header.stringsOffset
+            || !SectionFits(header.typesOffset, header.typeCount, sizeof(TypeRecord), size)
+            || !SectionFits(header.nodesOffset, header.nodeCount, sizeof(NodeRecord), size)
+            || !SectionFits(header.componentsOffset, header.componentCount, sizeof(ComponentRecord), size)
+            || header.payloadOffset > size || header.payloadSize > size - header.payloadOffset)
+            return fail("Snapshot sections out of range");
+
+        // The only fix-ups, each table is used in place from here on
+        layout.header = &header;
+        layout.strings = reinterpret_cast<const char*>(data + header.stringsOffset);
+        layout.types = reinterpret_cast<const TypeRecord*>(data + header.typesOffset);
+        layout.nodes = reinterpret_cast<const NodeRecord*>(data + header.nodesOffset);
+        layout.components = reinterpret_cast<const ComponentRecord*>(data + header.componentsOffset);
+        layout.payload = data + header.payloadOffset;
+        layout.source = source;
+
+        auto validString = [&header](const StringRef& ref) {
+            return ref.offset <= header.stringsSize && ref.length <= header.stringsSize - ref.offset;
+        };
+
+        Registry& registry = GetRegistry();
+        layout.codecs.assign(header.typeCount, nullptr);
+        for (uint32_t i = 0; i < header.typeCount; ++i)
+        {
+            if (!validString(layout.types[i].name))
+                return fail("Bad component type name");
+
+            const std::string typeName(layout.View(layout.types[i].name));
+            layout.codecs[i] = registry.Find(typeName);
+            if (!layout.codecs[i])
+                std::cerr << "[SceneSnapshot] No codec for component type '" << typeName << "', its components are skipped: " << source << std::endl;
+        }
+
+        for (uint32_t i = 0; i < header.nodeCount; ++i)
+        {
+            const NodeRecord& record = layout.nodes[i];
+            if (record.parent >= static_cast<int32_t>(i) || record.parent < -1)
+                return fail("Node stored before its parent");
+            if (!validString(record.name) || record.name.length == 0)
+                return fail("Bad node name");
+            if (record.firstComponent > header.componentCount || record.componentCount > header.componentCount - record.firstComponent)
+                return fail("Node components out of range");
+            if (record.updateRate > static_cast<uint32_t>(UpdateRate::Dormant))
+                return fail("Bad update policy");
+        }
+
+        for (uint32_t c = 0; c < header.componentCount; ++c)
+        {
+            const ComponentRecord& compRecord = layout.components[c];
+            if (compRecord.type >= header.typeCount || !validString(compRecord.name)
+                || compRecord.payloadOffset > header.payloadSize || compRecord.payloadSize > header.payloadSize - compRecord.payloadOffset)
+                return fail("Bad component record");
+        }
+        return true;
+    }
+
+    bool SceneSnapshot::FillNode(const Layout& layout, uint32_t index, Node& node, const std::vector<std::shared_ptr<void>>* prepared)
+    {
+        const NodeRecord& record = layout.nodes[index];
+
+        Transform& transform = node.GetTransform();
+        transform.SetPosition(glm::vec3(record.position[0], record.position[1], record.position[2]));
+        transform.SetRotation(glm::quat(record.rotation[0], record.rotation[1], record.rotation[2], record.rotation[3]));
+        transform.SetScale(glm::vec3(record.scale[0], record.scale[1], record.scale[2]));
+
+        if (record.flags & NodeHasBounds)
+        {
+            node.SetBounds(AABB{ glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]),
+                                 glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]) });
+        }
+
+        UpdatePolicy policy;
+        policy.rate = static_cast<UpdateRate>(record.updateRate);
+        policy.interval = std::max(record.updateInterval, 1u);
+        policy.nearDistance = record.nearDistance;
+        policy.farDistance = record.farDistance;
+        node.SetUpdatePolicy(policy);
+        if (record.flags & NodeAsleep)
+            node.Sleep();
+        else
+            node.Wake();
+
+        for (uint32_t c = record.firstComponent; c < record.firstComponent + record.componentCount; ++c)
+        {
+            const ComponentRecord& compRecord = layout.components[c];
+            const ComponentCodec* codec = layout.codecs[compRecord.type].get();
+            if (!codec)
+                continue;
+
+            const StringId compId = compRecord.name.length > 0 ? StringId::Intern(layout.View(compRecord.name)) : StringId::FromValue(compRecord.id);
+            SnapshotReader reader(layout.payload + compRecord.payloadOffset, static_cast<size_t>(compRecord.payloadSize));
+            if (!codec->load(node, compId, reader, prepared ? &(*prepared)[c] : nullptr))
+            {
+                std::cerr << "[SceneSnapshot] Bad component data on node '" << node.GetName() << "': " << layout.source << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SceneSnapshot::BuildNodes(EntityStore& store, const uint8_t* data, size_t size, const std::string& source, bool allShared,
+                                   std::vector<std::unique_ptr<Node>>& uniqueRoots, std::vector<std::shared_ptr<Node>>& sharedRoots)
+    {
+        Layout layout;
+        if (!ReadLayout(data, size, source, layout))
+            return false;
+
+        const uint32_t nodeCount = layout.header->nodeCount;
+        std::vector<std::unique_ptr<Node>> uniqueNodes(nodeCount);
+        std::vector<std::shared_ptr<Node>> sharedNodes(nodeCount);
+        std::vector<Node*> built(nodeCount, nullptr);
+        std::vector<uint32_t> roots;
+
+        for (uint32_t i = 0; i < nodeCount; ++i)
+        {
+            const NodeRecord& record = layout.nodes[i];
+            const std::string name(layout.View(record.name));
+            if (record.parent < 0 && (record.flags & NodeShared) == 0 && !allShared)
+            {
+                uniqueNodes[i] = std::make_unique<Node>(name, store);
+                built[i] = uniqueNodes[i].get();
+            }
+            else
+            {
+                sharedNodes[i] = std::make_shared<Node>(name, store);
+                built[i] = sharedNodes[i].get();
+            }
+
+            if (!FillNode(layout, i, *built[i], nullptr))
+                return false;
+
+            if (record.parent < 0)
+                roots.push_back(i);
+            else if (!built[record.parent]->AddChild(sharedNodes[i]))
+            {
+                std::cerr << "[SceneSnapshot] Duplicate child name: " << source << std::endl;
+                return false;
+            }
+        }
+
+        for (uint32_t i : roots)
+        {
+            if (uniqueNodes[i])
+                uniqueRoots.push_back(std::move(uniqueNodes[i]));
+            else
+                sharedRoots.push_back(std::move(sharedNodes[i]));
+        }
+        return true;
+    }
+
+    StagedSnapshot::StagedSnapshot() = default;
+    StagedSnapshot::~StagedSnapshot() = default;
+
+    bool StagedSnapshot::Prepare(const uint8_t* data, size_t size, const std::string& source)
+    {
+        Reset();
+
+        auto layout = std::make_unique<SceneSnapshot::Layout>();
+        if (!SceneSnapshot::ReadLayout(data, size, source, *layout))
+            return false;
+
+        const uint32_t componentCount = layout->header->componentCount;
+        m_prepared.assign(componentCount, nullptr);
+        for (uint32_t c = 0; c < componentCount; ++c)
+        {
+            const ComponentRecord& compRecord = layout->components[c];
+            const SceneSnapshot::ComponentCodec* codec = layout->codecs[compRecord.type].get();
+            if (!codec || !codec->prepare)
+                continue;
+
+            SnapshotReader reader(layout->payload + compRecord.payloadOffset, static_cast<size_t>(compRecord.payloadSize));
+            m_prepared[c] = codec->prepare(reader);
+        }
+
+        m_nodes.assign(layout->header->nodeCount, nullptr);
+        m_layout = std::move(layout);
+        return true;
+    }
+
+    bool StagedSnapshot::Step(EntityStore& store, std::vector<std::shared_ptr<Node>>& roots, const std::chrono::steady_clock::time_point& deadline)
+    {
+        if (!m_layout)
+            return true;
+
+        const uint32_t nodeCount = m_layout->header->nodeCount;
+        while (m_nextNode < nodeCount)
+        {
+            const uint32_t i = m_nextNode++;
+            const NodeRecord& record = m_layout->nodes[i];
+
+            // Every root ends the subtree of the one before it
+            if (record.parent < 0 && m_pendingRoot < nodeCount)
+            {
+                if (m_nodes[m_pendingRoot])
+                    roots.push_back(m_nodes[m_pendingRoot]);
+                m_pendingRoot = NoRoot;
+            }
+
+            if (record.parent < 0)
+                m_pendingRoot = i;
+
+            const bool parentBuilt = record.parent < 0 || m_nodes[record.parent];
+            if (parentBuilt)
+            {
+                auto node = std::make_shared<Node>(std::string(m_layout->View(record.name)), store);
+                if (!SceneSnapshot::FillNode(*m_layout, i, *node, &m_prepared))
+                    node.reset();
+                else if (record.parent >= 0 && !m_nodes[record.parent]->AddChild(node))
+                {
+                    std::cerr << "[SceneSnapshot] Duplicate child name, dropped: " << node->GetName() << std::endl;
+                    node.reset();
+                }
+                m_nodes[i] = std::move(node);
+            }
+
+            for (uint32_t c = record.firstComponent; c < record.firstComponent + record.componentCount; ++c)
+                m_prepared[c].reset();
+
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+        }
+
+        if (m_nextNode < nodeCount)
+            return false;
+
+        if (m_pendingRoot < nodeCount && m_nodes[m_pendingRoot])
+            roots.push_back(m_nodes[m_pendingRoot]);
+        Reset();
+        return true;
+    }
+
+    void StagedSnapshot::Reset()
+    {
+        m_layout.reset();
+        m_prepared.clear();
+        m_nodes.clear();
+        m_nextNode = 0;
+        m_pendingRoot = NoRoot;
+    }
+}
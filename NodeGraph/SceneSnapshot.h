@@ -0,0 +1,252 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <cstring>
+
+#include "Scene.h"
+
+namespace BSE
+{
+    // Appends plain values to a component's payload, values are stored in native layout
+    class DLL_EXPORT SnapshotWriter
+    {
+    public:
+        explicit SnapshotWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+        template<typename T>
+        void Write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be written");
+            WriteBytes(&value, sizeof(T));
+        }
+
+        void WriteBytes(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            m_out.insert(m_out.end(), bytes, bytes + size);
+        }
+
+        void WriteString(std::string_view text)
+        {
+            Write(static_cast<uint32_t>(text.size()));
+            WriteBytes(text.data(), text.size());
+        }
+
+    private:
+        std::vector<uint8_t>& m_out;
+    };
+
+    // Reads a payload back in the order it was written, reads past the end fail and leave Failed() set
+    class DLL_EXPORT SnapshotReader
+    {
+    public:
+        SnapshotReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+        template<typename T>
+        bool Read(T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be read");
+            const uint8_t* bytes = ReadBytes(sizeof(T));
+            if (!bytes)
+                return false;
+
+            std::memcpy(&value, bytes, sizeof(T));
+            return true;
+        }
+
+        // Points into the snapshot, valid while it is being loaded
+        const uint8_t* ReadBytes(size_t size)
+        {
+            if (m_failed || size > m_size - m_offset)
+            {
+                m_failed = true;
+                return nullptr;
+            }
+
+            const uint8_t* bytes = m_data + m_offset;
+            m_offset += size;
+            return bytes;
+        }
+
+        bool ReadString(std::string& text)
+        {
+            uint32_t length = 0;
+            if (!Read(length))
+                return false;
+
+            const uint8_t* bytes = ReadBytes(length);
+            if (!bytes)
+                return false;
+
+            text.assign(reinterpret_cast<const char*>(bytes), length);
+            return true;
+        }
+
+        bool Failed() const { return m_failed; }
+        size_t GetRemaining() const { return m_size - m_offset; }
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_offset = 0;
+        bool m_failed = false;
+    };
+
+    // Versioned binary scene files. Nodes are stored as a flat array of fixed size records in parent before
+    // child order, with names in a shared string table and component state as opaque payloads. Load maps the
+    // file and reads records in place, turning offsets into pointers once per table instead of parsing text.
+    //
+    // Components are saved through codecs registered per type, components without one are skipped with a
+    // warning. Loaded nodes are plain Nodes, call InitScene afterwards as for scenes built in code.
+    class DLL_EXPORT SceneSnapshot
+    {
+    public:
+        static constexpr uint32_t Version = 1;
+
+        // save writes the component's state, load builds a component from it and returns nullptr on bad data.
+        // typeName identifies the type in files and must stay stable across builds.
+        template<typename T>
+        static void RegisterComponent(const std::string& typeName,
+                                      std::function<void(const T&, SnapshotWriter&)> save,
+                                      std::function<std::shared_ptr<T>(SnapshotReader&)> load)
+        {
+            static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+
+            ComponentCodec codec;
+            codec.typeName = typeName;
+            codec.type = GetTypeId<T>();
+            codec.save = [save = std::move(save)](const Component& component, SnapshotWriter& writer) {
+                save(static_cast<const T&>(component), writer);
+            };
+            codec.load = [load = std::move(load)](Node& node, StringId compId, SnapshotReader& reader, const std::shared_ptr<void>*) {
+                std::shared_ptr<T> component = load(reader);
+                return component && !reader.Failed() && node.AddComponent(std::move(component), compId);
+            };
+            AddCodec(std::move(codec));
+        }
+
+        // Same with the slow part of loading split off into prepare, such as reading and decoding asset files.
+        // prepare may run on any thread ahead of load, StagedSnapshot::Prepare runs it, and must not touch GL, AL
+        // or the scene. Both read the payload from its start. load gets prepare's result, which is nullptr when
+        // prepare failed, and runs prepare itself right before when the snapshot was not prepared ahead.
+        template<typename T, typename Prepared>
+        static void RegisterComponent(const std::string& typeName,
+                                      std::function<void(const T&, SnapshotWriter&)> save,
+                                      std::function<std::shared_ptr<Prepared>(SnapshotReader&)> prepare,
+                                      std::function<std::shared_ptr<T>(SnapshotReader&, Prepared*)> load)
+        {
+            static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+
+            ComponentCodec codec;
+            codec.typeName = typeName;
+            codec.type = GetTypeId<T>();
+            codec.save = [save = std::move(save)](const Component& component, SnapshotWriter& writer) {
+                save(static_cast<const T&>(component), writer);
+            };
+            codec.prepare = [prepare](SnapshotReader& reader) -> std::shared_ptr<void> {
+                return prepare(reader);
+            };
+            codec.load = [prepare, load = std::move(load)](Node& node, StringId compId, SnapshotReader& reader, const std::shared_ptr<void>* prepared) {
+                std::shared_ptr<void> preparedHere;
+                if (!prepared)
+                {
+                    SnapshotReader ahead = reader;
+                    preparedHere = prepare(ahead);
+                    prepared = &preparedHere;
+                }
+
+                std::shared_ptr<T> component = load(reader, static_cast<Prepared*>(prepared->get()));
+                return component && !reader.Failed() && node.AddComponent(std::move(component), compId);
+            };
+            AddCodec(std::move(codec));
+        }
+
+        static bool IsRegistered(TypeId type);
+
+        static bool Save(const Scene& scene, const std::string& path);
+        // Adds the file's top level nodes to scene, nothing is added when the file is invalid
+        static bool Load(Scene& scene, const std::string& path);
+
+        // Same as Load on a snapshot already in memory, data must be 8 byte aligned
+        static bool LoadFromMemory(Scene& scene, const uint8_t* data, size_t size, const std::string& source = "memory");
+
+        // Builds the top level nodes without adding them to a scene, all of them as shared nodes. Runs on the
+        // thread that owns store since the nodes are created in it. roots is left untouched on failure.
+        static bool Instantiate(EntityStore& store, const uint8_t* data, size_t size, std::vector<std::shared_ptr<Node>>& roots,
+                                const std::string& source = "memory");
+
+        // A single component's payload, for formats built on top of snapshots such as SceneJournal. SaveComponent
+        // replaces payload and returns false when the component's type has no codec.
+        static bool SaveComponent(const Component& component, std::string& typeName, std::vector<uint8_t>& payload);
+        static bool LoadComponent(Node& node, StringId compId, const std::string& typeName, const uint8_t* data, size_t size);
+
+    private:
+        friend class StagedSnapshot;
+
+        struct ComponentCodec
+        {
+            std::string typeName;
+            TypeId type = 0;
+            std::function<void(const Component&, SnapshotWriter&)> save;
+            // Empty for codecs registered without a prepare step
+            std::function<std::shared_ptr<void>(SnapshotReader&)> prepare;
+            // prepared is nullptr when the component was not prepared ahead
+            std::function<bool(Node&, StringId, SnapshotReader&, const std::shared_ptr<void>* prepared)> load;
+        };
+
+        struct Registry;
+        // Tables of a checked snapshot, read in place
+        struct Layout;
+
+        static Registry& GetRegistry();
+        static void AddCodec(ComponentCodec codec);
+
+        // Checks every section and record up front, so building only fails on component data or duplicate names
+        static bool ReadLayout(const uint8_t* data, size_t size, const std::string& source, Layout& layout);
+        // Fills in node index's state and components, prepared holds one entry per component record when given
+        static bool FillNode(const Layout& layout, uint32_t index, Node& node, const std::vector<std::shared_ptr<void>>* prepared);
+
+        // Top level nodes saved as unique go to uniqueRoots unless allShared is set
+        static bool BuildNodes(EntityStore& store, const uint8_t* data, size_t size, const std::string& source, bool allShared,
+                               std::vector<std::unique_ptr<Node>>& uniqueRoots, std::vector<std::shared_ptr<Node>>& sharedRoots);
+    };
+
+    // A snapshot turned into nodes over several calls, so a big file doesn't stall the thread building it.
+    // Prepare checks the file and runs the codecs' prepare steps, it only reads data and may run on any thread.
+    // Step then builds nodes on the thread owning the store until its deadline passed.
+    class DLL_EXPORT StagedSnapshot
+    {
+    public:
+        StagedSnapshot();
+        ~StagedSnapshot();
+
+        StagedSnapshot(const StagedSnapshot&) = delete;
+        StagedSnapshot& operator=(const StagedSnapshot&) = delete;
+
+        // data must stay valid and unchanged until the last Step, 8 byte aligned as for LoadFromMemory
+        bool Prepare(const uint8_t* data, size_t size, const std::string& source = "memory");
+
+        // Builds nodes in file order, at least one per call, and appends each top level node to roots as a shared
+        // node once its subtree is complete. A node whose component fails to load is dropped with its subtree.
+        // Returns true once every node was built, or right away when nothing was prepared.
+        bool Step(EntityStore& store, std::vector<std::shared_ptr<Node>>& roots, const std::chrono::steady_clock::time_point& deadline);
+
+        bool IsPrepared() const { return m_layout != nullptr; }
+
+        // Drops the prepared data and every node built so far that was not handed out yet
+        void Reset();
+
+    private:
+        static constexpr uint32_t NoRoot = 0xFFFFFFFFu;
+
+        std::unique_ptr<SceneSnapshot::Layout> m_layout;
+        // One entry per component record, released once its node was built
+        std::vector<std::shared_ptr<void>> m_prepared;
+        // Built nodes by record index, children may name any earlier record as parent
+        std::vector<std::shared_ptr<Node>> m_nodes;
+        uint32_t m_nextNode = 0;
+        uint32_t m_pendingRoot = NoRoot;
+    };
+}
@@ -0,0 +1,323 @@
+#include "SceneStreamer.h"
+
+namespace BSE
+{
+    SceneStreamer::SceneStreamer(Scene& scene, ThreadPool* pool, const StreamingSettings& settings)
+        : m_scene(scene)
+        , m_pool(pool)
+    {
+        SetSettings(settings);
+    }
+
+    SceneStreamer::~SceneStreamer()
+    {
+        UnloadAll();
+    }
+
+    void SceneStreamer::SetSettings(const StreamingSettings& settings)
+    {
+        m_settings = settings;
+        m_settings.cellSize = std::max(m_settings.cellSize, 0.001f);
+        m_settings.loadRadius = std::max(m_settings.loadRadius, 0.0f);
+        m_settings.unloadRadius = std::max(m_settings.unloadRadius, m_settings.loadRadius);
+        m_settings.maxLoadsInFlight = std::max(m_settings.maxLoadsInFlight, 1u);
+    }
+
+    void SceneStreamer::RegisterCell(const CellCoord& coord, CellSource source)
+    {
+        Cell& cell = m_cells[coord];
+        cell.source = std::move(source);
+        cell.registered = true;
+    }
+
+    void SceneStreamer::UnregisterCell(const CellCoord& coord)
+    {
+        auto it = m_cells.find(coord);
+        if (it == m_cells.end())
+            return;
+
+        // Resident cells unload through Update first
+        if (it->second.state == CellState::Unloaded)
+            m_cells.erase(it);
+        else
+            it->second.registered = false;
+    }
+
+    CellCoord SceneStreamer::GetCell(const glm::vec3& position) const
+    {
+        return CellCoord{ static_cast<int32_t>(std::floor(position.x / m_settings.cellSize)),
+                          static_cast<int32_t>(std::floor(position.z / m_settings.cellSize)) };
+    }
+
+    bool SceneStreamer::IsActive(const CellCoord& coord) const
+    {
+        auto it = m_cells.find(coord);
+        return it != m_cells.end() && it->second.state == CellState::Active;
+    }
+
+    float SceneStreamer::DistanceTo(const CellCoord& coord, const glm::vec3& camera) const
+    {
+        // Horizontal distance to the closest point of the cell
+        const float minX = static_cast<float>(coord.x) * m_settings.cellSize;
+        const float minZ = static_cast<float>(coord.z) * m_settings.cellSize;
+        const float dx = std::max({ minX - camera.x, 0.0f, camera.x - (minX + m_settings.cellSize) });
+        const float dz = std::max({ minZ - camera.z, 0.0f, camera.z - (minZ + m_settings.cellSize) });
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    void SceneStreamer::Update(const glm::vec3& camera)
+    {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::micro>(m_settings.activationBudgetMicros));
+
+        m_stats.activatedNodes = 0;
+        m_stats.deactivatedNodes = 0;
+
+        // Finished loads and cells that left the unload radius
+        uint32_t inFlight = 0;
+        for (const CellCoord& coord : m_resident)
+        {
+            Cell& cell = m_cells[coord];
+            if (cell.state == CellState::Loading && cell.load->done.load(std::memory_order_acquire))
+                cell.state = CellState::Ready;
+
+            const bool leaving = !cell.registered || DistanceTo(coord, camera) > m_settings.unloadRadius;
+            if (leaving)
+            {
+                if (cell.state == CellState::Loading || cell.state == CellState::Ready)
+                    Reset(cell);
+                else if (cell.state == CellState::Activating || cell.state == CellState::Active)
+                    cell.state = CellState::Unloading;
+            }
+
+            if (cell.state == CellState::Loading)
+                ++inFlight;
+        }
+
+        // New loads, nearest first
+        m_candidates.clear();
+        const CellCoord center = GetCell(camera);
+        const int32_t reach = static_cast<int32_t>(std::ceil(m_settings.loadRadius / m_settings.cellSize));
+        for (int32_t z = center.z - reach; z <= center.z + reach; ++z)
+        {
+            for (int32_t x = center.x - reach; x <= center.x + reach; ++x)
+            {
+                const CellCoord coord{ x, z };
+                auto it = m_cells.find(coord);
+                if (it == m_cells.end() || !it->second.registered || it->second.state != CellState::Unloaded)
+                    continue;
+
+                const float distance = DistanceTo(coord, camera);
+                if (distance <= m_settings.loadRadius)
+                    m_candidates.emplace_back(distance, coord);
+            }
+        }
+
+        std::sort(m_candidates.begin(), m_candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& candidate : m_candidates)
+        {
+            if (inFlight >= m_settings.maxLoadsInFlight)
+                break;
+
+            Cell& cell = m_cells[candidate.second];
+            StartLoad(candidate.second, cell);
+            m_resident.push_back(candidate.second);
+            if (cell.state == CellState::Loading)
+                ++inFlight;
+        }
+
+        // Unloads go first to free memory, then activations nearest first, all within the budget. Each side
+        // handles at least one node so a fast moving camera can't starve activations.
+        bool budgetLeft = true;
+        for (const CellCoord& coord : m_resident)
+        {
+            if (!budgetLeft)
+                break;
+
+            Cell& cell = m_cells[coord];
+            if (cell.state == CellState::Unloading)
+                budgetLeft = Deactivate(coord, cell, deadline);
+        }
+
+        m_candidates.clear();
+        for (const CellCoord& coord : m_resident)
+        {
+            const CellState state = m_cells[coord].state;
+            if (state == CellState::Ready || state == CellState::Activating)
+                m_candidates.emplace_back(DistanceTo(coord, camera), coord);
+        }
+
+        std::sort(m_candidates.begin(), m_candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        budgetLeft = true;
+        for (const auto& candidate : m_candidates)
+        {
+            if (!budgetLeft)
+                break;
+
+            budgetLeft = Activate(candidate.second, m_cells[candidate.second], deadline);
+        }
+
+        // Unloaded cells leave the resident list, unregistered ones are forgotten
+        m_stats.loading = m_stats.ready = m_stats.active = m_stats.unloading = 0;
+        m_resident.erase(std::remove_if(m_resident.begin(), m_resident.end(), [this](const CellCoord& coord) {
+            auto it = m_cells.find(coord);
+            switch (it->second.state)
+            {
+            case CellState::Unloaded:
+                if (!it->second.registered)
+                    m_cells.erase(it);
+                return true;
+            case CellState::Loading: ++m_stats.loading; break;
+            case CellState::Ready:
+            case CellState::Activating: ++m_stats.ready; break;
+            case CellState::Active: ++m_stats.active; break;
+            case CellState::Unloading: ++m_stats.unloading; break;
+            }
+            return false;
+        }), m_resident.end());
+    }
+
+    void SceneStreamer::UnloadAll()
+    {
+        for (const CellCoord& coord : m_resident)
+        {
+            Cell& cell = m_cells[coord];
+            if (cell.state == CellState::Activating || cell.state == CellState::Active || cell.state == CellState::Unloading)
+            {
+                for (StringId id : cell.joined)
+                    m_scene.RemoveNode(id);
+                cell.joined.clear();
+
+                if (cell.source.deactivate)
+                    cell.source.deactivate(coord);
+            }
+            Reset(cell);
+        }
+        m_resident.clear();
+
+        for (auto it = m_cells.begin(); it != m_cells.end();)
+            it = it->second.registered ? std::next(it) : m_cells.erase(it);
+
+        m_stats = StreamingStats();
+    }
+
+    void SceneStreamer::StartLoad(const CellCoord& coord, Cell& cell)
+    {
+        cell.load = std::make_shared<LoadResult>();
+        cell.state = CellState::Loading;
+
+        if (!m_pool)
+        {
+            RunLoad(coord, cell.source, *cell.load);
+            cell.state = CellState::Ready;
+            return;
+        }
+
+        // The job owns copies of everything it touches, dropping the cell doesn't have to wait for it
+        m_pool->Submit([coord, source = cell.source, result = cell.load]() {
+            RunLoad(coord, source, *result);
+        }, JobPriority::Background);
+    }
+
+    void SceneStreamer::RunLoad(const CellCoord& coord, const CellSource& source, LoadResult& result)
+    {
+        if (!source.snapshotPath.empty())
+        {
+            // Paged in first so preparing doesn't fault on every record
+            const bool opened = result.snapshot.Open(source.snapshotPath);
+            if (opened)
+                result.snapshot.Prefault();
+
+            if (!opened || !result.nodes.Prepare(result.snapshot.GetData(), result.snapshot.GetSize(), source.snapshotPath))
+                std::cerr << "[SceneStreamer] Cell " << coord.x << ", " << coord.z << " failed to load: " << source.snapshotPath << std::endl;
+        }
+
+        if (source.loadAssets)
+            result.assets = source.loadAssets(coord);
+
+        result.done.store(true, std::memory_order_release);
+    }
+
+    bool SceneStreamer::Activate(const CellCoord& coord, Cell& cell, const std::chrono::steady_clock::time_point& deadline)
+    {
+        if (cell.state == CellState::Ready)
+        {
+            // Built over as many Updates as the budget needs, the nodes join the scene only once all exist
+            LoadResult& load = *cell.load;
+            if (!load.nodes.Step(m_scene.GetEntityStore(), cell.roots, deadline))
+                return false;
+
+            if (cell.source.activate)
+                cell.source.activate(coord, cell.roots, load.assets.get());
+
+            cell.load.reset();
+            cell.nextRoot = 0;
+            cell.state = CellState::Activating;
+
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+        }
+
+        while (cell.nextRoot < cell.roots.size())
+        {
+            std::shared_ptr<Node> node = std::move(cell.roots[cell.nextRoot++]);
+            if (!node)
+                continue;
+
+            Node* raw = node.get();
+            const StringId id = raw->GetNameId();
+            m_scene.AddNodeShared(std::move(node));
+            if (m_scene.FindNode(id) != raw)
+            {
+                std::cerr << "[SceneStreamer] Node name already in the scene, skipped: " << raw->GetName() << std::endl;
+                continue;
+            }
+
+            raw->InitNode();
+            cell.joined.push_back(id);
+            ++m_stats.activatedNodes;
+
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+        }
+
+        if (cell.nextRoot < cell.roots.size())
+            return false;
+
+        cell.roots.clear();
+        cell.state = CellState::Active;
+        return std::chrono::steady_clock::now() < deadline;
+    }
+
+    bool SceneStreamer::Deactivate(const CellCoord& coord, Cell& cell, const std::chrono::steady_clock::time_point& deadline)
+    {
+        while (!cell.joined.empty())
+        {
+            m_scene.RemoveNode(cell.joined.back());
+            cell.joined.pop_back();
+            ++m_stats.deactivatedNodes;
+
+            if (!cell.joined.empty() && std::chrono::steady_clock::now() >= deadline)
+                return false;
+        }
+
+        if (cell.source.deactivate)
+            cell.source.deactivate(coord);
+
+        Reset(cell);
+        return std::chrono::steady_clock::now() < deadline;
+    }
+
+    void SceneStreamer::Reset(Cell& cell)
+    {
+        // A finished job may still hold the load for a moment, nodes built from it have to go on this thread
+        if (cell.load && cell.load->done.load(std::memory_order_acquire))
+            cell.load->nodes.Reset();
+        cell.load.reset();
+        cell.roots.clear();
+        cell.nextRoot = 0;
+        cell.joined.clear();
+        cell.state = CellState::Unloaded;
+    }
+}
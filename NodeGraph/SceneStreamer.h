@@ -0,0 +1,175 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+#include "../Engine/MappedFile.h"
+
+#include <unordered_map>
+
+#include "Scene.h"
+#include "SceneSnapshot.h"
+
+namespace BSE
+{
+    // Grid cell on the horizontal plane, cell (x, z) covers [x, x + 1) * cellSize along x and likewise along z
+    struct CellCoord
+    {
+        int32_t x = 0;
+        int32_t z = 0;
+
+        bool operator==(const CellCoord&) const = default;
+    };
+
+    struct CellCoordHash
+    {
+        size_t operator()(const CellCoord& coord) const noexcept
+        {
+            return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.z));
+        }
+    };
+
+    // Whatever a cell's loader produced on the worker thread, handed back to activate on the main thread
+    struct DLL_EXPORT CellAssets
+    {
+        virtual ~CellAssets() = default;
+    };
+
+    // What makes up a cell. Any part may be left empty. The functions are copied into load jobs, so whatever they
+    // capture has to outlive loads still in flight when the streamer goes away.
+    struct DLL_EXPORT CellSource
+    {
+        // SceneSnapshot file holding the cell's nodes. A worker maps it and runs the codecs' prepare steps, the
+        // nodes are then built on the main thread within the activation budget.
+        std::string snapshotPath;
+
+        // Worker thread, CPU side loading such as decoding images or reading meshes. Must not touch the scene.
+        std::function<std::unique_ptr<CellAssets>(const CellCoord&)> loadAssets;
+
+        // Main thread, before the nodes join the scene. May add nodes built in code to roots and upload assets.
+        std::function<void(const CellCoord&, std::vector<std::shared_ptr<Node>>& roots, CellAssets* assets)> activate;
+
+        // Main thread, after the cell's nodes left the scene
+        std::function<void(const CellCoord&)> deactivate;
+    };
+
+    struct DLL_EXPORT StreamingSettings
+    {
+        float cellSize = 64.0f;
+
+        // Cells closer than loadRadius to the camera are streamed in and only dropped past unloadRadius, the gap
+        // keeps cells on the border from loading and unloading every frame
+        float loadRadius = 128.0f;
+        float unloadRadius = 160.0f;
+
+        uint32_t maxLoadsInFlight = 4;
+
+        // Main thread time per Update spent building, adding and removing nodes, at least one node is built, one
+        // added and one removed when any wait
+        double activationBudgetMicros = 2000.0;
+    };
+
+    struct StreamingStats
+    {
+        size_t loading = 0;
+        // Loaded and waiting for activation
+        size_t ready = 0;
+        size_t active = 0;
+        size_t unloading = 0;
+        // Nodes added to and removed from the scene by the last Update
+        size_t activatedNodes = 0;
+        size_t deactivatedNodes = 0;
+    };
+
+    // Streams a world partitioned into grid cells into a scene around the camera. Loads run on the pool, nodes
+    // are built and joined to the scene on the main thread a few at a time within the activation budget, and
+    // each streamed node gets InitNode when it joins, so InitScene only has to cover nodes built up front.
+    // Streamed top level nodes are shared nodes and their names must not clash with other top level nodes.
+    class DLL_EXPORT SceneStreamer
+    {
+    public:
+        // Without a pool loads run on the calling thread inside Update
+        SceneStreamer(Scene& scene, ThreadPool* pool = nullptr, const StreamingSettings& settings = StreamingSettings());
+        ~SceneStreamer();
+
+        SceneStreamer(const SceneStreamer&) = delete;
+        SceneStreamer& operator=(const SceneStreamer&) = delete;
+
+        void SetSettings(const StreamingSettings& settings);
+        const StreamingSettings& GetSettings() const { return m_settings; }
+
+        // Replaces the source of a cell, an already streamed cell keeps its nodes until it unloads
+        void RegisterCell(const CellCoord& coord, CellSource source);
+        void UnregisterCell(const CellCoord& coord);
+
+        CellCoord GetCell(const glm::vec3& position) const;
+
+        // Once per frame on the main thread
+        void Update(const glm::vec3& camera);
+
+        // Drops every streamed node at once and forgets loads in flight, their results are discarded on arrival
+        void UnloadAll();
+
+        bool IsActive(const CellCoord& coord) const;
+        const StreamingStats& GetStats() const { return m_stats; }
+
+    private:
+        enum class CellState : uint8_t
+        {
+            Unloaded,
+            Loading,
+            Ready,
+            Activating,
+            Active,
+            // Left the unload radius, its nodes leave the scene within the activation budget
+            Unloading
+        };
+
+        // Shared with the load job, which may outlive the streamer
+        struct LoadResult
+        {
+            MappedFile snapshot;
+            // Reads the mapped snapshot, so it is declared after it
+            StagedSnapshot nodes;
+            std::unique_ptr<CellAssets> assets;
+            std::atomic<bool> done{ false };
+        };
+
+        struct Cell
+        {
+            CellSource source;
+            bool registered = false;
+            CellState state = CellState::Unloaded;
+
+            std::shared_ptr<LoadResult> load;
+            // Built from the load while Ready, joined to the scene from nextRoot on once Activating
+            std::vector<std::shared_ptr<Node>> roots;
+            size_t nextRoot = 0;
+            // Ids of the nodes that actually joined the scene
+            std::vector<StringId> joined;
+        };
+
+        float DistanceTo(const CellCoord& coord, const glm::vec3& camera) const;
+
+        void StartLoad(const CellCoord& coord, Cell& cell);
+        static void RunLoad(const CellCoord& coord, const CellSource& source, LoadResult& result);
+
+        // Both return false once the budget ran out before the cell was done
+        bool Activate(const CellCoord& coord, Cell& cell, const std::chrono::steady_clock::time_point& deadline);
+        bool Deactivate(const CellCoord& coord, Cell& cell, const std::chrono::steady_clock::time_point& deadline);
+
+        void Reset(Cell& cell);
+
+        Scene& m_scene;
+        ThreadPool* m_pool;
+        StreamingSettings m_settings;
+
+        std::unordered_map<CellCoord, Cell, CellCoordHash> m_cells;
+        // Cells in any state but Unloaded
+        std::vector<CellCoord> m_resident;
+
+        // Reused every Update
+        std::vector<std::pair<float, CellCoord>> m_candidates;
+
+        StreamingStats m_stats;
+    };
+}
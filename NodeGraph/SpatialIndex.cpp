@@ -0,0 +1,296 @@
+#include "SpatialIndex.h"
+
+namespace BSE
+{
+    AABB AABB::Transformed(const glm::mat4& matrix) const
+    {
+        const glm::vec3 center = GetCenter();
+        const glm::vec3 extents = GetExtents();
+
+        glm::vec3 newCenter(matrix[3]);
+        glm::vec3 newExtents(0.0f);
+        for (int column = 0; column < 3; ++column)
+        {
+            const glm::vec3 axis(matrix[column]);
+            newCenter += axis * center[column];
+            newExtents += glm::abs(axis) * extents[column];
+        }
+
+        return FromCenterExtents(newCenter, newExtents);
+    }
+
+    FrustumPlanes ExtractFrustumPlanes(const glm::mat4& viewProjection)
+    {
+        // Gribb and Hartmann, rows of the matrix combined with the fourth row
+        auto row = [&](int index) {
+            return glm::vec4(viewProjection[0][index], viewProjection[1][index], viewProjection[2][index], viewProjection[3][index]);
+        };
+
+        const glm::vec4 r0 = row(0);
+        const glm::vec4 r1 = row(1);
+        const glm::vec4 r2 = row(2);
+        const glm::vec4 r3 = row(3);
+
+        FrustumPlanes planes = { r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2 };
+        for (glm::vec4& plane : planes)
+        {
+            const float length = glm::length(glm::vec3(plane));
+            if (length > 0.0f)
+                plane /= length;
+        }
+        return planes;
+    }
+
+    SpatialIndex::SpatialIndex(float fatMargin)
+        : m_fatMargin(fatMargin)
+    {
+    }
+
+    void SpatialIndex::Clear()
+    {
+        m_nodes.clear();
+        m_root = NullProxy;
+        m_freeList = NullProxy;
+        m_proxyCount = 0;
+    }
+
+    int32_t SpatialIndex::AllocateNode()
+    {
+        if (m_freeList == NullProxy)
+        {
+            m_nodes.emplace_back();
+            m_freeList = static_cast<int32_t>(m_nodes.size() - 1);
+            m_nodes.back().parent = NullProxy;
+        }
+
+        const int32_t index = m_freeList;
+        TreeNode& node = m_nodes[index];
+        m_freeList = node.parent;
+
+        node = TreeNode();
+        node.height = 0;
+        return index;
+    }
+
+    void SpatialIndex::FreeNode(int32_t index)
+    {
+        TreeNode& node = m_nodes[index];
+        node.parent = m_freeList;
+        node.height = -1;
+        node.userData = nullptr;
+        m_freeList = index;
+    }
+
+    int32_t SpatialIndex::Insert(const AABB& bounds, void* userData)
+    {
+        const int32_t proxy = AllocateNode();
+        const glm::vec3 margin(m_fatMargin);
+
+        TreeNode& node = m_nodes[proxy];
+        node.bounds = AABB{ bounds.min - margin, bounds.max + margin };
+        node.userData = userData;
+
+        InsertLeaf(proxy);
+        ++m_proxyCount;
+        return proxy;
+    }
+
+    void SpatialIndex::Remove(int32_t proxy)
+    {
+        if (!IsValid(proxy))
+            return;
+
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+        --m_proxyCount;
+    }
+
+    bool SpatialIndex::Move(int32_t proxy, const AABB& bounds)
+    {
+        if (!IsValid(proxy))
+            return false;
+
+        if (m_nodes[proxy].bounds.Contains(bounds))
+            return false;
+
+        RemoveLeaf(proxy);
+
+        const glm::vec3 margin(m_fatMargin);
+        m_nodes[proxy].bounds = AABB{ bounds.min - margin, bounds.max + margin };
+
+        InsertLeaf(proxy);
+        return true;
+    }
+
+    void SpatialIndex::InsertLeaf(int32_t leaf)
+    {
+        if (m_root == NullProxy)
+        {
+            m_root = leaf;
+            m_nodes[leaf].parent = NullProxy;
+            return;
+        }
+
+        // Walk down towards the sibling where the leaf adds the least surface area
+        const AABB leafBounds = m_nodes[leaf].bounds;
+        int32_t index = m_root;
+        while (!m_nodes[index].IsLeaf())
+        {
+            const TreeNode& node = m_nodes[index];
+
+            const float area = node.bounds.GetSurfaceArea();
+            const float combinedArea = AABB::Union(node.bounds, leafBounds).GetSurfaceArea();
+
+            // Cost of pairing the leaf with this node, and of pushing it further down
+            const float cost = 2.0f * combinedArea;
+            const float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto descendCost = [&](int32_t child) {
+                const AABB& childBounds = m_nodes[child].bounds;
+                const float unionArea = AABB::Union(childBounds, leafBounds).GetSurfaceArea();
+                if (m_nodes[child].IsLeaf())
+                    return unionArea + inheritanceCost;
+                return unionArea - childBounds.GetSurfaceArea() + inheritanceCost;
+            };
+
+            const float cost1 = descendCost(node.child1);
+            const float cost2 = descendCost(node.child2);
+
+            if (cost < cost1 && cost < cost2)
+                break;
+
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        const int32_t sibling = index;
+        const int32_t oldParent = m_nodes[sibling].parent;
+
+        const int32_t newParent = AllocateNode();
+        m_nodes[newParent].parent = oldParent;
+        m_nodes[newParent].bounds = AABB::Union(leafBounds, m_nodes[sibling].bounds);
+        m_nodes[newParent].height = m_nodes[sibling].height + 1;
+        m_nodes[newParent].child1 = sibling;
+        m_nodes[newParent].child2 = leaf;
+
+        m_nodes[sibling].parent = newParent;
+        m_nodes[leaf].parent = newParent;
+
+        if (oldParent == NullProxy)
+        {
+            m_root = newParent;
+        }
+        else if (m_nodes[oldParent].child1 == sibling)
+        {
+            m_nodes[oldParent].child1 = newParent;
+        }
+        else
+        {
+            m_nodes[oldParent].child2 = newParent;
+        }
+
+        RefitAncestors(m_nodes[leaf].parent);
+    }
+
+    void SpatialIndex::RemoveLeaf(int32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = NullProxy;
+            return;
+        }
+
+        const int32_t parent = m_nodes[leaf].parent;
+        const int32_t grandParent = m_nodes[parent].parent;
+        const int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+        if (grandParent == NullProxy)
+        {
+            m_root = sibling;
+            m_nodes[sibling].parent = NullProxy;
+            FreeNode(parent);
+            return;
+        }
+
+        if (m_nodes[grandParent].child1 == parent)
+            m_nodes[grandParent].child1 = sibling;
+        else
+            m_nodes[grandParent].child2 = sibling;
+
+        m_nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+
+        RefitAncestors(grandParent);
+    }
+
+    void SpatialIndex::RefitAncestors(int32_t index)
+    {
+        while (index != NullProxy)
+        {
+            index = Balance(index);
+
+            TreeNode& node = m_nodes[index];
+            const TreeNode& child1 = m_nodes[node.child1];
+            const TreeNode& child2 = m_nodes[node.child2];
+
+            node.height = 1 + std::max(child1.height, child2.height);
+            node.bounds = AABB::Union(child1.bounds, child2.bounds);
+
+            index = node.parent;
+        }
+    }
+
+    // Rotates a grandchild up when one side is more than one level deeper, returns the subtree's new root
+    int32_t SpatialIndex::Balance(int32_t a)
+    {
+        TreeNode& nodeA = m_nodes[a];
+        if (nodeA.IsLeaf() || nodeA.height < 2)
+            return a;
+
+        const int32_t b = nodeA.child1;
+        const int32_t c = nodeA.child2;
+        const int32_t balance = m_nodes[c].height - m_nodes[b].height;
+
+        if (balance > 1 || balance < -1)
+        {
+            // Rotate the taller child up into a's place
+            const int32_t up = balance > 1 ? c : b;
+            const int32_t down = balance > 1 ? b : c;
+
+            TreeNode& nodeUp = m_nodes[up];
+            const int32_t f = nodeUp.child1;
+            const int32_t g = nodeUp.child2;
+
+            nodeUp.child1 = a;
+            nodeUp.parent = nodeA.parent;
+            nodeA.parent = up;
+
+            if (nodeUp.parent == NullProxy)
+                m_root = up;
+            else if (m_nodes[nodeUp.parent].child1 == a)
+                m_nodes[nodeUp.parent].child1 = up;
+            else
+                m_nodes[nodeUp.parent].child2 = up;
+
+            // The taller grandchild stays with up, the shorter one replaces up below a
+            const bool keepF = m_nodes[f].height > m_nodes[g].height;
+            const int32_t kept = keepF ? f : g;
+            const int32_t moved = keepF ? g : f;
+
+            nodeUp.child2 = kept;
+            if (balance > 1)
+                nodeA.child2 = moved;
+            else
+                nodeA.child1 = moved;
+            m_nodes[moved].parent = a;
+
+            nodeA.bounds = AABB::Union(m_nodes[down].bounds, m_nodes[moved].bounds);
+            nodeA.height = 1 + std::max(m_nodes[down].height, m_nodes[moved].height);
+
+            nodeUp.bounds = AABB::Union(nodeA.bounds, m_nodes[kept].bounds);
+            nodeUp.height = 1 + std::max(nodeA.height, m_nodes[kept].height);
+            return up;
+        }
+
+        return a;
+    }
+}
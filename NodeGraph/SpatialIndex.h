@@ -0,0 +1,232 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include "../Threading/ThreadingSystem.h"
+
+#include <glm/glm.hpp>
+
+namespace BSE
+{
+    struct DLL_EXPORT AABB
+    {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+
+        static AABB FromCenterExtents(const glm::vec3& center, const glm::vec3& extents) { return AABB{ center - extents, center + extents }; }
+
+        glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+        glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+        float GetSurfaceArea() const
+        {
+            const glm::vec3 size = max - min;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool Contains(const AABB& other) const
+        {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+                && max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+        }
+
+        bool Overlaps(const AABB& other) const
+        {
+            return min.x <= other.max.x && max.x >= other.min.x
+                && min.y <= other.max.y && max.y >= other.min.y
+                && min.z <= other.max.z && max.z >= other.min.z;
+        }
+
+        static AABB Union(const AABB& a, const AABB& b) { return AABB{ glm::min(a.min, b.min), glm::max(a.max, b.max) }; }
+
+        // Bounds of this box after transforming it, exact for rotation and scale
+        AABB Transformed(const glm::mat4& matrix) const;
+    };
+
+    // Frustum planes as (normal, distance) with normals pointing inwards, a point p is inside a plane when
+    // dot(normal, p) + distance >= 0
+    using FrustumPlanes = std::array<glm::vec4, 6>;
+
+    DLL_EXPORT FrustumPlanes ExtractFrustumPlanes(const glm::mat4& viewProjection);
+
+    // Dynamic AABB tree. Leaves store a fattened copy of their object's bounds, so objects moving a little
+    // never touch the tree, larger moves reinsert the leaf where it adds the least surface area and rotations
+    // keep the tree balanced. Queries only read, any number of threads may query while nobody modifies.
+    class DLL_EXPORT SpatialIndex
+    {
+    public:
+        static constexpr int32_t NullProxy = -1;
+
+        explicit SpatialIndex(float fatMargin = 0.1f);
+
+        int32_t Insert(const AABB& bounds, void* userData);
+        void Remove(int32_t proxy);
+        // Returns true when the leaf had to be reinserted
+        bool Move(int32_t proxy, const AABB& bounds);
+
+        bool IsValid(int32_t proxy) const { return proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()) && m_nodes[proxy].height == 0; }
+        void* GetUserData(int32_t proxy) const { return m_nodes[proxy].userData; }
+        const AABB& GetFatBounds(int32_t proxy) const { return m_nodes[proxy].bounds; }
+
+        size_t GetProxyCount() const { return m_proxyCount; }
+        int GetHeight() const { return m_root == NullProxy ? 0 : m_nodes[m_root].height; }
+        void Clear();
+
+        template<typename Func>
+        void ForEachProxy(Func&& func) const
+        {
+            for (size_t i = 0; i < m_nodes.size(); ++i)
+            {
+                if (m_nodes[i].height == 0)
+                    func(static_cast<int32_t>(i));
+            }
+        }
+
+        // Visitors get the proxy and return false to stop the query, matches are against fattened bounds
+        template<typename Func>
+        void QueryAABB(const AABB& bounds, Func&& func) const
+        {
+            Traverse([&](const AABB& node) { return node.Overlaps(bounds); }, func);
+        }
+
+        template<typename Func>
+        void QuerySphere(const glm::vec3& center, float radius, Func&& func) const
+        {
+            const float radiusSquared = radius * radius;
+            Traverse([&](const AABB& node) {
+                const glm::vec3 closest = glm::clamp(center, node.min, node.max);
+                const glm::vec3 delta = closest - center;
+                return glm::dot(delta, delta) <= radiusSquared;
+            }, func);
+        }
+
+        template<typename Func>
+        void QueryFrustum(const FrustumPlanes& planes, Func&& func) const
+        {
+            Traverse([&](const AABB& node) {
+                for (const glm::vec4& plane : planes)
+                {
+                    // Corner furthest along the plane normal
+                    const glm::vec3 corner(plane.x >= 0.0f ? node.max.x : node.min.x,
+                                           plane.y >= 0.0f ? node.max.y : node.min.y,
+                                           plane.z >= 0.0f ? node.max.z : node.min.z);
+                    if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+                        return false;
+                }
+                return true;
+            }, func);
+        }
+
+        // func(proxy, entryDistance) returns the new maximum distance, returning entryDistance of a confirmed
+        // hit finds the closest one, returning the current maximum collects every hit and 0 stops
+        template<typename Func>
+        void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Func&& func) const
+        {
+            const glm::vec3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+            float limit = maxDistance;
+            float entry = 0.0f;
+            Traverse([&](const AABB& node) {
+                const glm::vec3 t0 = (node.min - origin) * inverse;
+                const glm::vec3 t1 = (node.max - origin) * inverse;
+                const glm::vec3 tMin = glm::min(t0, t1);
+                const glm::vec3 tMax = glm::max(t0, t1);
+
+                entry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+                const float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, limit));
+                return entry <= exit;
+            }, [&](int32_t proxy) {
+                limit = func(proxy, entry);
+                return limit > 0.0f;
+            });
+        }
+
+        // Runs one AABB query per box across the pool, func(queryIndex, proxy) must be safe to call concurrently
+        template<typename Func>
+        void QueryAABBBatch(const std::vector<AABB>& boxes, ThreadPool& pool, Func&& func) const
+        {
+            pool.ParallelFor(0, boxes.size(), [&](size_t query) {
+                QueryAABB(boxes[query], [&](int32_t proxy) {
+                    func(query, proxy);
+                    return true;
+                });
+            });
+        }
+
+    private:
+        struct TreeNode
+        {
+            AABB bounds;
+            void* userData = nullptr;
+            // Next free node while on the free list
+            int32_t parent = NullProxy;
+            int32_t child1 = NullProxy;
+            int32_t child2 = NullProxy;
+            // Leaves are 0, free nodes -1
+            int32_t height = -1;
+
+            bool IsLeaf() const { return child1 == NullProxy; }
+        };
+
+        template<typename Test, typename Func>
+        void Traverse(Test&& test, Func&& func) const
+        {
+            if (m_root == NullProxy)
+                return;
+
+            // Deep enough for any balanced tree, the vector only takes over for degenerate ones
+            std::array<int32_t, 64> inlineStack;
+            std::vector<int32_t> overflow;
+            size_t count = 0;
+            inlineStack[count++] = m_root;
+
+            while (count > 0 || !overflow.empty())
+            {
+                int32_t index;
+                if (!overflow.empty())
+                {
+                    index = overflow.back();
+                    overflow.pop_back();
+                }
+                else
+                {
+                    index = inlineStack[--count];
+                }
+
+                const TreeNode& node = m_nodes[index];
+                if (!test(node.bounds))
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    if (!func(index))
+                        return;
+                    continue;
+                }
+
+                for (int32_t child : { node.child1, node.child2 })
+                {
+                    if (count < inlineStack.size())
+                        inlineStack[count++] = child;
+                    else
+                        overflow.push_back(child);
+                }
+            }
+        }
+
+        int32_t AllocateNode();
+        void FreeNode(int32_t index);
+
+        void InsertLeaf(int32_t leaf);
+        void RemoveLeaf(int32_t leaf);
+        void RefitAncestors(int32_t index);
+        int32_t Balance(int32_t index);
+
+        std::vector<TreeNode> m_nodes;
+        int32_t m_root = NullProxy;
+        int32_t m_freeList = NullProxy;
+        size_t m_proxyCount = 0;
+        float m_fatMargin;
+    };
+}
@@ -0,0 +1,343 @@
+#include "Transform.h"
+#include "Node.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BSE_TRANSFORM_SSE 1
+#endif
+
+namespace BSE
+{
+    namespace
+    {
+        // out = parent * local, out must not alias parent
+        void MultiplyMatrices(const glm::mat4& parent, const glm::mat4& local, glm::mat4& out)
+        {
+#if defined(BSE_TRANSFORM_SSE)
+            const __m128 column0 = _mm_loadu_ps(&parent[0][0]);
+            const __m128 column1 = _mm_loadu_ps(&parent[1][0]);
+            const __m128 column2 = _mm_loadu_ps(&parent[2][0]);
+            const __m128 column3 = _mm_loadu_ps(&parent[3][0]);
+
+            for (int column = 0; column < 4; ++column)
+            {
+                __m128 result = _mm_mul_ps(column0, _mm_set1_ps(local[column][0]));
+                result = _mm_add_ps(result, _mm_mul_ps(column1, _mm_set1_ps(local[column][1])));
+                result = _mm_add_ps(result, _mm_mul_ps(column2, _mm_set1_ps(local[column][2])));
+                result = _mm_add_ps(result, _mm_mul_ps(column3, _mm_set1_ps(local[column][3])));
+                _mm_storeu_ps(&out[column][0], result);
+            }
+#else
+            out = parent * local;
+#endif
+        }
+    }
+
+    glm::mat4 Transform::GetLocalMatrix() const
+    {
+        // Same as translate * rotate * scale without the two full matrix products
+        glm::mat4 matrix = glm::mat4_cast(m_rotation);
+        matrix[0] *= m_scale.x;
+        matrix[1] *= m_scale.y;
+        matrix[2] *= m_scale.z;
+        matrix[3] = glm::vec4(m_position, 1.0f);
+        return matrix;
+    }
+
+    TransformHierarchy::~TransformHierarchy()
+    {
+        for (const Range& range : m_ranges)
+        {
+            if (range.root)
+                Detach(*range.root);
+        }
+    }
+
+    uint32_t TransformHierarchy::FindRange(const Node* root) const
+    {
+        // Laid out roots are found through their slot, ones added since the last Update are still pending
+        if (root->transform.m_hierarchy == this)
+        {
+            const uint32_t range = m_rangeOf[root->transform.m_index];
+            return m_ranges[range].root == root ? range : InvalidRange;
+        }
+
+        for (uint32_t range : m_dirtyRanges)
+        {
+            if (m_ranges[range].root == root)
+                return range;
+        }
+        return InvalidRange;
+    }
+
+    void TransformHierarchy::AddRoot(Node* node)
+    {
+        if (!node || FindRange(node) != InvalidRange)
+            return;
+
+        uint32_t range;
+        if (m_freeRanges.empty())
+        {
+            range = static_cast<uint32_t>(m_ranges.size());
+            m_ranges.emplace_back();
+        }
+        else
+        {
+            range = m_freeRanges.back();
+            m_freeRanges.pop_back();
+        }
+
+        // Gets its slots on the next Update
+        m_ranges[range].root = node;
+        m_ranges[range].dirty = true;
+        m_dirtyRanges.push_back(range);
+    }
+
+    void TransformHierarchy::RemoveRoot(Node* node)
+    {
+        const uint32_t range = node ? FindRange(node) : InvalidRange;
+        if (range == InvalidRange)
+            return;
+
+        Detach(*node);
+
+        Range& removed = m_ranges[range];
+        FreeSlots(removed.begin, removed.capacity);
+        m_usedSlots -= removed.count;
+        removed = Range();
+        m_freeRanges.push_back(range);
+    }
+
+    void TransformHierarchy::MarkStructureDirty(uint32_t index)
+    {
+        if (index >= m_nodes.size() || !m_nodes[index])
+            return;
+
+        Range& range = m_ranges[m_rangeOf[index]];
+        if (!range.dirty)
+        {
+            range.dirty = true;
+            m_dirtyRanges.push_back(m_rangeOf[index]);
+        }
+    }
+
+    void TransformHierarchy::Detach(Node& node)
+    {
+        // The node may be destroyed before the index is synced again
+        TransformHierarchy* hierarchy = node.transform.m_hierarchy;
+        if (hierarchy && hierarchy->m_spatialIndex && node.spatialProxy != SpatialIndex::NullProxy)
+        {
+            SpatialIndex& index = *hierarchy->m_spatialIndex;
+            if (index.IsValid(node.spatialProxy) && index.GetUserData(node.spatialProxy) == &node)
+                index.Remove(node.spatialProxy);
+        }
+        node.spatialProxy = SpatialIndex::NullProxy;
+
+        node.transform.m_hierarchy = nullptr;
+        node.transform.m_dirty = true;
+
+        for (auto& pair : node.childrenByName)
+        {
+            if (pair.second)
+                Detach(*pair.second);
+        }
+    }
+
+    void TransformHierarchy::FreeSlots(uint32_t begin, uint32_t count)
+    {
+        // Slots at the very end are dropped right away, the others wait for a compaction
+        if (count > 0 && begin + count == m_nodes.size())
+        {
+            m_nodes.resize(begin);
+            m_parents.resize(begin);
+            m_world.resize(begin);
+            m_changed.resize(begin);
+            m_rangeOf.resize(begin);
+            return;
+        }
+
+        for (uint32_t slot = begin; slot < begin + count; ++slot)
+        {
+            m_nodes[slot] = nullptr;
+            m_parents[slot] = -1;
+            m_changed[slot] = 0;
+        }
+    }
+
+    void TransformHierarchy::BuildRange(uint32_t index)
+    {
+        Range& range = m_ranges[index];
+        range.dirty = false;
+
+        // The scratch list doubles as the breadth first queue
+        m_scratchNodes.clear();
+        m_scratchParents.clear();
+        m_scratchNodes.push_back(range.root);
+        m_scratchParents.push_back(-1);
+
+        for (size_t i = 0; i < m_scratchNodes.size(); ++i)
+        {
+            for (auto& pair : m_scratchNodes[i]->childrenByName)
+            {
+                if (!pair.second)
+                    continue;
+
+                m_scratchNodes.push_back(pair.second.get());
+                m_scratchParents.push_back(static_cast<int32_t>(i));
+            }
+        }
+
+        // A subtree that outgrew its slots moves to the end, the others are rewritten where they are
+        const uint32_t count = static_cast<uint32_t>(m_scratchNodes.size());
+        if (count > range.capacity)
+        {
+            FreeSlots(range.begin, range.capacity);
+
+            range.begin = static_cast<uint32_t>(m_nodes.size());
+            range.capacity = count;
+
+            const size_t size = range.begin + count;
+            m_nodes.resize(size);
+            m_parents.resize(size);
+            m_world.resize(size);
+            m_changed.resize(size);
+            m_rangeOf.resize(size);
+        }
+        else
+        {
+            FreeSlots(range.begin + count, range.capacity - count);
+            // Free slots at the end of the arrays are gone
+            range.capacity = std::min<uint32_t>(range.capacity, static_cast<uint32_t>(m_nodes.size()) - range.begin);
+        }
+
+        m_usedSlots = m_usedSlots - range.count + count;
+        range.count = count;
+
+        // Parents precede their children, so the world matrices are computed in the same pass
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t slot = range.begin + i;
+            Node* node = m_scratchNodes[i];
+            const int32_t parent = m_scratchParents[i] < 0 ? -1 : static_cast<int32_t>(range.begin) + m_scratchParents[i];
+
+            m_nodes[slot] = node;
+            m_parents[slot] = parent;
+            m_rangeOf[slot] = index;
+            m_changed[slot] = 0;
+
+            Transform& transform = node->transform;
+            transform.m_hierarchy = this;
+            transform.m_index = slot;
+            transform.m_dirty = false;
+
+            if (parent < 0)
+                m_world[slot] = transform.GetLocalMatrix();
+            else
+                MultiplyMatrices(m_world[parent], transform.GetLocalMatrix(), m_world[slot]);
+
+            m_recomputed.push_back(slot);
+        }
+    }
+
+    void TransformHierarchy::Compact()
+    {
+        m_scratchRanges.clear();
+        for (uint32_t range = 0; range < m_ranges.size(); ++range)
+        {
+            if (m_ranges[range].root && m_ranges[range].count > 0)
+                m_scratchRanges.push_back(range);
+        }
+
+        std::sort(m_scratchRanges.begin(), m_scratchRanges.end(), [this](uint32_t a, uint32_t b) {
+            return m_ranges[a].begin < m_ranges[b].begin;
+        });
+
+        // Slots written this Update move along, held as range and offset meanwhile
+        m_scratchRecomputed.clear();
+        for (uint32_t slot : m_recomputed)
+            m_scratchRecomputed.emplace_back(m_rangeOf[slot], slot - m_ranges[m_rangeOf[slot]].begin);
+
+        // Ranges in slot order each move down over the holes before them, never onto slots still to be read
+        uint32_t write = 0;
+        for (uint32_t index : m_scratchRanges)
+        {
+            Range& range = m_ranges[index];
+            if (range.begin != write)
+            {
+                for (uint32_t i = 0; i < range.count; ++i)
+                {
+                    const uint32_t from = range.begin + i;
+                    const uint32_t to = write + i;
+                    const int32_t parent = m_parents[from];
+
+                    m_nodes[to] = m_nodes[from];
+                    m_parents[to] = parent < 0 ? -1 : parent - static_cast<int32_t>(range.begin) + static_cast<int32_t>(write);
+                    m_world[to] = m_world[from];
+                    m_changed[to] = m_changed[from];
+                    m_rangeOf[to] = index;
+                    m_nodes[to]->transform.m_index = to;
+                }
+                range.begin = write;
+            }
+
+            range.capacity = range.count;
+            write += range.count;
+        }
+
+        m_nodes.resize(write);
+        m_parents.resize(write);
+        m_world.resize(write);
+        m_changed.resize(write);
+        m_rangeOf.resize(write);
+
+        m_recomputed.clear();
+        for (const auto& [range, offset] : m_scratchRecomputed)
+            m_recomputed.push_back(m_ranges[range].begin + offset);
+
+        m_compacted = true;
+    }
+
+    void TransformHierarchy::Update()
+    {
+        m_compacted = false;
+        m_recomputed.clear();
+
+        // Only the ranges of top level nodes that gained or lost nodes below them are laid out again
+        for (uint32_t range : m_dirtyRanges)
+        {
+            if (m_ranges[range].root && m_ranges[range].dirty)
+                BuildRange(range);
+        }
+        m_dirtyRanges.clear();
+
+        const size_t freeSlots = m_nodes.size() - m_usedSlots;
+        if (freeSlots > MinCompactSlots && freeSlots * 2 > m_nodes.size())
+            Compact();
+
+        if (!m_transformDirty.exchange(false, std::memory_order_relaxed))
+            return;
+
+        for (size_t i = 0; i < m_nodes.size(); ++i)
+        {
+            Node* node = m_nodes[i];
+            if (!node)
+                continue;
+
+            Transform& transform = node->transform;
+            const int32_t parent = m_parents[i];
+
+            const bool changed = transform.m_dirty || (parent >= 0 && m_changed[parent]);
+            m_changed[i] = changed;
+            if (!changed)
+                continue;
+
+            transform.m_dirty = false;
+            if (parent < 0)
+                m_world[i] = transform.GetLocalMatrix();
+            else
+                MultiplyMatrices(m_world[parent], transform.GetLocalMatrix(), m_world[i]);
+
+            m_recomputed.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
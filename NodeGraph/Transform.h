@@ -0,0 +1,163 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace BSE
+{
+    class Node;
+    class SpatialIndex;
+    class TransformHierarchy;
+
+    // Position, rotation and scale of a node relative to its parent. Setters only flag the transform, world
+    // matrices are recomputed by the owning scene's TransformHierarchy::Update.
+    class DLL_EXPORT Transform
+    {
+    public:
+        void SetPosition(const glm::vec3& position) { m_position = position; MarkDirty(); }
+        void SetRotation(const glm::quat& rotation) { m_rotation = rotation; MarkDirty(); }
+        void SetScale(const glm::vec3& scale) { m_scale = scale; MarkDirty(); }
+
+        void Translate(const glm::vec3& delta) { m_position += delta; MarkDirty(); }
+        void Rotate(const glm::quat& delta) { m_rotation = glm::normalize(delta * m_rotation); MarkDirty(); }
+        void Rescale(const glm::vec3& factor) { m_scale *= factor; MarkDirty(); }
+
+        const glm::vec3& GetPosition() const { return m_position; }
+        const glm::quat& GetRotation() const { return m_rotation; }
+        const glm::vec3& GetScale() const { return m_scale; }
+
+        glm::mat4 GetLocalMatrix() const;
+
+        // As of the last hierarchy update, the local matrix while the node is not part of a scene
+        glm::mat4 GetWorldMatrix() const;
+        glm::vec3 GetWorldPosition() const { return glm::vec3(GetWorldMatrix()[3]); }
+
+        bool IsDirty() const { return m_dirty; }
+        // Bumped by every change through the setters, never by the hierarchy
+        uint32_t GetRevision() const { return m_revision; }
+        TransformHierarchy* GetHierarchy() const { return m_hierarchy; }
+        // Slot in the hierarchy's flat arrays, only meaningful while GetHierarchy() is set
+        uint32_t GetIndex() const { return m_index; }
+
+    private:
+        friend class TransformHierarchy;
+        friend class Node;
+
+        void MarkDirty();
+
+        glm::vec3 m_position = glm::vec3(0.0f);
+        glm::quat m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 m_scale = glm::vec3(1.0f);
+
+        bool m_dirty = true;
+        uint32_t m_revision = 0;
+        TransformHierarchy* m_hierarchy = nullptr;
+        uint32_t m_index = 0;
+    };
+
+    // World matrices of a node forest in flat arrays. Every top level node's subtree fills its own contiguous
+    // range of slots, breadth first so every parent precedes its children. Adding or removing nodes only rebuilds
+    // the range of the top level node they hang under, a range that outgrew its slots moves to the end and the
+    // holes left behind are compacted once they make up half of the arrays. Update only recomputes nodes whose
+    // own transform or any ancestor's changed. Renderer, physics and audio read GetWorldMatrices() directly,
+    // pointers into it stay valid until the structure changes.
+    class DLL_EXPORT TransformHierarchy
+    {
+    public:
+        TransformHierarchy() = default;
+        ~TransformHierarchy();
+
+        TransformHierarchy(const TransformHierarchy&) = delete;
+        TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+        void AddRoot(Node* node);
+        void RemoveRoot(Node* node);
+
+        // Called with the slot of a node whose children were added or removed
+        void MarkStructureDirty(uint32_t index);
+        void MarkTransformDirty() { m_transformDirty.store(true, std::memory_order_relaxed); }
+
+        void Update();
+
+        const glm::mat4* GetWorldMatrices() const { return m_world.data(); }
+        const glm::mat4& GetWorldMatrix(uint32_t index) const { return m_world[index]; }
+        // Includes free slots, whose node is nullptr
+        size_t GetCount() const { return m_nodes.size(); }
+
+        const std::vector<Node*>& GetNodes() const { return m_nodes; }
+        // -1 for roots and free slots
+        const std::vector<int32_t>& GetParents() const { return m_parents; }
+
+        size_t GetLastRecomputedCount() const { return m_recomputed.size(); }
+        // Slots whose world matrix the last Update wrote
+        const std::vector<uint32_t>& GetLastRecomputed() const { return m_recomputed; }
+        // The last Update compacted the arrays, slot indices kept from before it are stale
+        bool WasCompacted() const { return m_compacted; }
+
+        // Index whose proxies point at these nodes, Detach drops them so queries never return a node that left
+        void SetSpatialIndex(SpatialIndex* index) { m_spatialIndex = index; }
+
+        // Clears the hierarchy link and spatial proxy of node and everything below it
+        static void Detach(Node& node);
+
+    private:
+        static constexpr uint32_t InvalidRange = 0xFFFFFFFFu;
+        // Free slots below this never trigger a compaction
+        static constexpr size_t MinCompactSlots = 64;
+
+        // Slots of one top level node's subtree, count of them in use and the rest free
+        struct Range
+        {
+            Node* root = nullptr;
+            uint32_t begin = 0;
+            uint32_t count = 0;
+            uint32_t capacity = 0;
+            bool dirty = false;
+        };
+
+        uint32_t FindRange(const Node* root) const;
+        // Lays the subtree out again and computes its world matrices
+        void BuildRange(uint32_t range);
+        void FreeSlots(uint32_t begin, uint32_t count);
+        void Compact();
+
+        std::vector<Range> m_ranges;
+        std::vector<uint32_t> m_freeRanges;
+        std::vector<uint32_t> m_dirtyRanges;
+        SpatialIndex* m_spatialIndex = nullptr;
+
+        std::vector<Node*> m_nodes;
+        std::vector<int32_t> m_parents;
+        std::vector<glm::mat4> m_world;
+        std::vector<uint8_t> m_changed;
+        // Range of every slot, only meaningful for slots in use
+        std::vector<uint32_t> m_rangeOf;
+        size_t m_usedSlots = 0;
+        std::vector<uint32_t> m_recomputed;
+
+        // Reused by BuildRange and Compact
+        std::vector<Node*> m_scratchNodes;
+        std::vector<int32_t> m_scratchParents;
+        std::vector<uint32_t> m_scratchRanges;
+        std::vector<std::pair<uint32_t, uint32_t>> m_scratchRecomputed;
+
+        std::atomic<bool> m_transformDirty{ true };
+        bool m_compacted = false;
+    };
+
+    inline void Transform::MarkDirty()
+    {
+        m_dirty = true;
+        ++m_revision;
+        if (m_hierarchy)
+            m_hierarchy->MarkTransformDirty();
+    }
+
+    inline glm::mat4 Transform::GetWorldMatrix() const
+    {
+        return m_hierarchy ? m_hierarchy->GetWorldMatrix(m_index) : GetLocalMatrix();
+    }
+}
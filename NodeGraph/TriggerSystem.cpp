@@ -0,0 +1,463 @@
+#include "TriggerSystem.h"
+
+#include "../Engine/SIMD.h"
+
+namespace BSE
+{
+    namespace
+    {
+        constexpr size_t Lanes = 4;
+
+        // Keeps the separating axis test stable for nearly parallel edges
+        constexpr float AxisEpsilon = 1e-6f;
+
+        struct Vector4
+        {
+            Float4 x, y, z;
+        };
+
+        Float4 Dot(const Vector4& a, const Vector4& b)
+        {
+            return a.x * b.x + a.y * b.y + a.z * b.z;
+        }
+
+        Float4 Gather(const std::vector<float>& values, const uint32_t* slots)
+        {
+            alignas(16) float lanes[Lanes];
+            for (size_t lane = 0; lane < Lanes; ++lane)
+                lanes[lane] = values[slots[lane]];
+            return Float4::Load(lanes);
+        }
+
+        // Slots of up to four pairs, the last pair repeats to fill unused lanes
+        template<typename Pairs>
+        void FillLanes(const Pairs& pairs, size_t first, size_t count, uint32_t* triggers, uint32_t* activators)
+        {
+            for (size_t lane = 0; lane < Lanes; ++lane)
+            {
+                const auto& pair = pairs[first + std::min(lane, count - 1)];
+                triggers[lane] = pair.trigger;
+                activators[lane] = pair.activator;
+            }
+        }
+    }
+
+    uint32_t TriggerSystem::ShapeArrays::Allocate()
+    {
+        uint32_t slot;
+        if (!freeSlots.empty())
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(Size());
+            const size_t size = Size() + 1;
+
+            for (std::vector<float>* values : { &centerX, &centerY, &centerZ, &halfX, &halfY, &halfZ, &radius, &minX, &maxX, &minY, &maxY, &minZ, &maxZ })
+                values->resize(size, 0.0f);
+            for (std::vector<float>& values : axes)
+                values.resize(size, 0.0f);
+
+            sphere.resize(size, 0);
+            alive.resize(size, 0);
+            inSweep.resize(size, 0);
+            userData.resize(size, nullptr);
+        }
+
+        alive[slot] = 1;
+        ++liveCount;
+        return slot;
+    }
+
+    void TriggerSystem::ShapeArrays::Free(uint32_t slot)
+    {
+        if (slot >= Size() || !alive[slot])
+            return;
+
+        alive[slot] = 0;
+        retiredSlots.push_back(slot);
+        --liveCount;
+    }
+
+    void TriggerSystem::ShapeArrays::RecycleRetired()
+    {
+        for (uint32_t slot : retiredSlots)
+        {
+            userData[slot] = nullptr;
+            freeSlots.push_back(slot);
+        }
+        retiredSlots.clear();
+    }
+
+    void TriggerSystem::ShapeArrays::SetBox(uint32_t slot, const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation)
+    {
+        const glm::mat4 basis = glm::mat4_cast(rotation);
+
+        centerX[slot] = center.x;
+        centerY[slot] = center.y;
+        centerZ[slot] = center.z;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int component = 0; component < 3; ++component)
+                axes[axis * 3 + component][slot] = basis[axis][component];
+        }
+
+        halfX[slot] = halfExtents.x;
+        halfY[slot] = halfExtents.y;
+        halfZ[slot] = halfExtents.z;
+        radius[slot] = 0.0f;
+        sphere[slot] = 0;
+    }
+
+    void TriggerSystem::ShapeArrays::SetSphere(uint32_t slot, const glm::vec3& center, float sphereRadius)
+    {
+        centerX[slot] = center.x;
+        centerY[slot] = center.y;
+        centerZ[slot] = center.z;
+        radius[slot] = sphereRadius;
+        sphere[slot] = 1;
+    }
+
+    void TriggerSystem::ShapeArrays::ComputeBounds()
+    {
+        for (size_t slot = 0; slot < Size(); ++slot)
+        {
+            if (!alive[slot])
+                continue;
+
+            float extent[3];
+            for (int component = 0; component < 3; ++component)
+            {
+                if (sphere[slot])
+                {
+                    extent[component] = radius[slot];
+                    continue;
+                }
+
+                extent[component] = std::fabs(axes[component][slot]) * halfX[slot]
+                                  + std::fabs(axes[3 + component][slot]) * halfY[slot]
+                                  + std::fabs(axes[6 + component][slot]) * halfZ[slot];
+            }
+
+            minX[slot] = centerX[slot] - extent[0];
+            maxX[slot] = centerX[slot] + extent[0];
+            minY[slot] = centerY[slot] - extent[1];
+            maxY[slot] = centerY[slot] + extent[1];
+            minZ[slot] = centerZ[slot] - extent[2];
+            maxZ[slot] = centerZ[slot] + extent[2];
+        }
+    }
+
+    uint32_t TriggerSystem::AddBoxTrigger(const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation, void* userData)
+    {
+        const uint32_t slot = m_triggers.Allocate();
+        m_triggers.SetBox(slot, center, halfExtents, rotation);
+        m_triggers.userData[slot] = userData;
+        return slot;
+    }
+
+    uint32_t TriggerSystem::AddSphereTrigger(const glm::vec3& center, float radius, void* userData)
+    {
+        const uint32_t slot = m_triggers.Allocate();
+        m_triggers.SetSphere(slot, center, radius);
+        m_triggers.userData[slot] = userData;
+        return slot;
+    }
+
+    uint32_t TriggerSystem::AddActivator(const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation, void* userData)
+    {
+        const uint32_t slot = m_activators.Allocate();
+        m_activators.SetBox(slot, center, halfExtents, rotation);
+        m_activators.userData[slot] = userData;
+        return slot;
+    }
+
+    void TriggerSystem::SetBoxTrigger(uint32_t trigger, const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation)
+    {
+        if (trigger < m_triggers.Size() && m_triggers.alive[trigger])
+            m_triggers.SetBox(trigger, center, halfExtents, rotation);
+    }
+
+    void TriggerSystem::SetSphereTrigger(uint32_t trigger, const glm::vec3& center, float radius)
+    {
+        if (trigger < m_triggers.Size() && m_triggers.alive[trigger])
+            m_triggers.SetSphere(trigger, center, radius);
+    }
+
+    void TriggerSystem::SetActivator(uint32_t activator, const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation)
+    {
+        if (activator < m_activators.Size() && m_activators.alive[activator])
+            m_activators.SetBox(activator, center, halfExtents, rotation);
+    }
+
+    // The shape's pairs stay in m_overlaps, Step no longer finds them and reports their Exit
+    void TriggerSystem::RemoveTrigger(uint32_t trigger)
+    {
+        m_triggers.Free(trigger);
+    }
+
+    void TriggerSystem::RemoveActivator(uint32_t activator)
+    {
+        m_activators.Free(activator);
+    }
+
+    bool TriggerSystem::IsOverlapping(uint32_t trigger, uint32_t activator) const
+    {
+        if (trigger >= m_triggers.Size() || !m_triggers.alive[trigger] || activator >= m_activators.Size() || !m_activators.alive[activator])
+            return false;
+
+        return std::binary_search(m_overlaps.begin(), m_overlaps.end(), PairKey(trigger, activator));
+    }
+
+    void TriggerSystem::Step()
+    {
+        m_triggers.ComputeBounds();
+        m_activators.ComputeBounds();
+
+        UpdateSweepList();
+        Broadphase();
+
+        m_nextOverlaps.clear();
+        NarrowphaseBoxes();
+        NarrowphaseSpheres();
+        std::sort(m_nextOverlaps.begin(), m_nextOverlaps.end());
+
+        // Both lists are sorted, one merge finds every transition
+        m_events.clear();
+        size_t previous = 0;
+        size_t current = 0;
+        while (previous < m_overlaps.size() || current < m_nextOverlaps.size())
+        {
+            TriggerEventType type;
+            uint64_t key;
+
+            if (current == m_nextOverlaps.size() || (previous < m_overlaps.size() && m_overlaps[previous] < m_nextOverlaps[current]))
+            {
+                type = TriggerEventType::Exit;
+                key = m_overlaps[previous++];
+            }
+            else if (previous == m_overlaps.size() || m_nextOverlaps[current] < m_overlaps[previous])
+            {
+                type = TriggerEventType::Enter;
+                key = m_nextOverlaps[current++];
+            }
+            else
+            {
+                type = TriggerEventType::Stay;
+                key = m_nextOverlaps[current++];
+                ++previous;
+            }
+
+            m_events.push_back(TriggerEvent{ type, uint32_t(key >> 32), uint32_t(key) });
+        }
+
+        std::swap(m_overlaps, m_nextOverlaps);
+
+        m_triggers.RecycleRetired();
+        m_activators.RecycleRetired();
+    }
+
+    void TriggerSystem::UpdateSweepList()
+    {
+        // Drop entries of freed shapes, then append shapes that are new since the last Step
+        m_sweep.erase(std::remove_if(m_sweep.begin(), m_sweep.end(), [this](const SweepEntry& entry) {
+            ShapeArrays& shapes = entry.trigger ? m_triggers : m_activators;
+            if (shapes.alive[entry.slot])
+                return false;
+
+            shapes.inSweep[entry.slot] = 0;
+            return true;
+        }), m_sweep.end());
+
+        for (bool trigger : { true, false })
+        {
+            ShapeArrays& shapes = trigger ? m_triggers : m_activators;
+            for (size_t slot = 0; slot < shapes.Size(); ++slot)
+            {
+                if (!shapes.alive[slot] || shapes.inSweep[slot])
+                    continue;
+
+                shapes.inSweep[slot] = 1;
+                m_sweep.push_back(SweepEntry{ 0.0f, 0.0f, static_cast<uint32_t>(slot), trigger });
+            }
+        }
+
+        for (SweepEntry& entry : m_sweep)
+        {
+            const ShapeArrays& shapes = entry.trigger ? m_triggers : m_activators;
+            entry.minX = shapes.minX[entry.slot];
+            entry.maxX = shapes.maxX[entry.slot];
+        }
+
+        for (size_t i = 1; i < m_sweep.size(); ++i)
+        {
+            const SweepEntry entry = m_sweep[i];
+            size_t j = i;
+            while (j > 0 && m_sweep[j - 1].minX > entry.minX)
+            {
+                m_sweep[j] = m_sweep[j - 1];
+                --j;
+            }
+            m_sweep[j] = entry;
+        }
+    }
+
+    void TriggerSystem::Broadphase()
+    {
+        m_boxPairs.clear();
+        m_spherePairs.clear();
+
+        for (size_t i = 0; i < m_sweep.size(); ++i)
+        {
+            const SweepEntry& first = m_sweep[i];
+            for (size_t j = i + 1; j < m_sweep.size() && m_sweep[j].minX <= first.maxX; ++j)
+            {
+                const SweepEntry& second = m_sweep[j];
+                if (first.trigger == second.trigger)
+                    continue;
+
+                const uint32_t trigger = first.trigger ? first.slot : second.slot;
+                const uint32_t activator = first.trigger ? second.slot : first.slot;
+
+                if (m_triggers.minY[trigger] > m_activators.maxY[activator] || m_triggers.maxY[trigger] < m_activators.minY[activator]
+                    || m_triggers.minZ[trigger] > m_activators.maxZ[activator] || m_triggers.maxZ[trigger] < m_activators.minZ[activator])
+                    continue;
+
+                (m_triggers.sphere[trigger] ? m_spherePairs : m_boxPairs).push_back(Candidate{ trigger, activator });
+            }
+        }
+
+        m_candidateCount = m_boxPairs.size() + m_spherePairs.size();
+    }
+
+    // Separating axis test between two oriented boxes, four pairs per iteration
+    void TriggerSystem::NarrowphaseBoxes()
+    {
+        const ShapeArrays& a = m_triggers;
+        const ShapeArrays& b = m_activators;
+
+        for (size_t first = 0; first < m_boxPairs.size(); first += Lanes)
+        {
+            const size_t count = std::min(Lanes, m_boxPairs.size() - first);
+
+            uint32_t aSlots[Lanes];
+            uint32_t bSlots[Lanes];
+            FillLanes(m_boxPairs, first, count, aSlots, bSlots);
+
+            Vector4 axisA[3];
+            Vector4 axisB[3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                axisA[axis] = { Gather(a.axes[axis * 3], aSlots), Gather(a.axes[axis * 3 + 1], aSlots), Gather(a.axes[axis * 3 + 2], aSlots) };
+                axisB[axis] = { Gather(b.axes[axis * 3], bSlots), Gather(b.axes[axis * 3 + 1], bSlots), Gather(b.axes[axis * 3 + 2], bSlots) };
+            }
+
+            const Float4 extentA[3] = { Gather(a.halfX, aSlots), Gather(a.halfY, aSlots), Gather(a.halfZ, aSlots) };
+            const Float4 extentB[3] = { Gather(b.halfX, bSlots), Gather(b.halfY, bSlots), Gather(b.halfZ, bSlots) };
+
+            const Vector4 offset = {
+                Gather(b.centerX, bSlots) - Gather(a.centerX, aSlots),
+                Gather(b.centerY, bSlots) - Gather(a.centerY, aSlots),
+                Gather(b.centerZ, bSlots) - Gather(a.centerZ, aSlots)
+            };
+
+            // B's axes expressed in A's frame, and the offset between the centers in A's frame
+            Float4 rotation[3][3];
+            Float4 absRotation[3][3];
+            const Float4 epsilon(AxisEpsilon);
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    rotation[i][j] = Dot(axisA[i], axisB[j]);
+                    absRotation[i][j] = Abs(rotation[i][j]) + epsilon;
+                }
+            }
+
+            const Float4 t[3] = { Dot(offset, axisA[0]), Dot(offset, axisA[1]), Dot(offset, axisA[2]) };
+
+            Float4 separated;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const Float4 radiusB = extentB[0] * absRotation[i][0] + extentB[1] * absRotation[i][1] + extentB[2] * absRotation[i][2];
+                separated = separated | (Abs(t[i]) > extentA[i] + radiusB);
+            }
+
+            for (int j = 0; j < 3; ++j)
+            {
+                const Float4 radiusA = extentA[0] * absRotation[0][j] + extentA[1] * absRotation[1][j] + extentA[2] * absRotation[2][j];
+                const Float4 distance = t[0] * rotation[0][j] + t[1] * rotation[1][j] + t[2] * rotation[2][j];
+                separated = separated | (Abs(distance) > radiusA + extentB[j]);
+            }
+
+            // Cross products of every axis pair
+            for (int i = 0; i < 3; ++i)
+            {
+                const int i1 = (i + 1) % 3;
+                const int i2 = (i + 2) % 3;
+                for (int j = 0; j < 3; ++j)
+                {
+                    const int j1 = (j + 1) % 3;
+                    const int j2 = (j + 2) % 3;
+
+                    const Float4 radiusA = extentA[i1] * absRotation[i2][j] + extentA[i2] * absRotation[i1][j];
+                    const Float4 radiusB = extentB[j1] * absRotation[i][j2] + extentB[j2] * absRotation[i][j1];
+                    const Float4 distance = t[i2] * rotation[i1][j] - t[i1] * rotation[i2][j];
+                    separated = separated | (Abs(distance) > radiusA + radiusB);
+                }
+            }
+
+            const int mask = separated.MoveMask();
+            for (size_t lane = 0; lane < count; ++lane)
+            {
+                if ((mask & (1 << lane)) == 0)
+                    m_nextOverlaps.push_back(PairKey(aSlots[lane], bSlots[lane]));
+            }
+        }
+    }
+
+    // Closest point on the oriented box to the sphere center, four pairs per iteration
+    void TriggerSystem::NarrowphaseSpheres()
+    {
+        const ShapeArrays& s = m_triggers;
+        const ShapeArrays& b = m_activators;
+        const Float4 zero;
+
+        for (size_t first = 0; first < m_spherePairs.size(); first += Lanes)
+        {
+            const size_t count = std::min(Lanes, m_spherePairs.size() - first);
+
+            uint32_t sSlots[Lanes];
+            uint32_t bSlots[Lanes];
+            FillLanes(m_spherePairs, first, count, sSlots, bSlots);
+
+            const Vector4 offset = {
+                Gather(s.centerX, sSlots) - Gather(b.centerX, bSlots),
+                Gather(s.centerY, sSlots) - Gather(b.centerY, bSlots),
+                Gather(s.centerZ, sSlots) - Gather(b.centerZ, bSlots)
+            };
+
+            const Float4 extent[3] = { Gather(b.halfX, bSlots), Gather(b.halfY, bSlots), Gather(b.halfZ, bSlots) };
+
+            Float4 distanceSquared;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const Vector4 direction = { Gather(b.axes[axis * 3], bSlots), Gather(b.axes[axis * 3 + 1], bSlots), Gather(b.axes[axis * 3 + 2], bSlots) };
+                const Float4 outside = Max(Abs(Dot(offset, direction)) - extent[axis], zero);
+                distanceSquared = distanceSquared + outside * outside;
+            }
+
+            const Float4 radius = Gather(s.radius, sSlots);
+            const int mask = (distanceSquared <= radius * radius).MoveMask();
+            for (size_t lane = 0; lane < count; ++lane)
+            {
+                if ((mask & (1 << lane)) != 0)
+                    m_nextOverlaps.push_back(PairKey(sSlots[lane], bSlots[lane]));
+            }
+        }
+    }
+}
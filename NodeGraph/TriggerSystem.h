@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace BSE
+{
+    enum class TriggerEventType : uint8_t
+    {
+        Enter,
+        Stay,
+        Exit
+    };
+
+    struct DLL_EXPORT TriggerEvent
+    {
+        TriggerEventType type;
+        uint32_t trigger;
+        uint32_t activator;
+    };
+
+    // Overlap tests between trigger volumes (oriented boxes or spheres) and activators (oriented boxes).
+    // Shapes live in SoA arrays, Step sorts them along x for a sweep and prune pass and tests the surviving
+    // pairs four at a time, then reports how the overlapping set changed since the previous Step.
+    class DLL_EXPORT TriggerSystem
+    {
+    public:
+        static constexpr uint32_t InvalidId = 0xFFFFFFFFu;
+
+        uint32_t AddBoxTrigger(const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation, void* userData = nullptr);
+        uint32_t AddSphereTrigger(const glm::vec3& center, float radius, void* userData = nullptr);
+        uint32_t AddActivator(const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation, void* userData = nullptr);
+
+        void SetBoxTrigger(uint32_t trigger, const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation);
+        void SetSphereTrigger(uint32_t trigger, const glm::vec3& center, float radius);
+        void SetActivator(uint32_t activator, const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation);
+
+        // Pairs involving a removed shape get their Exit event in the next Step. The id and user data stay
+        // reserved until then so listeners can tell which shape left. Components remove their shapes when
+        // destroyed, so user data in those Exit events is only good as a key.
+        void RemoveTrigger(uint32_t trigger);
+        void RemoveActivator(uint32_t activator);
+
+        void* GetTriggerUserData(uint32_t trigger) const { return m_triggers.userData[trigger]; }
+        void* GetActivatorUserData(uint32_t activator) const { return m_activators.userData[activator]; }
+
+        // Enter for pairs that started overlapping, Stay for pairs that still do and Exit for pairs that stopped
+        void Step();
+
+        const std::vector<TriggerEvent>& GetEvents() const { return m_events; }
+        bool IsOverlapping(uint32_t trigger, uint32_t activator) const;
+
+        size_t GetTriggerCount() const { return m_triggers.liveCount; }
+        size_t GetActivatorCount() const { return m_activators.liveCount; }
+        // Pairs that passed the broadphase in the last Step
+        size_t GetCandidateCount() const { return m_candidateCount; }
+
+    private:
+        // Boxes use center, unit axes and half extents, spheres only center and radius. World bounds are
+        // refreshed at the start of every Step.
+        struct ShapeArrays
+        {
+            std::vector<float> centerX, centerY, centerZ;
+            // axes[axis * 3 + component]
+            std::vector<float> axes[9];
+            std::vector<float> halfX, halfY, halfZ;
+            std::vector<float> radius;
+            std::vector<float> minX, maxX, minY, maxY, minZ, maxZ;
+            std::vector<uint8_t> sphere;
+            std::vector<uint8_t> alive;
+            std::vector<uint8_t> inSweep;
+            std::vector<void*> userData;
+
+            std::vector<uint32_t> freeSlots;
+            // Freed since the last Step, reused only once their Exit events went out
+            std::vector<uint32_t> retiredSlots;
+            size_t liveCount = 0;
+
+            uint32_t Allocate();
+            void Free(uint32_t slot);
+            void RecycleRetired();
+            void SetBox(uint32_t slot, const glm::vec3& center, const glm::vec3& halfExtents, const glm::quat& rotation);
+            void SetSphere(uint32_t slot, const glm::vec3& center, float radius);
+            void ComputeBounds();
+            size_t Size() const { return alive.size(); }
+        };
+
+        struct SweepEntry
+        {
+            float minX;
+            float maxX;
+            uint32_t slot;
+            bool trigger;
+        };
+
+        struct Candidate
+        {
+            uint32_t trigger;
+            uint32_t activator;
+        };
+
+        static uint64_t PairKey(uint32_t trigger, uint32_t activator) { return (uint64_t(trigger) << 32) | activator; }
+
+        void UpdateSweepList();
+        void Broadphase();
+        void NarrowphaseBoxes();
+        void NarrowphaseSpheres();
+
+        ShapeArrays m_triggers;
+        ShapeArrays m_activators;
+
+        // Kept between steps, the order barely changes so the insertion sort is close to linear
+        std::vector<SweepEntry> m_sweep;
+
+        std::vector<Candidate> m_boxPairs;
+        std::vector<Candidate> m_spherePairs;
+        size_t m_candidateCount = 0;
+
+        // Sorted pair keys of the last Step, the scratch list collects the next ones
+        std::vector<uint64_t> m_overlaps;
+        std::vector<uint64_t> m_nextOverlaps;
+        std::vector<TriggerEvent> m_events;
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+#include "../Engine/Hash.h"
+
+namespace BSE
+{
+    using TypeId = uint64_t;
+
+    namespace Detail
+    {
+        template<typename T>
+        constexpr std::string_view TypeSignature() noexcept
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            return __FUNCSIG__;
+#else
+            return __PRETTY_FUNCTION__;
+#endif
+        }
+    }
+
+    // Hash of the compiler's spelling of T. Every module computes the same value without RTTI or a shared
+    // registry, so ids agree across shared library boundaries.
+    template<typename T>
+    constexpr TypeId GetTypeId() noexcept
+    {
+        constexpr TypeId id = HashFNV1a64(Detail::TypeSignature<std::remove_cv_t<T>>());
+        return id;
+    }
+}
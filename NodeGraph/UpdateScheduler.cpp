@@ -0,0 +1,85 @@
+#include "UpdateScheduler.h"
+#include "Node.h"
+
+namespace BSE
+{
+    void UpdateScheduler::BeginTick()
+    {
+        ++m_tick;
+        m_updated.store(0, std::memory_order_relaxed);
+        m_skipped.store(0, std::memory_order_relaxed);
+    }
+
+    UpdateDecision UpdateScheduler::Schedule(Node& node, double Tick, const UpdateDecision& parent)
+    {
+        const UpdatePolicy& policy = node.updatePolicy;
+        UpdateState& state = node.updateState;
+        UpdateDecision decision{ false, 0.0 };
+
+        if (node.IsAsleep())
+        {
+            // Woken nodes resume with a single tick instead of catching up on their sleep
+            state.lastTick = m_tick;
+        }
+        else if (policy.rate == UpdateRate::Inherit)
+        {
+            decision = parent;
+        }
+        else
+        {
+            if (!state.scheduled)
+            {
+                state.phase = AssignPhase(policy);
+                state.lastTick = m_tick - 1;
+                state.scheduled = true;
+            }
+
+            uint32_t interval = 1;
+            if (policy.rate == UpdateRate::Interval)
+                interval = policy.interval;
+            else if (policy.rate == UpdateRate::Distance)
+                interval = GetInterval(policy, node.GetTransform().GetWorldPosition());
+
+            if (interval <= 1 || (m_tick + state.phase) % interval == 0)
+            {
+                decision.due = true;
+                decision.elapsed = static_cast<double>(m_tick - state.lastTick) * Tick;
+                state.lastTick = m_tick;
+            }
+        }
+
+        (decision.due ? m_updated : m_skipped).fetch_add(1, std::memory_order_relaxed);
+        return decision;
+    }
+
+    uint32_t UpdateScheduler::GetInterval(const UpdatePolicy& policy, const glm::vec3& position) const
+    {
+        if (!m_hasObserver || policy.interval <= 1)
+            return 1;
+
+        const float distance = glm::length(position - m_observer);
+        if (distance <= policy.nearDistance)
+            return 1;
+
+        uint32_t interval = policy.interval;
+        if (distance < policy.farDistance)
+        {
+            const float t = (distance - policy.nearDistance) / (policy.farDistance - policy.nearDistance);
+            interval = 1 + static_cast<uint32_t>(t * static_cast<float>(policy.interval - 1));
+        }
+
+        // Highest power of two not above interval
+        uint32_t power = 1;
+        while (power <= interval / 2)
+            power *= 2;
+        return power;
+    }
+
+    uint32_t UpdateScheduler::AssignPhase(const UpdatePolicy& policy)
+    {
+        const uint32_t key = policy.rate == UpdateRate::Interval ? policy.interval : 0;
+
+        std::lock_guard<std::mutex> lock(m_phaseMutex);
+        return m_nextPhase[key]++;
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+namespace BSE
+{
+    class Node;
+
+    enum class UpdateRate : uint8_t
+    {
+        // Same decision as the parent, every tick for roots
+        Inherit,
+        EveryTick,
+        Interval,
+        // Interval grows with the distance to the scheduler's observer
+        Distance,
+        // Every tick while awake, starts asleep
+        Dormant
+    };
+
+    // How often a node's components get Update when driven by a scene. Nodes that skip ticks are handed the
+    // whole time since their last update, so rate only trades accuracy for cost, never simulation speed.
+    struct DLL_EXPORT UpdatePolicy
+    {
+        UpdateRate rate = UpdateRate::Inherit;
+        uint32_t interval = 1;
+
+        // Every tick up to nearDistance, maxInterval from farDistance on
+        float nearDistance = 0.0f;
+        float farDistance = 0.0f;
+
+        static UpdatePolicy Inherit() { return UpdatePolicy(); }
+
+        static UpdatePolicy EveryTick()
+        {
+            UpdatePolicy policy;
+            policy.rate = UpdateRate::EveryTick;
+            return policy;
+        }
+
+        static UpdatePolicy EveryNTicks(uint32_t ticks)
+        {
+            UpdatePolicy policy;
+            policy.rate = UpdateRate::Interval;
+            policy.interval = std::max(ticks, 1u);
+            return policy;
+        }
+
+        static UpdatePolicy DistanceScaled(float nearDistance, float farDistance, uint32_t maxInterval)
+        {
+            UpdatePolicy policy;
+            policy.rate = UpdateRate::Distance;
+            policy.interval = std::max(maxInterval, 1u);
+            policy.nearDistance = nearDistance;
+            policy.farDistance = std::max(farDistance, nearDistance);
+            return policy;
+        }
+
+        static UpdatePolicy Dormant()
+        {
+            UpdatePolicy policy;
+            policy.rate = UpdateRate::Dormant;
+            return policy;
+        }
+    };
+
+    struct UpdateDecision
+    {
+        bool due = true;
+        // Seconds the node's components should advance by
+        double elapsed = 0.0;
+    };
+
+    // Per node bookkeeping, only touched by the scheduler
+    struct UpdateState
+    {
+        uint64_t lastTick = 0;
+        uint32_t phase = 0;
+        bool scheduled = false;
+    };
+
+    // Decides which nodes update on the current tick. Nodes sharing an interval get consecutive phases, so
+    // each tick runs the same share of them instead of all of them landing on one tick. Schedule may be called
+    // concurrently for different nodes.
+    class DLL_EXPORT UpdateScheduler
+    {
+    public:
+        // Distance scaled nodes measure from here, usually the camera. Without an observer they run every tick.
+        void SetObserver(const glm::vec3& position)
+        {
+            m_observer = position;
+            m_hasObserver = true;
+        }
+
+        void ClearObserver() { m_hasObserver = false; }
+
+        void BeginTick();
+
+        // Whether node updates this tick, nodes inheriting their policy take the parent's decision. Roots pass
+        // { true, Tick } as parent.
+        UpdateDecision Schedule(Node& node, double Tick, const UpdateDecision& parent);
+
+        // Distance policies round down to powers of two, so the ticks due at a long interval are a subset of those
+        // due at every shorter one and a node changing band never waits longer than its new interval
+        uint32_t GetInterval(const UpdatePolicy& policy, const glm::vec3& position) const;
+
+        uint64_t GetTick() const { return m_tick; }
+        // Nodes that ran and skipped since BeginTick
+        size_t GetUpdatedCount() const { return m_updated.load(std::memory_order_relaxed); }
+        size_t GetSkippedCount() const { return m_skipped.load(std::memory_order_relaxed); }
+
+    private:
+        uint32_t AssignPhase(const UpdatePolicy& policy);
+
+        uint64_t m_tick = 0;
+
+        glm::vec3 m_observer = glm::vec3(0.0f);
+        bool m_hasObserver = false;
+
+        // Next phase per fixed interval, distance scaled nodes share key 0
+        std::mutex m_phaseMutex;
+        std::unordered_map<uint32_t, uint32_t> m_nextPhase;
+
+        std::atomic<size_t> m_updated{ 0 };
+        std::atomic<size_t> m_skipped{ 0 };
+    };
+}
@@ -6,6 +6,8 @@
 #include "../ThirdParty/JoltPhysics/Jolt/Core/Factory.h"
 #include "../ThirdParty/JoltPhysics/Jolt/Core/TempAllocator.h"
 #include "../ThirdParty/JoltPhysics/Jolt/Core/JobSystemThreadPool.h"
+#include "../ThirdParty/JoltPhysics/Jolt/Core/JobSystemWithBarrier.h"
+#include "../ThirdParty/JoltPhysics/Jolt/Core/FixedSizeFreeList.h"
 #include "../ThirdParty/JoltPhysics/Jolt/Physics/PhysicsSettings.h"
 #include "../ThirdParty/JoltPhysics/Jolt/Physics/PhysicsSystem.h"
 #include "../ThirdParty/JoltPhysics/Jolt/Physics/Collision/Shape/BoxShape.h"
@@ -54,12 +54,26 @@ namespace BSE
         unsigned int cores = Engine::GetCPUThreadCount();
         unsigned int physicsThreads = std::clamp(cores / 2, 2u, 4u);
 
-        m_TempAllocator = std::make_unique<JPH::TempAllocatorImpl>(10 * 1024 * 1024);
+        JPH::RegisterDefaultAllocator();
+
         m_JobSystem = std::make_unique<JPH::JobSystemThreadPool>(1024, 256, physicsThreads);
-        m_JobSystem->Init(1024, 256, physicsThreads);
 
+        InitializeSystem();
+    }
+
+    void PhysicsCore::Initialize(ThreadPool& pool, const PhysicsJobSystemSettings& settings)
+    {
         JPH::RegisterDefaultAllocator();
 
+        m_JobSystem = std::make_unique<PhysicsJobSystem>(pool, settings);
+
+        InitializeSystem();
+    }
+
+    void PhysicsCore::InitializeSystem()
+    {
+        m_TempAllocator = std::make_unique<JPH::TempAllocatorImpl>(10 * 1024 * 1024);
+
         m_PhysicsSystem = std::make_unique<JPH::PhysicsSystem>();
 
         const uint32_t numObjectLayers = static_cast<uint32_t>(MyObjectLayer::LAYER_COUNT);
@@ -80,6 +94,14 @@ namespace BSE
         );
     }
 
+    void PhysicsCore::Update(float deltaTime, int collisionSteps)
+    {
+        if (!m_PhysicsSystem)
+            return;
+
+        m_PhysicsSystem->Update(deltaTime, collisionSteps, m_TempAllocator.get(), m_JobSystem.get());
+    }
+
     void PhysicsCore::Destroy()
     {
         m_PhysicsSystem.reset();
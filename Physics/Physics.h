@@ -4,20 +4,29 @@
 #include "../Engine/StandardInclude.h"
 
 #include "Jolt.h"
+#include "PhysicsJobSystem.h"
 
 namespace BSE
 {
     class DLL_EXPORT PhysicsCore
     {
     public:
+        // Standalone setup with Jolt's own worker threads, for tools that run without an engine pool
         void Initialize();
+        // Schedules physics jobs on the engine pool instead of spawning extra threads
+        void Initialize(ThreadPool& pool, const PhysicsJobSystemSettings& settings = PhysicsJobSystemSettings());
         void Destroy();
 
+        // Steps the simulation, meant to run as its own frame stage so it overlaps with node updates
+        void Update(float deltaTime, int collisionSteps = 1);
+
         JPH::PhysicsSystem& GetPhysicsSystem() { return *m_PhysicsSystem; }
 
     private:
+        void InitializeSystem();
+
         std::unique_ptr<JPH::TempAllocatorImpl> m_TempAllocator;
-        std::unique_ptr<JPH::JobSystemThreadPool> m_JobSystem;
+        std::unique_ptr<JPH::JobSystem> m_JobSystem;
         std::unique_ptr<JPH::PhysicsSystem> m_PhysicsSystem;
         
         std::unique_ptr<JPH::BroadPhaseLayerInterface> m_BroadPhaseLayerInterface;
@@ -64,6 +64,7 @@ namespace BSE
 
         void AttachModel(BSE::Model& model);
 
+        // Once per fixed tick after the physics step, the model keeps the previous tick's pose to blend from when rendered with an alpha
         void SyncModelFromPhysics(JPH::BodyInterface &bodyInterface);
         void SyncPhysicsFromModel(JPH::BodyInterface &bodyInterface, float tick);
 
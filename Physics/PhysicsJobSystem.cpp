@@ -0,0 +1,70 @@
+#include "PhysicsJobSystem.h"
+
+#include <thread>
+
+namespace BSE
+{
+    PhysicsJobSystem::PhysicsJobSystem(ThreadPool& pool, const PhysicsJobSystemSettings& settings)
+        : JPH::JobSystemWithBarrier(settings.maxBarriers)
+        , m_pool(pool)
+        , m_priority(settings.priority)
+    {
+        m_maxConcurrency = settings.maxConcurrency > 0 ? settings.maxConcurrency : static_cast<int>(pool.GetThreadCount());
+        m_jobs.Init(settings.maxJobs, settings.maxJobs);
+    }
+
+    PhysicsJobSystem::~PhysicsJobSystem()
+    {
+        // A barrier can be satisfied before the worker that ran the last job dropped its reference
+        // Spin rather than wait/notify so no worker touches this object after its last decrement
+        while (m_queuedJobs.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+    }
+
+    PhysicsJobSystem::JobHandle PhysicsJobSystem::CreateJob(const char* name, JPH::ColorArg color, const JobFunction& function, JPH::uint32 dependencyCount)
+    {
+        JPH::uint32 index;
+        while (true)
+        {
+            index = m_jobs.ConstructObject(name, color, this, function, dependencyCount);
+            if (index != JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex)
+                break;
+
+            // Out of job slots, wait for running jobs to hand theirs back
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        Job* job = &m_jobs.Get(index);
+
+        // Take the handle before queueing, the job may finish and free itself right away otherwise
+        JobHandle handle(job);
+        if (dependencyCount == 0)
+            QueueJob(job);
+
+        return handle;
+    }
+
+    void PhysicsJobSystem::QueueJob(Job* job)
+    {
+        job->AddRef();
+        m_queuedJobs.fetch_add(1, std::memory_order_relaxed);
+
+        m_pool.Schedule([this, job]() {
+            job->Execute();
+            job->Release();
+
+            m_queuedJobs.fetch_sub(1, std::memory_order_release);
+        }, {}, m_priority);
+    }
+
+    void PhysicsJobSystem::QueueJobs(Job** jobs, JPH::uint count)
+    {
+        for (JPH::uint i = 0; i < count; ++i)
+            QueueJob(jobs[i]);
+    }
+
+    void PhysicsJobSystem::FreeJob(Job* job)
+    {
+        m_jobs.DestructObject(job);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include "Jolt.h"
+
+#include "../Threading/ThreadingSystem.h"
+
+namespace BSE
+{
+    struct DLL_EXPORT PhysicsJobSystemSettings
+    {
+        uint32_t maxJobs = 1024;
+        uint32_t maxBarriers = 256;
+        // How many ways Jolt splits its work, 0 uses the pool's thread count
+        int maxConcurrency = 0;
+        // The simulation step usually sits on the frame's critical path
+        JobPriority priority = JobPriority::FrameCritical;
+    };
+
+    // Runs Jolt's jobs on the engine ThreadPool, so physics and engine work share one set of workers
+    class DLL_EXPORT PhysicsJobSystem final : public JPH::JobSystemWithBarrier
+    {
+    public:
+        explicit PhysicsJobSystem(ThreadPool& pool, const PhysicsJobSystemSettings& settings = PhysicsJobSystemSettings());
+        ~PhysicsJobSystem() override;
+
+        int GetMaxConcurrency() const override { return m_maxConcurrency; }
+        JobHandle CreateJob(const char* name, JPH::ColorArg color, const JobFunction& function, JPH::uint32 dependencyCount = 0) override;
+
+    protected:
+        void QueueJob(Job* job) override;
+        void QueueJobs(Job** jobs, JPH::uint count) override;
+        void FreeJob(Job* job) override;
+
+    private:
+        ThreadPool& m_pool;
+        int m_maxConcurrency = 1;
+        JobPriority m_priority = JobPriority::FrameCritical;
+
+        JPH::FixedSizeFreeList<Job> m_jobs;
+        // Jobs handed to the pool that have not released their reference yet
+        std::atomic<uint32_t> m_queuedJobs{ 0 };
+    };
+}
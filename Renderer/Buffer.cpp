@@ -1,4 +1,5 @@
 #include "Buffer.h"
+#include "../Engine/DestructionQueue.h"
 
 namespace BSE
 {
@@ -11,7 +12,7 @@ namespace BSE
     {
         if (bufferID != 0)
         {
-            glDeleteBuffers(1, &bufferID);
+            DestructionQueue::Release(GPUResource::GLBuffer, bufferID);
             bufferID = 0;
             bufferSize = 0;
         }
@@ -21,7 +22,7 @@ namespace BSE
     {
         if (bufferID != 0)
         {
-            glDeleteBuffers(1, &bufferID);
+            DestructionQueue::Release(GPUResource::GLBuffer, bufferID);
             bufferID = 0;
             bufferSize = 0;
         }
@@ -78,7 +79,7 @@ namespace BSE
     {
         if (bufferID != 0)
         {
-            glDeleteBuffers(1, &bufferID);
+            DestructionQueue::Release(GPUResource::GLBuffer, bufferID);
             bufferID = 0;
             bufferSize = 0;
         }
@@ -87,7 +88,7 @@ namespace BSE
     void ShaderStorageBuffer::Create(GLsizeiptr size, GLenum usage)
     {
         if (bufferID != 0) {
-            glDeleteBuffers(1, &bufferID);
+            DestructionQueue::Release(GPUResource::GLBuffer, bufferID);
             bufferID = 0;
             bufferSize = 0;
         }
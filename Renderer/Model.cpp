@@ -1,6 +1,8 @@
 #include "Model.h"
 #include "AssimpModelLoader.h"
 #include "Shader.h"
+#include "../Engine/DestructionQueue.h"
+#include "../Threading/ThreadingSystem.h"
 #include <sstream>
 
 namespace BSE
@@ -32,43 +34,61 @@ namespace BSE
         return true;
     }
 
-    void ModelProcessor::Process(const std::vector<MeshData>& meshes)
+    void ModelProcessor::Process(const std::vector<MeshData>& meshes, ThreadPool* pool)
     {
         Release();
 
-        for (const MeshData& mesh : meshes)
-        {
-            RenderMesh rmesh;
-            rmesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
-
-            glGenVertexArrays(1, &rmesh.VAO);
-            glGenBuffers(1, &rmesh.VBO);
-            glGenBuffers(1, &rmesh.EBO);
-
-            glBindVertexArray(rmesh.VAO);
+        std::vector<std::vector<float>> vertexData(meshes.size());
+        auto interleave = [&](size_t meshIndex) {
+            const MeshData& mesh = meshes[meshIndex];
+            std::vector<float>& data = vertexData[meshIndex];
 
-            std::vector<float> vertexData;
-            vertexData.reserve(mesh.positions.size() * 8);
+            data.reserve(mesh.positions.size() * 8);
             for (size_t i = 0; i < mesh.positions.size(); ++i)
             {
                 const glm::vec3& p = mesh.positions[i];
                 const glm::vec3& n = (i < mesh.normals.size()) ? mesh.normals[i] : glm::vec3(0.0f, 1.0f, 0.0f);
                 const glm::vec2& uv = (i < mesh.uvs.size()) ? mesh.uvs[i] : glm::vec2(0.0f, 0.0f);
 
-                vertexData.push_back(p.x);
-                vertexData.push_back(p.y);
-                vertexData.push_back(p.z);
+                data.push_back(p.x);
+                data.push_back(p.y);
+                data.push_back(p.z);
 
-                vertexData.push_back(n.x);
-                vertexData.push_back(n.y);
-                vertexData.push_back(n.z);
+                data.push_back(n.x);
+                data.push_back(n.y);
+                data.push_back(n.z);
 
-                vertexData.push_back(uv.x);
-                vertexData.push_back(uv.y);
+                data.push_back(uv.x);
+                data.push_back(uv.y);
             }
+        };
+
+        if (pool)
+        {
+            pool->ParallelFor(0, meshes.size(), interleave, 1);
+        }
+        else
+        {
+            for (size_t i = 0; i < meshes.size(); ++i)
+                interleave(i);
+        }
+
+        // GL calls stay on the thread that owns the context
+        for (size_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+        {
+            const MeshData& mesh = meshes[meshIndex];
+
+            RenderMesh rmesh;
+            rmesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+
+            glGenVertexArrays(1, &rmesh.VAO);
+            glGenBuffers(1, &rmesh.VBO);
+            glGenBuffers(1, &rmesh.EBO);
+
+            glBindVertexArray(rmesh.VAO);
 
             glBindBuffer(GL_ARRAY_BUFFER, rmesh.VBO);
-            glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
+            glBufferData(GL_ARRAY_BUFFER, vertexData[meshIndex].size() * sizeof(float), vertexData[meshIndex].data(), GL_STATIC_DRAW);
 
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rmesh.EBO);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t), mesh.indices.data(), GL_STATIC_DRAW);
@@ -96,9 +116,9 @@ namespace BSE
     {
         for (RenderMesh& mesh : m_renderMeshes)
         {
-            if (mesh.VAO) glDeleteVertexArrays(1, &mesh.VAO);
-            if (mesh.VBO) glDeleteBuffers(1, &mesh.VBO);
-            if (mesh.EBO) glDeleteBuffers(1, &mesh.EBO);
+            DestructionQueue::Release(GPUResource::GLVertexArray, mesh.VAO);
+            DestructionQueue::Release(GPUResource::GLBuffer, mesh.VBO);
+            DestructionQueue::Release(GPUResource::GLBuffer, mesh.EBO);
         }
         m_renderMeshes.clear();
     }
@@ -132,7 +152,7 @@ namespace BSE
         }
     }
 
-    bool Model::LoadFromFile(const std::string& filepath)
+    bool Model::LoadFromFile(const std::string& filepath, ThreadPool* pool)
     {
         Unload();
 
@@ -142,14 +162,14 @@ namespace BSE
         }
 
         const auto& meshes = m_loader.GetMeshes();
-        m_processor.Process(meshes);
+        m_processor.Process(meshes, pool);
 
         UpdateRenderTransforms();
 
         return true;
     }
 
-    bool Model::LoadFromMeshes(const std::vector<MeshData>& meshes)
+    bool Model::LoadFromMeshes(const std::vector<MeshData>& meshes, ThreadPool* pool)
     {
         Unload();
 
@@ -159,7 +179,7 @@ namespace BSE
         }
 
         const auto& m = m_loader.GetMeshes();
-        m_processor.Process(m);
+        m_processor.Process(m, pool);
 
         UpdateRenderTransforms();
 
@@ -234,8 +254,46 @@ namespace BSE
         }
     }
 
+    void Model::UpdateRenderTransforms(ThreadPool& pool)
+    {
+        const glm::mat4 modelTRS = GetModelTRSMatrix();
+
+        const auto& meshes = m_loader.GetMeshes();
+        auto& rmeshes = m_processor.GetRenderMeshesMutable();
+
+        size_t count = std::min(meshes.size(), rmeshes.size());
+        pool.ParallelFor(0, count, [&](size_t i) {
+            rmeshes[i].transform = meshes[i].GetFinalTransform(modelTRS);
+        });
+    }
+
     void Model::Render(ModelRenderer& renderer, const glm::mat4& viewProjMatrix, GLuint shaderProgram)
     {
         renderer.Render(m_processor.GetRenderMeshes(), viewProjMatrix, shaderProgram);
     }
+
+    void Model::Render(ModelRenderer& renderer, const glm::mat4& viewProjMatrix, GLuint shaderProgram, double alpha)
+    {
+        // Models that didn't move during the last tick draw straight from their render meshes
+        const uint64_t tick = GetTick();
+        if (!m_position.IsBlending(tick) && !m_rotation.IsBlending(tick) && !m_scale.IsBlending(tick))
+        {
+            Render(renderer, viewProjMatrix, shaderProgram);
+            return;
+        }
+
+        const glm::mat4 modelTRS = ComposeTRS(m_position.Sample(alpha, tick), m_rotation.Sample(alpha, tick), m_scale.Sample(alpha, tick));
+
+        const auto& meshes = m_loader.GetMeshes();
+        const auto& rmeshes = m_processor.GetRenderMeshes();
+
+        m_blendedMeshes.assign(rmeshes.begin(), rmeshes.end());
+        size_t count = std::min(meshes.size(), m_blendedMeshes.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_blendedMeshes[i].transform = meshes[i].GetFinalTransform(modelTRS);
+        }
+
+        renderer.Render(m_blendedMeshes, viewProjMatrix, shaderProgram);
+    }
 }
@@ -2,11 +2,14 @@
 
 #include "../Engine/Define.h"
 #include "../Engine/StandardInclude.h"
+#include "../Engine/Interpolated.h"
 
 #include "OpenGL.h"
 
 namespace BSE
 {
+    class ThreadPool;
+
     struct DLL_EXPORT MeshData
     {
         std::string name;
@@ -69,7 +72,8 @@ namespace BSE
         ModelProcessor() = default;
         ~ModelProcessor() { Release(); }
 
-        void Process(const std::vector<MeshData>& meshes);
+        // With a pool the vertex data is interleaved in parallel, buffers are always created on the calling thread
+        void Process(const std::vector<MeshData>& meshes, ThreadPool* pool = nullptr);
         void Release();
 
         const std::vector<RenderMesh>& GetRenderMeshes() const { return m_renderMeshes; }
@@ -93,21 +97,33 @@ namespace BSE
         Model() = default;
         ~Model() { Unload(); }
 
-        bool LoadFromFile(const std::string& filepath);
-        bool LoadFromMeshes(const std::vector<MeshData>& meshes);
+        bool LoadFromFile(const std::string& filepath, ThreadPool* pool = nullptr);
+        bool LoadFromMeshes(const std::vector<MeshData>& meshes, ThreadPool* pool = nullptr);
         void Unload();
 
-        void SetPosition(const glm::vec3& pos) { m_position = pos; UpdateRenderTransforms(); }
-        void SetRotation(const glm::quat& rot) { m_rotation = rot; UpdateRenderTransforms(); }
-        void SetScale(const glm::vec3& scale) { m_scale = scale; UpdateRenderTransforms(); }
+        // Time whose ticks transform changes are blended over by Render with an alpha, without one they show at once.
+        // Must outlive the model.
+        void SetTime(const Time* time) { m_time = time; }
+
+        void SetPosition(const glm::vec3& pos) { m_position.Set(pos, GetTick()); UpdateRenderTransforms(); }
+        void SetRotation(const glm::quat& rot) { m_rotation.Set(rot, GetTick()); UpdateRenderTransforms(); }
+        void SetScale(const glm::vec3& scale) { m_scale.Set(scale, GetTick()); UpdateRenderTransforms(); }
 
-        void Translate(const glm::vec3& delta) { m_position += delta; UpdateRenderTransforms(); }
-        void Rotate(const glm::quat& delta) { m_rotation = glm::normalize(delta * m_rotation); UpdateRenderTransforms(); }
-        void Rescale(const glm::vec3& factor) { m_scale *= factor; UpdateRenderTransforms(); }
+        void Translate(const glm::vec3& delta) { m_position.Set(m_position.Get() + delta, GetTick()); UpdateRenderTransforms(); }
+        void Rotate(const glm::quat& delta) { m_rotation.Set(glm::normalize(delta * m_rotation.Get()), GetTick()); UpdateRenderTransforms(); }
+        void Rescale(const glm::vec3& factor) { m_scale.Set(m_scale.Get() * factor, GetTick()); UpdateRenderTransforms(); }
+
+        // Drops the blend from the previous tick, for teleports and spawns
+        void SnapTransform()
+        {
+            m_position.Snap(m_position.Get());
+            m_rotation.Snap(m_rotation.Get());
+            m_scale.Snap(m_scale.Get());
+        }
 
-        glm::vec3 GetPosition() const { return m_position; }
-        glm::quat GetRotation() const { return m_rotation; }
-        glm::vec3 GetScale() const { return m_scale; }
+        glm::vec3 GetPosition() const { return m_position.Get(); }
+        glm::quat GetRotation() const { return m_rotation.Get(); }
+        glm::vec3 GetScale() const { return m_scale.Get(); }
 
         void SetMeshPosition(size_t meshIndex, const glm::vec3& pos);
         void TranslateMesh(size_t meshIndex, const glm::vec3& delta);
@@ -117,26 +133,40 @@ namespace BSE
         void RescaleMesh(size_t meshIndex, const glm::vec3& factor);
 
         void UpdateRenderTransforms();
+        void UpdateRenderTransforms(ThreadPool& pool);
 
         void Render(ModelRenderer& renderer, const glm::mat4& viewProjMatrix, GLuint shaderProgram);
+        // Draws the model between its last two ticks, alpha being GetAlpha() of the model's Time
+        void Render(ModelRenderer& renderer, const glm::mat4& viewProjMatrix, GLuint shaderProgram, double alpha);
 
         const std::vector<MeshData>& GetMeshes() const { return m_loader.GetMeshes(); }
         const std::vector<RenderMesh>& GetRenderMeshes() const { return m_processor.GetRenderMeshes(); }
 
     private:
+        uint64_t GetTick() const { return m_time ? m_time->GetTickIndex() : Time::InvalidTick; }
+
         glm::mat4 GetModelTRSMatrix() const
         {
-            glm::mat4 T = glm::translate(glm::mat4(1.0f), m_position);
-            glm::mat4 R = glm::mat4_cast(m_rotation);
-            glm::mat4 S = glm::scale(glm::mat4(1.0f), m_scale);
+            return ComposeTRS(m_position.Get(), m_rotation.Get(), m_scale.Get());
+        }
+
+        static glm::mat4 ComposeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+        {
+            glm::mat4 T = glm::translate(glm::mat4(1.0f), position);
+            glm::mat4 R = glm::mat4_cast(rotation);
+            glm::mat4 S = glm::scale(glm::mat4(1.0f), scale);
             return T * R * S;
         }
 
         ModelLoader m_loader;
         ModelProcessor m_processor;
 
-        glm::vec3 m_position = glm::vec3(0.0f);
-        glm::quat m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
-        glm::vec3 m_scale = glm::vec3(1.0f);
+        const Time* m_time = nullptr;
+        Interpolated<glm::vec3> m_position{ glm::vec3(0.0f) };
+        Interpolated<glm::quat> m_rotation{ glm::quat(1.0f, 0.0f, 0.0f, 0.0f) };
+        Interpolated<glm::vec3> m_scale{ glm::vec3(1.0f) };
+
+        // Copies of the render meshes with blended transforms, reused every frame
+        std::vector<RenderMesh> m_blendedMeshes;
     };
 }
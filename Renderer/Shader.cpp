@@ -1,4 +1,5 @@
 #include "Shader.h"
+#include "../Engine/DestructionQueue.h"
 
 namespace BSE
 {
@@ -35,7 +36,7 @@ namespace BSE
     {
         if (id != 0)
         {
-            glDeleteShader(id);
+            DestructionQueue::Release(GPUResource::GLShader, id);
             id = 0;
         }
     }
@@ -88,7 +89,7 @@ namespace BSE
     {
         if (m_ownsProgram && programID != 0)
         {
-            glDeleteProgram(programID);
+            DestructionQueue::Release(GPUResource::GLProgram, programID);
             programID = 0;
         }
     }
@@ -182,7 +183,7 @@ namespace BSE
     {
         if (programID != 0)
         {
-            glDeleteProgram(programID);
+            DestructionQueue::Release(GPUResource::GLProgram, programID);
             programID = 0;
         }
     }
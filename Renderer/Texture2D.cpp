@@ -1,4 +1,5 @@
 #include "Texture2D.h"
+#include "../Engine/DestructionQueue.h"
 #include <iostream>
 #include <cstring>
 
@@ -9,7 +10,8 @@ namespace BSE
 {
     bool Texture2D::LoadImageToMemory(const std::string& path, ImageData& out, bool flipVertically)
     {
-        stbi_set_flip_vertically_on_load(flipVertically ? 1 : 0);
+        // Per thread, images may be decoded on workers while another thread loads one
+        stbi_set_flip_vertically_on_load_thread(flipVertically ? 1 : 0);
         unsigned char* data = stbi_load(path.c_str(), &out.width, &out.height, &out.channels, 0);
         if (!data)
         {
@@ -27,7 +29,7 @@ namespace BSE
     {
         if (m_id != 0)
         {
-            glDeleteTextures(1, &m_id);
+            DestructionQueue::Release(GPUResource::GLTexture, m_id);
             m_id = 0;
             m_loaded = false;
         }
@@ -84,8 +86,7 @@ namespace BSE
 
     Texture2D::~Texture2D()
     {
-        if (m_id != 0)
-            glDeleteTextures(1, &m_id);
+        DestructionQueue::Release(GPUResource::GLTexture, m_id);
     }
 
     void Texture2D::Bind(GLuint slot) const
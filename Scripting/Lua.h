@@ -0,0 +1,8 @@
+#pragma once
+
+extern "C"
+{
+#include <lua.h>
+#include <lualib.h>
+#include <lauxlib.h>
+}
@@ -0,0 +1,642 @@
+#include "ScriptSystem.h"
+#include "Lua.h"
+
+#include "../Engine/Hash.h"
+#include "../Engine/MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#if LUA_VERSION_NUM < 503
+#error "ScriptSystem needs Lua 5.3 or newer"
+#endif
+
+namespace BSE
+{
+    namespace
+    {
+        constexpr uint32_t CacheMagic = 0x4C455342; // "BSEL"
+
+        // Bytecode is only reused by the Lua version that wrote it and while the source hash still matches
+        struct CacheHeader
+        {
+            uint32_t magic;
+            uint32_t luaVersion;
+            uint64_t sourceHash;
+            uint64_t sourceSize;
+            uint64_t bytecodeSize;
+        };
+
+        static_assert(std::is_trivially_copyable_v<CacheHeader>);
+
+        // Node handles given to scripts carry the instance's generation above its index, so a handle kept after
+        // its instance went away stops resolving instead of naming whichever instance reuses the slot
+        static_assert(sizeof(lua_Integer) >= sizeof(uint64_t), "Node handles need 64 bit Lua integers");
+
+        lua_Integer PackNodeHandle(uint32_t index, uint32_t generation)
+        {
+            return static_cast<lua_Integer>((static_cast<uint64_t>(generation) << 32) | index);
+        }
+
+        // Runs every instance of every script in one call. progress tells C++ which instance raised an error,
+        // the call is resumed from there once that instance is stopped.
+        constexpr const char* DispatchSource = R"(
+            local batches, progress = ...
+            return function(dt, first, start)
+                for b = first, #batches do
+                    local batch = batches[b]
+                    local update, instances = batch.update, batch.instances
+                    if update then
+                        progress[1] = b
+                        for i = start, batch.count do
+                            progress[2] = i
+                            update(instances[i], dt)
+                        end
+                    end
+                    start = 1
+                end
+            end
+        )";
+
+        int Traceback(lua_State* state)
+        {
+            const char* message = lua_tostring(state, 1);
+            luaL_traceback(state, state, message ? message : "(error is not a string)", 1);
+            return 1;
+        }
+
+        const char* ErrorText(lua_State* state, int index)
+        {
+            const char* text = lua_tostring(state, index);
+            return text ? text : "(error is not a string)";
+        }
+
+        int WriteBytecode(lua_State*, const void* data, size_t size, void* userData)
+        {
+            std::vector<uint8_t>& out = *static_cast<std::vector<uint8_t>*>(userData);
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            out.insert(out.end(), bytes, bytes + size);
+            return 0;
+        }
+
+        float CheckFloat(lua_State* state, int arg)
+        {
+            return static_cast<float>(luaL_checknumber(state, arg));
+        }
+
+        int PushVec3(lua_State* state, const glm::vec3& value)
+        {
+            lua_pushnumber(state, value.x);
+            lua_pushnumber(state, value.y);
+            lua_pushnumber(state, value.z);
+            return 3;
+        }
+
+        glm::vec3 CheckVec3(lua_State* state, int arg)
+        {
+            return glm::vec3(CheckFloat(state, arg), CheckFloat(state, arg + 1), CheckFloat(state, arg + 2));
+        }
+
+        int GetPosition(lua_State* state)
+        {
+            return PushVec3(state, ScriptSystem::GetNode(state, 1).GetTransform().GetPosition());
+        }
+
+        int SetPosition(lua_State* state)
+        {
+            ScriptSystem::GetNode(state, 1).GetTransform().SetPosition(CheckVec3(state, 2));
+            return 0;
+        }
+
+        int Translate(lua_State* state)
+        {
+            ScriptSystem::GetNode(state, 1).GetTransform().Translate(CheckVec3(state, 2));
+            return 0;
+        }
+
+        int GetWorldPosition(lua_State* state)
+        {
+            return PushVec3(state, ScriptSystem::GetNode(state, 1).GetTransform().GetWorldPosition());
+        }
+
+        // w, x, y, z
+        int GetRotation(lua_State* state)
+        {
+            const glm::quat& rotation = ScriptSystem::GetNode(state, 1).GetTransform().GetRotation();
+            lua_pushnumber(state, rotation.w);
+            lua_pushnumber(state, rotation.x);
+            lua_pushnumber(state, rotation.y);
+            lua_pushnumber(state, rotation.z);
+            return 4;
+        }
+
+        int SetRotation(lua_State* state)
+        {
+            Node& node = ScriptSystem::GetNode(state, 1);
+            node.GetTransform().SetRotation(glm::quat(CheckFloat(state, 2), CheckFloat(state, 3), CheckFloat(state, 4), CheckFloat(state, 5)));
+            return 0;
+        }
+
+        // Radians around an axis
+        int Rotate(lua_State* state)
+        {
+            Node& node = ScriptSystem::GetNode(state, 1);
+            const float angle = CheckFloat(state, 2);
+            const glm::vec3 axis = CheckVec3(state, 3);
+            const float length = glm::length(axis);
+            if (length > 0.0f)
+                node.GetTransform().Rotate(glm::angleAxis(angle, axis / length));
+            return 0;
+        }
+
+        int GetScale(lua_State* state)
+        {
+            return PushVec3(state, ScriptSystem::GetNode(state, 1).GetTransform().GetScale());
+        }
+
+        int SetScale(lua_State* state)
+        {
+            ScriptSystem::GetNode(state, 1).GetTransform().SetScale(CheckVec3(state, 2));
+            return 0;
+        }
+
+        int Sleep(lua_State* state)
+        {
+            ScriptSystem::GetNode(state, 1).Sleep();
+            return 0;
+        }
+
+        int Wake(lua_State* state)
+        {
+            ScriptSystem::GetNode(state, 1).Wake();
+            return 0;
+        }
+
+        int IsAsleep(lua_State* state)
+        {
+            lua_pushboolean(state, ScriptSystem::GetNode(state, 1).IsAsleep());
+            return 1;
+        }
+
+        int Log(lua_State* state)
+        {
+            std::cout << "[Script] " << luaL_checkstring(state, 1) << std::endl;
+            return 0;
+        }
+    }
+
+    ScriptSystem::ScriptSystem(const ScriptSettings& settings)
+        : m_settings(settings)
+    {
+        m_state = luaL_newstate();
+        if (!m_state)
+        {
+            std::cerr << "[ScriptSystem] Failed to create Lua state" << std::endl;
+            return;
+        }
+
+        luaL_openlibs(m_state);
+#if LUA_VERSION_NUM >= 504
+        // Script instances mostly live as long as their nodes, young garbage is what churns
+        lua_gc(m_state, LUA_GCGEN, 0, 0);
+#endif
+
+        lua_newtable(m_state);
+        lua_pushvalue(m_state, -1);
+        m_batches = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+        lua_createtable(m_state, 2, 0);
+        lua_pushvalue(m_state, -1);
+        m_progress = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+        if (luaL_loadbufferx(m_state, DispatchSource, std::strlen(DispatchSource), "=ScriptSystem", "t") != LUA_OK)
+        {
+            std::cerr << "[ScriptSystem] Failed to compile dispatcher: " << ErrorText(m_state, -1) << std::endl;
+            lua_close(m_state);
+            m_state = nullptr;
+            return;
+        }
+
+        // Chunk below its two arguments
+        lua_insert(m_state, -3);
+        lua_call(m_state, 2, 1);
+        m_dispatch = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+        RegisterBindings();
+    }
+
+    ScriptSystem::~ScriptSystem()
+    {
+        if (m_state)
+            lua_close(m_state);
+    }
+
+    ScriptSystem& ScriptSystem::GetSystem(lua_State* state)
+    {
+        return *static_cast<ScriptSystem*>(lua_touserdata(state, lua_upvalueindex(1)));
+    }
+
+    Node& ScriptSystem::GetNode(lua_State* state, int arg)
+    {
+        ScriptSystem& system = GetSystem(state);
+        const uint64_t handle = static_cast<uint64_t>(luaL_checkinteger(state, arg));
+        const uint32_t index = static_cast<uint32_t>(handle);
+        const uint32_t generation = static_cast<uint32_t>(handle >> 32);
+
+        Node* node = nullptr;
+        if (index < system.m_instances.size() && system.m_instances[index].generation == generation && system.m_instances[index].component)
+            node = system.m_instances[index].component->owner;
+
+        if (!node)
+            luaL_argerror(state, arg, "not a live script node");
+        return *node;
+    }
+
+    void ScriptSystem::RegisterBindings()
+    {
+        lua_newtable(m_state);
+        lua_setglobal(m_state, "bse");
+
+        RegisterFunction("get_position", GetPosition);
+        RegisterFunction("set_position", SetPosition);
+        RegisterFunction("translate", Translate);
+        RegisterFunction("get_world_position", GetWorldPosition);
+        RegisterFunction("get_rotation", GetRotation);
+        RegisterFunction("set_rotation", SetRotation);
+        RegisterFunction("rotate", Rotate);
+        RegisterFunction("get_scale", GetScale);
+        RegisterFunction("set_scale", SetScale);
+        RegisterFunction("sleep", Sleep);
+        RegisterFunction("wake", Wake);
+        RegisterFunction("is_asleep", IsAsleep);
+        RegisterFunction("log", Log);
+    }
+
+    void ScriptSystem::RegisterFunction(const char* name, Function function)
+    {
+        if (!m_state || !name || !function)
+            return;
+
+        lua_getglobal(m_state, "bse");
+        lua_pushlightuserdata(m_state, this);
+        lua_pushcclosure(m_state, function, 1);
+        lua_setfield(m_state, -2, name);
+        lua_pop(m_state, 1);
+    }
+
+    std::string ScriptSystem::GetCachePath(const std::string& path) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.luac", static_cast<unsigned long long>(HashFNV1a64(path)));
+        return (std::filesystem::path(m_settings.cacheDirectory) / name).string();
+    }
+
+    bool ScriptSystem::LoadChunk(const std::string& path)
+    {
+        const std::string chunkName = "@" + path;
+        const std::string cachePath = GetCachePath(path);
+
+        std::error_code error;
+        MappedFile source;
+        if (std::filesystem::exists(path, error))
+            source.Open(path);
+
+        uint64_t sourceHash = 0;
+        if (source.IsOpen())
+            sourceHash = HashFNV1a64(std::string_view(reinterpret_cast<const char*>(source.GetData()), source.GetSize()));
+
+        MappedFile cache;
+        if (std::filesystem::exists(cachePath, error))
+            cache.Open(cachePath);
+
+        if (cache.IsOpen() && cache.GetSize() >= sizeof(CacheHeader))
+        {
+            CacheHeader header{};
+            std::memcpy(&header, cache.GetData(), sizeof(CacheHeader));
+
+            const bool valid = header.magic == CacheMagic && header.luaVersion == LUA_VERSION_NUM
+                && header.bytecodeSize == cache.GetSize() - sizeof(CacheHeader)
+                && (!source.IsOpen() || (header.sourceHash == sourceHash && header.sourceSize == source.GetSize()));
+
+            if (valid)
+            {
+                const char* bytecode = reinterpret_cast<const char*>(cache.GetData() + sizeof(CacheHeader));
+                if (luaL_loadbufferx(m_state, bytecode, static_cast<size_t>(header.bytecodeSize), chunkName.c_str(), "b") == LUA_OK)
+                    return true;
+
+                std::cerr << "[ScriptSystem] Cached bytecode rejected, recompiling: " << ErrorText(m_state, -1) << std::endl;
+                lua_pop(m_state, 1);
+            }
+        }
+
+        if (!source.IsOpen())
+        {
+            std::cerr << "[ScriptSystem] Script not found: " << path << std::endl;
+            return false;
+        }
+
+        const char* text = reinterpret_cast<const char*>(source.GetData());
+        if (luaL_loadbufferx(m_state, text, source.GetSize(), chunkName.c_str(), "t") != LUA_OK)
+        {
+            std::cerr << "[ScriptSystem] Failed to compile script: " << ErrorText(m_state, -1) << std::endl;
+            lua_pop(m_state, 1);
+            return false;
+        }
+
+        WriteCache(cachePath, sourceHash, source.GetSize());
+        return true;
+    }
+
+    void ScriptSystem::WriteCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize)
+    {
+        m_bytecode.clear();
+        if (lua_dump(m_state, WriteBytecode, &m_bytecode, m_settings.stripDebugInfo ? 1 : 0) != 0)
+        {
+            std::cerr << "[ScriptSystem] Failed to dump bytecode: " << cachePath << std::endl;
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+        if (error)
+        {
+            std::cerr << "[ScriptSystem] Failed to create cache directory: " << m_settings.cacheDirectory << std::endl;
+            return;
+        }
+
+        CacheHeader header{};
+        header.magic = CacheMagic;
+        header.luaVersion = LUA_VERSION_NUM;
+        header.sourceHash = sourceHash;
+        header.sourceSize = sourceSize;
+        header.bytecodeSize = m_bytecode.size();
+
+        std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+        out.write(reinterpret_cast<const char*>(m_bytecode.data()), static_cast<std::streamsize>(m_bytecode.size()));
+        if (!out)
+            std::cerr << "[ScriptSystem] Failed to write bytecode cache: " << cachePath << std::endl;
+    }
+
+    uint32_t ScriptSystem::LoadScript(const std::string& path)
+    {
+        if (!m_state)
+            return InvalidScript;
+
+        auto found = m_scriptsByPath.find(path);
+        if (found != m_scriptsByPath.end())
+            return found->second;
+
+        const int top = lua_gettop(m_state);
+        lua_pushcfunction(m_state, Traceback);
+        if (!LoadChunk(path))
+        {
+            lua_settop(m_state, top);
+            return InvalidScript;
+        }
+
+        if (lua_pcall(m_state, 0, 1, top + 1) != LUA_OK)
+        {
+            std::cerr << "[ScriptSystem] Failed to run script: " << ErrorText(m_state, -1) << std::endl;
+            lua_settop(m_state, top);
+            return InvalidScript;
+        }
+
+        if (!lua_istable(m_state, -1))
+        {
+            std::cerr << "[ScriptSystem] Script did not return a table: " << path << std::endl;
+            lua_settop(m_state, top);
+            return InvalidScript;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(m_scripts.size());
+        Script& script = m_scripts.emplace_back();
+        script.path = path;
+
+        lua_pushvalue(m_state, -1);
+        script.table = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+        lua_createtable(m_state, 0, 1);
+        lua_pushvalue(m_state, -2);
+        lua_setfield(m_state, -2, "__index");
+        script.metatable = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+        // update is looked up once here, the dispatcher calls it straight from the batch
+        lua_createtable(m_state, 0, 3);
+        lua_getfield(m_state, -2, "update");
+        lua_setfield(m_state, -2, "update");
+        lua_newtable(m_state);
+        lua_setfield(m_state, -2, "instances");
+        lua_pushinteger(m_state, 0);
+        lua_setfield(m_state, -2, "count");
+
+        lua_pushvalue(m_state, -1);
+        script.batch = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+        lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_batches);
+        lua_insert(m_state, -2);
+        lua_rawseti(m_state, -2, static_cast<lua_Integer>(index) + 1);
+
+        lua_settop(m_state, top);
+        m_scriptsByPath.emplace(path, index);
+        m_stats.scripts = m_scripts.size();
+        return index;
+    }
+
+    uint32_t ScriptSystem::AddInstance(uint32_t script, Component& component)
+    {
+        if (!m_state || script >= m_scripts.size())
+            return InvalidHandle;
+
+        uint32_t handle;
+        if (!m_freeInstances.empty())
+        {
+            handle = m_freeInstances.back();
+            m_freeInstances.pop_back();
+        }
+        else
+        {
+            handle = static_cast<uint32_t>(m_instances.size());
+            m_instances.emplace_back();
+        }
+
+        Script& owner = m_scripts[script];
+        Instance& instance = m_instances[handle];
+        instance.component = &component;
+        instance.script = script;
+        instance.position = static_cast<uint32_t>(owner.order.size());
+        instance.running = true;
+
+        const int top = lua_gettop(m_state);
+        lua_createtable(m_state, 0, 1);
+        lua_pushinteger(m_state, PackNodeHandle(handle, instance.generation));
+        lua_setfield(m_state, -2, "node");
+        lua_rawgeti(m_state, LUA_REGISTRYINDEX, owner.metatable);
+        lua_setmetatable(m_state, -2);
+
+        lua_pushvalue(m_state, -1);
+        instance.table = luaL_ref(m_state, LUA_REGISTRYINDEX);
+
+        owner.order.push_back(handle);
+        lua_rawgeti(m_state, LUA_REGISTRYINDEX, owner.batch);
+        lua_getfield(m_state, -1, "instances");
+        lua_pushvalue(m_state, -3);
+        lua_rawseti(m_state, -2, static_cast<lua_Integer>(owner.order.size()));
+        lua_pushinteger(m_state, static_cast<lua_Integer>(owner.order.size()));
+        lua_setfield(m_state, -3, "count");
+        lua_settop(m_state, top);
+
+        m_stats.instances = m_instances.size() - m_freeInstances.size();
+        CallMethod(handle, "init");
+        return handle;
+    }
+
+    void ScriptSystem::RemoveInstance(uint32_t handle)
+    {
+        if (!m_state || handle >= m_instances.size() || !m_instances[handle].component)
+            return;
+
+        if (m_instances[handle].running)
+        {
+            CallMethod(handle, "destroy");
+            Stop(handle);
+        }
+
+        luaL_unref(m_state, LUA_REGISTRYINDEX, m_instances[handle].table);
+        const uint32_t generation = m_instances[handle].generation + 1;
+        m_instances[handle] = Instance();
+        m_instances[handle].generation = generation;
+        m_freeInstances.push_back(handle);
+        m_stats.instances = m_instances.size() - m_freeInstances.size();
+    }
+
+    bool ScriptSystem::IsRunning(uint32_t handle) const
+    {
+        return handle < m_instances.size() && m_instances[handle].running;
+    }
+
+    void ScriptSystem::Stop(uint32_t handle)
+    {
+        Instance& instance = m_instances[handle];
+        if (!instance.running)
+            return;
+        instance.running = false;
+
+        // Swap with the last instance of the batch so the array stays dense
+        Script& script = m_scripts[instance.script];
+        const uint32_t position = instance.position;
+        const uint32_t last = static_cast<uint32_t>(script.order.size() - 1);
+
+        const int top = lua_gettop(m_state);
+        lua_rawgeti(m_state, LUA_REGISTRYINDEX, script.batch);
+        lua_getfield(m_state, -1, "instances");
+        if (position != last)
+        {
+            lua_rawgeti(m_state, -1, static_cast<lua_Integer>(last) + 1);
+            lua_rawseti(m_state, -2, static_cast<lua_Integer>(position) + 1);
+
+            const uint32_t moved = script.order[last];
+            script.order[position] = moved;
+            m_instances[moved].position = position;
+        }
+
+        lua_pushnil(m_state);
+        lua_rawseti(m_state, -2, static_cast<lua_Integer>(last) + 1);
+        script.order.pop_back();
+
+        lua_pushinteger(m_state, static_cast<lua_Integer>(script.order.size()));
+        lua_setfield(m_state, -3, "count");
+        lua_settop(m_state, top);
+    }
+
+    void ScriptSystem::CallMethod(uint32_t handle, const char* name)
+    {
+        const int top = lua_gettop(m_state);
+        lua_pushcfunction(m_state, Traceback);
+        lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_instances[handle].table);
+        lua_getfield(m_state, -1, name);
+        if (!lua_isfunction(m_state, -1))
+        {
+            lua_settop(m_state, top);
+            return;
+        }
+
+        // Method below self
+        lua_insert(m_state, -2);
+        if (lua_pcall(m_state, 1, 0, top + 1) == LUA_OK)
+        {
+            lua_settop(m_state, top);
+            return;
+        }
+
+        const Node* node = m_instances[handle].component->owner;
+        std::cerr << "[ScriptSystem] Error in " << name << " of node '" << (node ? node->GetName() : std::string()) << "', the instance is stopped: "
+                  << ErrorText(m_state, -1) << std::endl;
+        lua_settop(m_state, top);
+        ++m_stats.errors;
+        Stop(handle);
+    }
+
+    void ScriptSystem::Update(double Tick)
+    {
+        if (!m_state)
+            return;
+
+        const auto start = std::chrono::steady_clock::now();
+        m_stats.errors = 0;
+
+        const int top = lua_gettop(m_state);
+        lua_Integer firstBatch = 1;
+        lua_Integer firstInstance = 1;
+        while (true)
+        {
+            // Cleared so an error outside any update isn't blamed on an instance
+            lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_progress);
+            lua_pushinteger(m_state, 0);
+            lua_rawseti(m_state, -2, 1);
+            lua_pop(m_state, 1);
+
+            lua_pushcfunction(m_state, Traceback);
+            lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_dispatch);
+            lua_pushnumber(m_state, Tick);
+            lua_pushinteger(m_state, firstBatch);
+            lua_pushinteger(m_state, firstInstance);
+            if (lua_pcall(m_state, 3, 0, top + 1) == LUA_OK)
+                break;
+
+            lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_progress);
+            lua_rawgeti(m_state, -1, 1);
+            lua_rawgeti(m_state, -2, 2);
+            const lua_Integer batch = lua_tointeger(m_state, -2);
+            const lua_Integer index = lua_tointeger(m_state, -1);
+
+            const bool located = batch >= 1 && static_cast<size_t>(batch) <= m_scripts.size()
+                && index >= 1 && static_cast<size_t>(index) <= m_scripts[batch - 1].order.size();
+            if (!located)
+            {
+                std::cerr << "[ScriptSystem] Error while dispatching updates: " << ErrorText(m_state, top + 2) << std::endl;
+                ++m_stats.errors;
+                break;
+            }
+
+            const uint32_t handle = m_scripts[batch - 1].order[index - 1];
+            const Node* node = m_instances[handle].component->owner;
+            std::cerr << "[ScriptSystem] Error in update of node '" << (node ? node->GetName() : std::string()) << "', the instance is stopped: "
+                      << ErrorText(m_state, top + 2) << std::endl;
+            lua_settop(m_state, top);
+            ++m_stats.errors;
+            Stop(handle);
+
+            // The instance swapped into the stopped one's place hasn't run yet
+            firstBatch = batch;
+            firstInstance = index;
+        }
+        lua_settop(m_state, top);
+
+        m_stats.updated = 0;
+        for (const Script& script : m_scripts)
+            m_stats.updated += script.order.size();
+        m_stats.updateMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+}
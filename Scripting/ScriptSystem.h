@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <unordered_map>
+
+#include "../NodeGraph/Node.h"
+
+struct lua_State;
+
+namespace BSE
+{
+    struct DLL_EXPORT ScriptSettings
+    {
+        // Compiled scripts are kept here, a script whose source is missing still loads from its cached bytecode
+        std::string cacheDirectory = "ScriptCache";
+
+        // Smaller bytecode, but errors lose their line numbers
+        bool stripDebugInfo = false;
+    };
+
+    struct ScriptStats
+    {
+        size_t scripts = 0;
+        size_t instances = 0;
+        // Of the last Update
+        size_t updated = 0;
+        size_t errors = 0;
+        double updateMicros = 0.0;
+    };
+
+    // One Lua state running every script instance. A script is a file returning a table whose init(self),
+    // update(self, dt) and destroy(self) functions, all optional, act as methods of each instance, and self.node
+    // is the handle the bse bindings take. Scripts are compiled once and kept as bytecode in the cache
+    // directory, later runs only load the bytecode while the source is unchanged.
+    //
+    // Update enters Lua once and runs every instance's update from a loop inside Lua, grouped by script. An
+    // instance raising an error is logged and stopped, the others carry on. Bindings pass vectors as separate
+    // numbers and nodes as integer handles so calling them allocates nothing on either side.
+    //
+    // Add it to the scene with Scene::AddSystem so updates run before node updates. Main thread only, it has to
+    // outlive its ScriptComponents.
+    class DLL_EXPORT ScriptSystem
+    {
+    public:
+        static constexpr uint32_t InvalidScript = 0xFFFFFFFFu;
+        static constexpr uint32_t InvalidHandle = 0xFFFFFFFFu;
+
+        // C functions callable from scripts, upvalue 1 is the ScriptSystem
+        using Function = int (*)(lua_State*);
+
+        explicit ScriptSystem(const ScriptSettings& settings = ScriptSettings());
+        ~ScriptSystem();
+
+        ScriptSystem(const ScriptSystem&) = delete;
+        ScriptSystem& operator=(const ScriptSystem&) = delete;
+
+        // Scripts stay loaded for the system's lifetime, loading a path again returns the same script
+        uint32_t LoadScript(const std::string& path);
+
+        // Makes an instance of script for component and runs its init, the handle stays valid until removed
+        uint32_t AddInstance(uint32_t script, Component& component);
+        // Runs destroy unless the instance was stopped by an error
+        void RemoveInstance(uint32_t handle);
+        // False once the instance raised an error
+        bool IsRunning(uint32_t handle) const;
+
+        void Update(double Tick);
+
+        // Adds a function to the bse table for game specific bindings, the node behind a handle argument is
+        // found with GetNode. Lua errors unwind with longjmp, so nothing with a destructor may be alive in the
+        // function when it raises one.
+        void RegisterFunction(const char* name, Function function);
+
+        // Raises a Lua error for handles that don't name a live instance, including ones of removed instances
+        // whose slot was reused
+        static Node& GetNode(lua_State* state, int arg);
+
+        lua_State* GetState() const { return m_state; }
+        const ScriptStats& GetStats() const { return m_stats; }
+
+    private:
+        struct Script
+        {
+            std::string path;
+            // Registry references, the metatable makes the script's table the class of its instances
+            int table = 0;
+            int metatable = 0;
+            int batch = 0;
+            // Instance handles in the order of the batch's Lua array
+            std::vector<uint32_t> order;
+        };
+
+        struct Instance
+        {
+            Component* component = nullptr;
+            uint32_t script = InvalidScript;
+            // Index into the script's order, the Lua array index is one more
+            uint32_t position = 0;
+            int table = 0;
+            // Bumped when the slot is freed, part of the node handle scripts see
+            uint32_t generation = 0;
+            bool running = false;
+        };
+
+        bool LoadChunk(const std::string& path);
+        void WriteCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize);
+        std::string GetCachePath(const std::string& path) const;
+
+        // Leaves the batch's array, the instance keeps its handle
+        void Stop(uint32_t handle);
+        // Runs a method of an instance on its own, for init and destroy
+        void CallMethod(uint32_t handle, const char* name);
+
+        static ScriptSystem& GetSystem(lua_State* state);
+        void RegisterBindings();
+
+        ScriptSettings m_settings;
+        ScriptStats m_stats;
+        lua_State* m_state = nullptr;
+
+        // Registry references
+        int m_batches = 0;
+        int m_progress = 0;
+        int m_dispatch = 0;
+
+        std::vector<Script> m_scripts;
+        std::unordered_map<std::string, uint32_t> m_scriptsByPath;
+
+        std::vector<Instance> m_instances;
+        std::vector<uint32_t> m_freeInstances;
+
+        // Reused for compiling
+        std::vector<uint8_t> m_bytecode;
+    };
+}
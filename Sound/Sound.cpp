@@ -1,4 +1,5 @@
 #include "Sound.h"
+#include "../Engine/DestructionQueue.h"
 
 namespace BSE
 {
@@ -9,11 +10,10 @@ namespace BSE
 
     SoundBuffer::~SoundBuffer()
     {
-        if (m_buffer)
-            alDeleteBuffers(1, &m_buffer);
+        DestructionQueue::Release(GPUResource::ALBuffer, m_buffer);
     }
 
-    bool SoundBuffer::LoadFromFile(const std::string& filepath)
+    bool SoundBuffer::LoadSoundToMemory(const std::string& filepath, SoundData& out)
     {
         std::ifstream file(filepath, std::ios::binary);
         if (!file)
@@ -89,8 +89,19 @@ namespace BSE
             return false;
         }
 
-        alBufferData(m_buffer, format, data.data(), static_cast<ALsizei>(data.size()), sampleRate);
+        out.samples = std::move(data);
+        out.frequency = sampleRate;
+        out.format = format;
+        return true;
+    }
+
+    bool SoundBuffer::LoadFromFile(const std::string& filepath)
+    {
+        SoundData data;
+        if (!LoadSoundToMemory(filepath, data))
+            return false;
 
+        SetData(data);
         return true;
     }
 
@@ -99,6 +110,11 @@ namespace BSE
         alBufferData(m_buffer, format, data, size, freq);
     }
 
+    void SoundBuffer::SetData(const SoundData& data)
+    {
+        alBufferData(m_buffer, data.format, data.samples.data(), static_cast<ALsizei>(data.samples.size()), data.frequency);
+    }
+
     SoundSource::SoundSource()
     {
         alGenSources(1, &m_source);
@@ -106,8 +122,14 @@ namespace BSE
 
     SoundSource::~SoundSource()
     {
-        if (m_source)
-            alDeleteSources(1, &m_source);
+        // Silenced and detached right away, only deleting the handle waits for the queue. A queued source would
+        // keep playing until the flush and hold on to its buffer, which AL refuses to delete while attached.
+        if (m_source != 0)
+        {
+            alSourceStop(m_source);
+            alSourcei(m_source, AL_BUFFER, 0);
+        }
+        DestructionQueue::Release(GPUResource::ALSource, m_source);
     }
 
     void SoundSource::AttachBuffer(const SoundBuffer& buffer)
@@ -8,14 +8,25 @@
 
 namespace BSE
 {
+    // PCM samples read from a file, decoding touches no AL state so it may run on any thread
+    struct DLL_EXPORT SoundData
+    {
+        std::vector<char> samples;
+        ALsizei frequency = 0;
+        ALenum format = 0;
+    };
+
     class DLL_EXPORT SoundBuffer
     {
     public:
         SoundBuffer();
         ~SoundBuffer();
 
+        static bool LoadSoundToMemory(const std::string& filepath, SoundData& out);
+
         bool LoadFromFile(const std::string& filepath);
         void SetData(const void* data, ALsizei size, ALsizei freq, ALenum format);
+        void SetData(const SoundData& data);
 
         ALuint GetID() const { return m_buffer; }
 
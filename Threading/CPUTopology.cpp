@@ -0,0 +1,309 @@
+#include "CPUTopology.h"
+
+#include <map>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace BSE
+{
+    namespace
+    {
+        bool ReadLine(const std::string& path, std::string& out)
+        {
+            std::ifstream file(path);
+            if (!file.is_open())
+                return false;
+
+            std::getline(file, out);
+            return true;
+        }
+
+        int ReadInt(const std::string& path, int fallback)
+        {
+            std::string text;
+            if (!ReadLine(path, text))
+                return fallback;
+
+            try
+            {
+                return std::stoi(text);
+            }
+            catch (const std::exception&)
+            {
+                return fallback;
+            }
+        }
+
+        // Kernel CPU lists look like "0-3,8,10-11"
+        std::vector<int> ParseCPUList(const std::string& text)
+        {
+            std::vector<int> cpus;
+            std::stringstream ss(text);
+            std::string range;
+            while (std::getline(ss, range, ','))
+            {
+                if (range.empty())
+                    continue;
+
+                try
+                {
+                    const size_t dash = range.find('-');
+                    const int first = std::stoi(range.substr(0, dash));
+                    const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                    for (int cpu = first; cpu <= last; ++cpu)
+                        cpus.push_back(cpu);
+                }
+                catch (const std::exception&)
+                {
+                }
+            }
+            return cpus;
+        }
+
+        // Maps arbitrary keys to 0, 1, 2... in order of first appearance
+        template<typename Key>
+        int DenseIndex(std::map<Key, int>& indices, const Key& key)
+        {
+            auto it = indices.find(key);
+            if (it != indices.end())
+                return it->second;
+
+            const int index = static_cast<int>(indices.size());
+            indices.emplace(key, index);
+            return index;
+        }
+    }
+
+    CPUTopology CPUTopology::Detect()
+    {
+        CPUTopology topology;
+
+#if defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        const bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+        std::string online;
+        if (ReadLine("/sys/devices/system/cpu/online", online))
+        {
+            std::map<int, int> nodeOfCPU;
+            for (int node = 0; node < 1024; ++node)
+            {
+                std::string list;
+                if (!ReadLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", list))
+                    continue;
+
+                for (int cpu : ParseCPUList(list))
+                    nodeOfCPU[cpu] = node;
+            }
+
+            std::map<std::pair<int, int>, int> cores;
+            std::map<int, int> packages;
+            std::map<std::pair<int, int>, int> l3Domains;
+            std::map<int, int> nodes;
+
+            for (int cpu : ParseCPUList(online))
+            {
+                if (haveMask && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)))
+                    continue;
+
+                const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+                const int package = ReadInt(base + "/topology/physical_package_id", 0);
+                const int coreId = ReadInt(base + "/topology/core_id", cpu);
+
+                // Identify the L3 by the lowest CPU sharing it, without an L3 every package is one domain
+                int l3Key = -1;
+                for (int index = 0; index < 8; ++index)
+                {
+                    const std::string cache = base + "/cache/index" + std::to_string(index);
+                    if (ReadInt(cache + "/level", 0) != 3)
+                        continue;
+
+                    std::string shared;
+                    if (ReadLine(cache + "/shared_cpu_list", shared))
+                    {
+                        const std::vector<int> sharing = ParseCPUList(shared);
+                        if (!sharing.empty())
+                            l3Key = *std::min_element(sharing.begin(), sharing.end());
+                    }
+                    break;
+                }
+
+                const auto node = nodeOfCPU.find(cpu);
+
+                LogicalCPU logical;
+                logical.id = cpu;
+                logical.package = DenseIndex(packages, package);
+
+                const size_t coreCount = cores.size();
+                logical.core = DenseIndex(cores, std::make_pair(package, coreId));
+                logical.primary = cores.size() != coreCount;
+
+                logical.l3Domain = DenseIndex(l3Domains, std::make_pair(package, l3Key));
+                logical.numaNode = DenseIndex(nodes, node == nodeOfCPU.end() ? 0 : node->second);
+
+                topology.m_cpus.push_back(logical);
+            }
+        }
+#endif
+
+        if (topology.m_cpus.empty())
+        {
+            const unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned int i = 0; i < threads; ++i)
+            {
+                LogicalCPU logical;
+                logical.id = static_cast<int>(i);
+                logical.core = static_cast<int>(i);
+                topology.m_cpus.push_back(logical);
+            }
+        }
+
+        for (const LogicalCPU& cpu : topology.m_cpus)
+        {
+            topology.m_coreCount = std::max<size_t>(topology.m_coreCount, cpu.core + 1);
+            topology.m_packageCount = std::max<size_t>(topology.m_packageCount, cpu.package + 1);
+            topology.m_l3DomainCount = std::max<size_t>(topology.m_l3DomainCount, cpu.l3Domain + 1);
+            topology.m_numaNodeCount = std::max<size_t>(topology.m_numaNodeCount, cpu.numaNode + 1);
+        }
+
+        return topology;
+    }
+
+    const CPUTopology& CPUTopology::Get()
+    {
+        static const CPUTopology topology = Detect();
+        return topology;
+    }
+
+    const LogicalCPU* CPUTopology::FindCPU(int id) const
+    {
+        for (const LogicalCPU& cpu : m_cpus)
+        {
+            if (cpu.id == id)
+                return &cpu;
+        }
+        return nullptr;
+    }
+
+    std::vector<int> CPUTopology::GetSiblings(int id) const
+    {
+        std::vector<int> siblings;
+        const LogicalCPU* self = FindCPU(id);
+        if (!self)
+            return siblings;
+
+        for (const LogicalCPU& cpu : m_cpus)
+        {
+            if (cpu.core == self->core)
+                siblings.push_back(cpu.id);
+        }
+        return siblings;
+    }
+
+    std::vector<int> CPUTopology::SelectDedicatedCPUs(size_t count, int numaNode) const
+    {
+        std::vector<int> selected;
+        for (auto it = m_cpus.rbegin(); it != m_cpus.rend() && selected.size() < count; ++it)
+        {
+            if (!it->primary || (numaNode >= 0 && it->numaNode != numaNode))
+                continue;
+
+            selected.push_back(it->id);
+        }
+
+        std::reverse(selected.begin(), selected.end());
+        return selected;
+    }
+
+    std::vector<int> CPUTopology::SelectWorkerCPUs(const std::vector<int>& reserved, int numaNode, bool useSiblings) const
+    {
+        std::vector<bool> reservedCores(m_coreCount, false);
+        for (int id : reserved)
+        {
+            if (const LogicalCPU* cpu = FindCPU(id))
+                reservedCores[cpu->core] = true;
+        }
+
+        // One bucket per L3 domain and pass (primary threads first), taking from the buckets in turn spreads
+        // consecutive workers over the caches
+        std::vector<std::vector<int>> primaries(m_l3DomainCount);
+        std::vector<std::vector<int>> siblings(m_l3DomainCount);
+        for (const LogicalCPU& cpu : m_cpus)
+        {
+            if (reservedCores[cpu.core] || (numaNode >= 0 && cpu.numaNode != numaNode))
+                continue;
+
+            if (cpu.primary)
+                primaries[cpu.l3Domain].push_back(cpu.id);
+            else if (useSiblings)
+                siblings[cpu.l3Domain].push_back(cpu.id);
+        }
+
+        std::vector<int> selected;
+        for (std::vector<std::vector<int>>* buckets : { &primaries, &siblings })
+        {
+            bool taken = true;
+            for (size_t round = 0; taken; ++round)
+            {
+                taken = false;
+                for (const std::vector<int>& bucket : *buckets)
+                {
+                    if (round < bucket.size())
+                    {
+                        selected.push_back(bucket[round]);
+                        taken = true;
+                    }
+                }
+            }
+        }
+
+        return selected;
+    }
+
+    std::string CPUTopology::Describe() const
+    {
+        std::ostringstream ss;
+        ss << m_cpus.size() << " logical CPUs, " << m_coreCount << " cores, " << m_packageCount << " packages, "
+           << m_l3DomainCount << " L3 domains, " << m_numaNodeCount << " NUMA nodes";
+        return ss.str();
+    }
+
+    bool PinCurrentThread(const std::vector<int>& cpus)
+    {
+        if (cpus.empty())
+            return false;
+
+#if defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus)
+        {
+            if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+                mask |= DWORD_PTR(1) << cpu;
+        }
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool PinCurrentThread(int cpu)
+    {
+        return PinCurrentThread(std::vector<int>{ cpu });
+    }
+}
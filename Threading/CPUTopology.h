@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+namespace BSE
+{
+    struct DLL_EXPORT LogicalCPU
+    {
+        // Operating system CPU number, what affinity masks use
+        int id = 0;
+        // Dense indices, logical CPUs sharing a value share that resource
+        int core = 0;
+        int package = 0;
+        int l3Domain = 0;
+        int numaNode = 0;
+        // First SMT sibling of its core
+        bool primary = true;
+    };
+
+    // Layout of the CPUs this process may run on. On Linux it is read from sysfs and the affinity mask,
+    // elsewhere every logical CPU is treated as its own core.
+    class DLL_EXPORT CPUTopology
+    {
+    public:
+        static CPUTopology Detect();
+        // Detected once on first use
+        static const CPUTopology& Get();
+
+        const std::vector<LogicalCPU>& GetLogicalCPUs() const { return m_cpus; }
+
+        size_t GetLogicalCount() const { return m_cpus.size(); }
+        size_t GetCoreCount() const { return m_coreCount; }
+        size_t GetPackageCount() const { return m_packageCount; }
+        size_t GetL3DomainCount() const { return m_l3DomainCount; }
+        size_t GetNUMANodeCount() const { return m_numaNodeCount; }
+
+        const LogicalCPU* FindCPU(int id) const;
+        std::vector<int> GetSiblings(int id) const;
+
+        // Primary threads of count distinct cores for threads that get a core to themselves, like main,
+        // render and network. Taken from the end of the list so worker placement keeps the low cores.
+        std::vector<int> SelectDedicatedCPUs(size_t count, int numaNode = -1) const;
+
+        // CPUs for pool workers, skipping every core that holds one of the reserved CPUs. The primary thread of
+        // each core comes before any SMT sibling, and cores are interleaved across L3 domains.
+        std::vector<int> SelectWorkerCPUs(const std::vector<int>& reserved, int numaNode = -1, bool useSiblings = true) const;
+
+        std::string Describe() const;
+
+    private:
+        std::vector<LogicalCPU> m_cpus;
+        size_t m_coreCount = 0;
+        size_t m_packageCount = 0;
+        size_t m_l3DomainCount = 0;
+        size_t m_numaNodeCount = 0;
+    };
+
+    // Restricts the calling thread to the given CPUs, returns false when the platform refused
+    DLL_EXPORT bool PinCurrentThread(const std::vector<int>& cpus);
+    DLL_EXPORT bool PinCurrentThread(int cpu);
+}
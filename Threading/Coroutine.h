@@ -0,0 +1,299 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include "ThreadingSystem.h"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+namespace BSE
+{
+    template<typename T = void>
+    class Task;
+
+    namespace Detail
+    {
+        class TaskPromiseBase
+        {
+        public:
+            // Coroutine frames come from the same recycled blocks as task captures
+            static void* operator new(size_t size) { return AllocateTaskStorage(size, alignof(std::max_align_t)); }
+            static void operator delete(void* block, size_t size) noexcept { FreeTaskStorage(block, size, alignof(std::max_align_t)); }
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    TaskPromiseBase& promise = handle.promise();
+
+                    if (promise.m_detached)
+                    {
+                        if (promise.m_exception)
+                            std::cerr << "[Task] Unhandled exception in detached task" << std::endl;
+                        handle.destroy();
+                        return std::noop_coroutine();
+                    }
+
+                    // Part of a WhenAll, only the last task to finish resumes the waiter
+                    if (promise.m_joinCounter && promise.m_joinCounter->fetch_sub(1, std::memory_order_acq_rel) != 1)
+                        return std::noop_coroutine();
+
+                    if (promise.m_continuation)
+                        return promise.m_continuation;
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() noexcept { m_exception = std::current_exception(); }
+
+            void RethrowIfFailed() const
+            {
+                if (m_exception)
+                    std::rethrow_exception(m_exception);
+            }
+
+            std::coroutine_handle<> m_continuation;
+            std::atomic<size_t>* m_joinCounter = nullptr;
+            std::exception_ptr m_exception;
+            bool m_detached = false;
+        };
+
+        template<typename T>
+        class TaskPromise : public TaskPromiseBase
+        {
+        public:
+            Task<T> get_return_object() noexcept;
+
+            template<typename U>
+            void return_value(U&& value) { m_value.emplace(std::forward<U>(value)); }
+
+            T TakeResult()
+            {
+                RethrowIfFailed();
+                return std::move(*m_value);
+            }
+
+        private:
+            std::optional<T> m_value;
+        };
+
+        template<>
+        class TaskPromise<void> : public TaskPromiseBase
+        {
+        public:
+            Task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void TakeResult() { RethrowIfFailed(); }
+        };
+    }
+
+    // Lazily started coroutine. Nothing runs until the task is awaited or Start() is called, awaiting it
+    // resumes the waiter on whichever thread the task finished on.
+    template<typename T>
+    class Task
+    {
+    public:
+        using promise_type = Detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() noexcept = default;
+        explicit Task(Handle handle) noexcept : m_handle(handle) {}
+
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() { Reset(); }
+
+        bool IsValid() const noexcept { return static_cast<bool>(m_handle); }
+        bool IsReady() const noexcept { return !m_handle || m_handle.done(); }
+
+        // Runs the coroutine on the calling thread up to its first suspension and hands ownership to the frame,
+        // which frees itself once it finished. The result is discarded.
+        void Start()
+        {
+            if (!m_handle)
+                return;
+
+            Handle handle = std::exchange(m_handle, nullptr);
+            handle.promise().m_detached = true;
+            handle.resume();
+        }
+
+        auto operator co_await() && noexcept
+        {
+            struct Awaiter
+            {
+                Handle handle;
+
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise().m_continuation = awaiting;
+                    return handle;
+                }
+
+                T await_resume()
+                {
+                    if (!handle)
+                        throw std::runtime_error("Task - awaited an empty task");
+                    return handle.promise().TakeResult();
+                }
+            };
+
+            return Awaiter{ m_handle };
+        }
+
+        Handle GetHandle() const noexcept { return m_handle; }
+
+    private:
+        void Reset() noexcept
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+                m_handle = nullptr;
+            }
+        }
+
+        Handle m_handle;
+    };
+
+    namespace Detail
+    {
+        template<typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept
+        {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept
+        {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    }
+
+    // co_await ResumeOnWorker(pool) continues the coroutine as a job on the pool
+    inline auto ResumeOnWorker(ThreadPool& pool, JobPriority priority = JobPriority::Normal) noexcept
+    {
+        struct Awaiter
+        {
+            ThreadPool& pool;
+            JobPriority priority;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { pool.Schedule([handle]() { handle.resume(); }, {}, priority); }
+            void await_resume() const noexcept {}
+        };
+
+        return Awaiter{ pool, priority };
+    }
+
+    // co_await ResumeOnMainThread(system) continues the coroutine inside the next ThreadingSystem::DrainCompleted
+    inline auto ResumeOnMainThread(ThreadingSystem& threadingSystem) noexcept
+    {
+        struct Awaiter
+        {
+            ThreadingSystem& threadingSystem;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { threadingSystem.AddCompletedTask([handle]() { handle.resume(); }); }
+            void await_resume() const noexcept {}
+        };
+
+        return Awaiter{ threadingSystem };
+    }
+
+    inline auto ResumeOnMainThread(ThreadPool& pool) noexcept
+    {
+        return ResumeOnMainThread(pool.GetThreadingSystem());
+    }
+
+    // co_await WaitForJob(pool, handle) continues on a worker once the job and its children completed
+    inline auto WaitForJob(ThreadPool& pool, JobHandle job, JobPriority priority = JobPriority::Normal) noexcept
+    {
+        struct Awaiter
+        {
+            ThreadPool& pool;
+            JobHandle job;
+            JobPriority priority;
+
+            bool await_ready() const noexcept { return pool.IsComplete(job); }
+            void await_suspend(std::coroutine_handle<> handle) { pool.ScheduleAfter({ job }, [handle]() { handle.resume(); }, {}, priority); }
+            void await_resume() const noexcept {}
+        };
+
+        return Awaiter{ pool, job, priority };
+    }
+
+    // Starts every task on the calling thread and resumes the waiter once all of them finished.
+    // Tasks run concurrently as far as they hop onto workers themselves, the first failure is rethrown.
+    inline Task<void> WhenAll(std::vector<Task<void>> tasks)
+    {
+        struct Awaiter
+        {
+            std::vector<Task<void>>& tasks;
+            std::atomic<size_t> remaining{ 0 };
+
+            bool await_ready() const noexcept { return tasks.empty(); }
+
+            bool await_suspend(std::coroutine_handle<> awaiting)
+            {
+                // One extra count keeps tasks that finish inline from resuming us before every task started
+                remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+
+                for (Task<void>& task : tasks)
+                {
+                    if (!task.IsValid())
+                    {
+                        remaining.fetch_sub(1, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    auto& promise = task.GetHandle().promise();
+                    promise.m_continuation = awaiting;
+                    promise.m_joinCounter = &remaining;
+                    task.GetHandle().resume();
+                }
+
+                return remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        co_await Awaiter{ tasks };
+
+        for (Task<void>& task : tasks)
+        {
+            if (task.IsValid())
+                task.GetHandle().promise().RethrowIfFailed();
+        }
+    }
+}
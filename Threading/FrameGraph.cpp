@@ -0,0 +1,214 @@
+#include "FrameGraph.h"
+
+namespace BSE
+{
+    size_t FrameGraph::AddStage(std::string name, FrameStageAccess access, TaskFunction work, bool mainThread)
+    {
+        if (m_stages.size() >= MaxStages)
+            throw std::runtime_error("FrameGraph::AddStage - too many stages");
+
+        const size_t index = m_stages.size();
+
+        Stage stage;
+        stage.name = std::move(name);
+        stage.access = access;
+        stage.work = std::move(work);
+        stage.mainThread = mainThread;
+
+        uint64_t conflicts = 0;
+        for (size_t i = 0; i < index; ++i)
+        {
+            if (m_stages[i].access.ConflictsWith(access))
+            {
+                conflicts |= uint64_t(1) << i;
+                stage.ancestors |= (uint64_t(1) << i) | m_stages[i].ancestors;
+            }
+        }
+
+        // Drop edges already implied through another dependency
+        uint64_t implied = 0;
+        for (size_t i = 0; i < index; ++i)
+        {
+            if (conflicts & (uint64_t(1) << i))
+                implied |= m_stages[i].ancestors;
+        }
+
+        for (size_t i = 0; i < index; ++i)
+        {
+            if ((conflicts & ~implied) & (uint64_t(1) << i))
+            {
+                stage.dependencies.push_back(i);
+                m_stages[i].dependents.push_back(index);
+            }
+        }
+
+        m_stages.push_back(std::move(stage));
+
+        m_report.stageStartMicros.resize(m_stages.size(), 0.0);
+        m_report.stageMicros.resize(m_stages.size(), 0.0);
+        m_pathCost.resize(m_stages.size(), 0.0);
+        m_pathPrevious.resize(m_stages.size(), 0);
+
+        return index;
+    }
+
+    void FrameGraph::Clear()
+    {
+        m_stages.clear();
+        m_report = FrameGraphReport();
+        m_pathCost.clear();
+        m_pathPrevious.clear();
+    }
+
+    void FrameGraph::Execute(ThreadPool& pool)
+    {
+        const size_t count = m_stages.size();
+        if (count == 0)
+            return;
+
+        m_pool = &pool;
+        m_frameStart = std::chrono::steady_clock::now();
+        m_finishedStages.store(0, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < count; ++i)
+            m_pending[i].store(static_cast<uint32_t>(m_stages[i].dependencies.size()), std::memory_order_relaxed);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!m_stages[i].mainThread && m_stages[i].dependencies.empty())
+                pool.Schedule([this, i]() { RunStage(i); FinishStage(i); }, {}, JobPriority::FrameCritical);
+        }
+
+        // Run main thread stages as they become ready until every stage reported back
+        uint64_t mainStagesLeft = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (m_stages[i].mainThread)
+                mainStagesLeft |= uint64_t(1) << i;
+        }
+
+        while (true)
+        {
+            const uint32_t finished = m_finishedStages.load(std::memory_order_acquire);
+
+            size_t ready = count;
+            for (size_t i = 0; i < count && mainStagesLeft != 0; ++i)
+            {
+                if ((mainStagesLeft & (uint64_t(1) << i)) && m_pending[i].load(std::memory_order_acquire) == 0)
+                {
+                    ready = i;
+                    break;
+                }
+            }
+
+            if (ready != count)
+            {
+                mainStagesLeft &= ~(uint64_t(1) << ready);
+                RunStage(ready);
+                FinishStage(ready);
+                continue;
+            }
+
+            if (finished == count)
+                break;
+
+            m_finishedStages.wait(finished, std::memory_order_acquire);
+        }
+
+        // The last finisher may still be inside notify_all, the graph has to stay alive until it left
+        while (m_activeFinishers.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+
+        m_report.frameMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_frameStart).count();
+        m_pool = nullptr;
+
+        BuildReport();
+    }
+
+    void FrameGraph::RunStage(size_t stage)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (m_stages[stage].work)
+            m_stages[stage].work();
+
+        const auto end = std::chrono::steady_clock::now();
+        m_report.stageStartMicros[stage] = std::chrono::duration<double, std::micro>(start - m_frameStart).count();
+        m_report.stageMicros[stage] = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    void FrameGraph::FinishStage(size_t stage)
+    {
+        m_activeFinishers.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t dependent : m_stages[stage].dependents)
+        {
+            if (m_pending[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1 && !m_stages[dependent].mainThread)
+                m_pool->Schedule([this, dependent]() { RunStage(dependent); FinishStage(dependent); }, {}, JobPriority::FrameCritical);
+        }
+
+        m_finishedStages.fetch_add(1, std::memory_order_acq_rel);
+        m_finishedStages.notify_all();
+
+        // Nothing may touch this past here
+        m_activeFinishers.fetch_sub(1, std::memory_order_release);
+    }
+
+    void FrameGraph::BuildReport()
+    {
+        const size_t count = m_stages.size();
+
+        m_report.serialMicros = 0.0;
+        size_t last = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_report.serialMicros += m_report.stageMicros[i];
+
+            // Stages are topologically sorted by construction, so a single forward pass finds the longest chain
+            m_pathCost[i] = 0.0;
+            m_pathPrevious[i] = i;
+            for (size_t dependency : m_stages[i].dependencies)
+            {
+                if (m_pathCost[dependency] > m_pathCost[i])
+                {
+                    m_pathCost[i] = m_pathCost[dependency];
+                    m_pathPrevious[i] = dependency;
+                }
+            }
+            m_pathCost[i] += m_report.stageMicros[i];
+
+            if (m_pathCost[i] > m_pathCost[last])
+                last = i;
+        }
+
+        m_report.criticalPathMicros = m_pathCost[last];
+
+        m_report.criticalPath.clear();
+        size_t current = last;
+        while (true)
+        {
+            m_report.criticalPath.push_back(current);
+            if (m_pathPrevious[current] == current)
+                break;
+            current = m_pathPrevious[current];
+        }
+        std::reverse(m_report.criticalPath.begin(), m_report.criticalPath.end());
+    }
+
+    std::string FrameGraph::DescribeCriticalPath() const
+    {
+        std::ostringstream ss;
+        ss << "Critical path " << m_report.criticalPathMicros << "us of " << m_report.frameMicros
+           << "us frame (serial " << m_report.serialMicros << "us): ";
+
+        for (size_t i = 0; i < m_report.criticalPath.size(); ++i)
+        {
+            const size_t stage = m_report.criticalPath[i];
+            if (i > 0)
+                ss << " -> ";
+            ss << m_stages[stage].name << " " << m_report.stageMicros[stage] << "us";
+        }
+
+        return ss.str();
+    }
+}
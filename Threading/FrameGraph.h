@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include "ThreadingSystem.h"
+
+namespace BSE
+{
+    // Bit index of a piece of shared state a frame stage touches, project specific state starts at User
+    enum class FrameResource : uint32_t
+    {
+        Input = 0,
+        SceneNodes,
+        PhysicsWorld,
+        Transforms,
+        Lights,
+        DrawList,
+        Audio,
+        Network,
+
+        User = 16,
+        Count = 64
+    };
+
+    struct DLL_EXPORT FrameStageAccess
+    {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+
+        FrameStageAccess& Read(FrameResource resource) { reads |= Bit(resource); return *this; }
+        FrameStageAccess& Write(FrameResource resource) { writes |= Bit(resource); return *this; }
+
+        // Write after write, read after write and write after read all have to be ordered
+        bool ConflictsWith(const FrameStageAccess& other) const
+        {
+            return (writes & (other.reads | other.writes)) != 0 || (reads & other.writes) != 0;
+        }
+
+        static constexpr uint64_t Bit(FrameResource resource) { return uint64_t(1) << static_cast<uint32_t>(resource); }
+    };
+
+    struct DLL_EXPORT FrameGraphReport
+    {
+        double frameMicros = 0.0;           // Wall time from Execute() until the last stage finished
+        double serialMicros = 0.0;          // Sum of all stage durations, what a serial loop would have cost
+        double criticalPathMicros = 0.0;    // Longest dependency chain, the lower bound for frameMicros
+
+        std::vector<size_t> criticalPath;   // Stage indices along the longest chain in execution order
+        std::vector<double> stageStartMicros;
+        std::vector<double> stageMicros;
+    };
+
+    // Stages are declared in program order with the state they read and write, two stages only run
+    // concurrently when their accesses do not conflict. Declaration order decides who goes first on a conflict.
+    class DLL_EXPORT FrameGraph
+    {
+    public:
+        static constexpr size_t MaxStages = 64;
+
+        FrameGraph() = default;
+
+        FrameGraph(const FrameGraph&) = delete;
+        FrameGraph& operator=(const FrameGraph&) = delete;
+
+        // Main thread stages run on the thread calling Execute(), use them for SDL, GL and other thread bound APIs
+        size_t AddStage(std::string name, FrameStageAccess access, TaskFunction work, bool mainThread = false);
+        void Clear();
+
+        // Runs every stage once and blocks until all of them finished
+        void Execute(ThreadPool& pool);
+
+        size_t GetStageCount() const { return m_stages.size(); }
+        const std::string& GetStageName(size_t stage) const { return m_stages[stage].name; }
+        const std::vector<size_t>& GetDependencies(size_t stage) const { return m_stages[stage].dependencies; }
+
+        const FrameGraphReport& GetLastReport() const { return m_report; }
+        std::string DescribeCriticalPath() const;
+
+    private:
+        struct Stage
+        {
+            std::string name;
+            FrameStageAccess access;
+            TaskFunction work;
+            bool mainThread = false;
+
+            // Transitively reduced, every index is smaller than the stage's own
+            std::vector<size_t> dependencies;
+            std::vector<size_t> dependents;
+            // Every earlier stage this one has to wait for
+            uint64_t ancestors = 0;
+        };
+
+        void RunStage(size_t stage);
+        void FinishStage(size_t stage);
+        void BuildReport();
+
+        std::vector<Stage> m_stages;
+        ThreadPool* m_pool = nullptr;
+
+        // Dependencies of each stage that have not finished yet this frame
+        std::array<std::atomic<uint32_t>, MaxStages> m_pending{};
+        std::atomic<uint32_t> m_finishedStages{ 0 };
+        // FinishStage calls still touching the graph, Execute only returns once this drops to zero
+        std::atomic<uint32_t> m_activeFinishers{ 0 };
+        std::chrono::steady_clock::time_point m_frameStart;
+
+        FrameGraphReport m_report;
+        std::vector<double> m_pathCost;
+        std::vector<size_t> m_pathPrevious;
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <cstddef>
+#include <new>
+
+namespace BSE
+{
+    // Bounded lock free queue, any number of threads may push but only one thread may pop.
+    // Every cell carries a sequence number that tells producers and the consumer whose turn it is.
+    template<typename T>
+    class MPSCQueue
+    {
+    public:
+        explicit MPSCQueue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+
+            m_mask = size - 1;
+            m_cells = std::make_unique<Cell[]>(size);
+            for (size_t i = 0; i < size; ++i)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        ~MPSCQueue()
+        {
+            T discarded;
+            while (TryPop(discarded)) {}
+        }
+
+        MPSCQueue(const MPSCQueue&) = delete;
+        MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+        // Returns false when the queue is full, value is left untouched in that case
+        bool TryPush(T&& value)
+        {
+            size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+            Cell* cell = nullptr;
+
+            while (true)
+            {
+                cell = &m_cells[position & m_mask];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+                if (difference == 0)
+                {
+                    if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            ::new (static_cast<void*>(cell->storage)) T(std::move(value));
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer thread only
+        bool TryPop(T& out)
+        {
+            Cell& cell = m_cells[m_dequeuePosition & m_mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(m_dequeuePosition + 1) < 0)
+                return false;
+
+            T* value = std::launder(reinterpret_cast<T*>(cell.storage));
+            out = std::move(*value);
+            value->~T();
+
+            cell.sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+            ++m_dequeuePosition;
+            m_dequeuePositionShared.store(m_dequeuePosition, std::memory_order_relaxed);
+            return true;
+        }
+
+        size_t GetCapacity() const { return m_mask + 1; }
+
+        // Only a snapshot, producers may be pushing concurrently
+        size_t GetSizeApprox() const
+        {
+            const size_t enqueued = m_enqueuePosition.load(std::memory_order_relaxed);
+            const size_t dequeued = m_dequeuePositionShared.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence{ 0 };
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        size_t m_mask = 0;
+
+        alignas(64) std::atomic<size_t> m_enqueuePosition{ 0 };
+        alignas(64) size_t m_dequeuePosition = 0;
+        std::atomic<size_t> m_dequeuePositionShared{ 0 };
+    };
+}
@@ -0,0 +1,21 @@
+#include "TaskFunction.h"
+
+#include "../Engine/BlockAllocator.h"
+
+namespace BSE
+{
+    namespace
+    {
+        BlockAllocator& GetTaskBlocks()
+        {
+            static BlockAllocator allocator({ 128, 256, 512, 1024, 2048 });
+            return allocator;
+        }
+    }
+
+    namespace Detail
+    {
+        void* AllocateTaskStorage(size_t size, size_t align) { return GetTaskBlocks().Allocate(size, align); }
+        void FreeTaskStorage(void* block, size_t size, size_t align) noexcept { GetTaskBlocks().Free(block, size, align); }
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "../Engine/Define.h"
+#include "../Engine/StandardInclude.h"
+
+#include <cstddef>
+#include <new>
+
+namespace BSE
+{
+    namespace Detail
+    {
+        // Captures too large for the inline buffer come from fixed size blocks that are recycled instead of freed
+        DLL_EXPORT void* AllocateTaskStorage(size_t size, size_t align);
+        DLL_EXPORT void FreeTaskStorage(void* block, size_t size, size_t align) noexcept;
+    }
+
+    // Move only replacement for std::function<void()> used by the threading layer.
+    // Callables up to InlineSize bytes live inside the object, so scheduling them never touches the heap.
+    class TaskFunction
+    {
+    public:
+        static constexpr size_t InlineSize = 64;
+        static constexpr size_t InlineAlign = alignof(std::max_align_t);
+
+        TaskFunction() noexcept = default;
+        TaskFunction(std::nullptr_t) noexcept {}
+
+        template<typename Func, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Func>, TaskFunction> && std::is_invocable_v<std::decay_t<Func>&>>>
+        TaskFunction(Func&& func)
+        {
+            using Callable = std::decay_t<Func>;
+
+            if constexpr (std::is_pointer_v<Callable> || std::is_member_pointer_v<Callable>)
+            {
+                if (func == nullptr)
+                    return;
+            }
+
+            if constexpr (FitsInline<Callable>())
+            {
+                ::new (static_cast<void*>(m_storage)) Callable(std::forward<Func>(func));
+                m_ops = &InlineOps<Callable>::Table;
+            }
+            else
+            {
+                void* block = Detail::AllocateTaskStorage(sizeof(Callable), alignof(Callable));
+                try
+                {
+                    ::new (block) Callable(std::forward<Func>(func));
+                }
+                catch (...)
+                {
+                    Detail::FreeTaskStorage(block, sizeof(Callable), alignof(Callable));
+                    throw;
+                }
+                *reinterpret_cast<void**>(m_storage) = block;
+                m_ops = &PooledOps<Callable>::Table;
+            }
+        }
+
+        TaskFunction(TaskFunction&& other) noexcept
+        {
+            MoveFrom(other);
+        }
+
+        TaskFunction& operator=(TaskFunction&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                MoveFrom(other);
+            }
+            return *this;
+        }
+
+        TaskFunction& operator=(std::nullptr_t) noexcept
+        {
+            Reset();
+            return *this;
+        }
+
+        TaskFunction(const TaskFunction&) = delete;
+        TaskFunction& operator=(const TaskFunction&) = delete;
+
+        ~TaskFunction() { Reset(); }
+
+        void operator()()
+        {
+            m_ops->invoke(m_storage);
+        }
+
+        explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+        void Reset() noexcept
+        {
+            if (m_ops)
+            {
+                m_ops->destroy(m_storage);
+                m_ops = nullptr;
+            }
+        }
+
+        template<typename Callable>
+        static constexpr bool FitsInline()
+        {
+            return sizeof(Callable) <= InlineSize && alignof(Callable) <= InlineAlign && std::is_nothrow_move_constructible_v<Callable>;
+        }
+
+    private:
+        struct Ops
+        {
+            void (*invoke)(void* storage);
+            void (*move)(void* destination, void* source) noexcept;
+            void (*destroy)(void* storage) noexcept;
+        };
+
+        template<typename Callable>
+        struct InlineOps
+        {
+            static Callable& Get(void* storage) { return *std::launder(reinterpret_cast<Callable*>(storage)); }
+
+            static void Invoke(void* storage) { Get(storage)(); }
+
+            static void Move(void* destination, void* source) noexcept
+            {
+                ::new (destination) Callable(std::move(Get(source)));
+                Get(source).~Callable();
+            }
+
+            static void Destroy(void* storage) noexcept { Get(storage).~Callable(); }
+
+            static constexpr Ops Table{ &Invoke, &Move, &Destroy };
+        };
+
+        template<typename Callable>
+        struct PooledOps
+        {
+            static Callable& Get(void* storage) { return *static_cast<Callable*>(*reinterpret_cast<void**>(storage)); }
+
+            static void Invoke(void* storage) { Get(storage)(); }
+
+            static void Move(void* destination, void* source) noexcept
+            {
+                *reinterpret_cast<void**>(destination) = *reinterpret_cast<void**>(source);
+            }
+
+            static void Destroy(void* storage) noexcept
+            {
+                Callable* callable = &Get(storage);
+                callable->~Callable();
+                Detail::FreeTaskStorage(callable, sizeof(Callable), alignof(Callable));
+            }
+
+            static constexpr Ops Table{ &Invoke, &Move, &Destroy };
+        };
+
+        void MoveFrom(TaskFunction& other) noexcept
+        {
+            if (other.m_ops)
+            {
+                other.m_ops->move(m_storage, other.m_storage);
+                m_ops = other.m_ops;
+                other.m_ops = nullptr;
+            }
+        }
+
+        alignas(InlineAlign) unsigned char m_storage[InlineSize];
+        const Ops* m_ops = nullptr;
+    };
+}
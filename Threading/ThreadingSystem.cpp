@@ -1,7 +1,143 @@
 #include "ThreadingSystem.h"
 
+#include <thread>
+
 namespace BSE
 {
+    namespace
+    {
+        thread_local ThreadPool* t_currentPool = nullptr;
+        thread_local JobPriority t_currentPriority = JobPriority::Normal;
+
+        ThreadPoolSettings MakeSettings(size_t threadCount)
+        {
+            ThreadPoolSettings settings;
+            settings.threadCount = threadCount;
+            return settings;
+        }
+
+        // Pins each worker the first time it joins one of the pool's arenas, CPUs are handed out round robin
+        class WorkerPinObserver final : public tbb::task_scheduler_observer
+        {
+        public:
+            WorkerPinObserver(tbb::task_arena& arena, const ThreadPool& pool, const std::vector<int>& cpus, std::atomic<size_t>& nextCPU)
+                : tbb::task_scheduler_observer(arena)
+                , m_pool(pool)
+                , m_cpus(cpus)
+                , m_nextCPU(nextCPU)
+            {
+                observe(true);
+            }
+
+            ~WorkerPinObserver() override { observe(false); }
+
+            void on_scheduler_entry(bool isWorker) override
+            {
+                thread_local const ThreadPool* t_pinnedFor = nullptr;
+                if (!isWorker || t_pinnedFor == &m_pool || m_cpus.empty())
+                    return;
+
+                const int cpu = m_cpus[m_nextCPU.fetch_add(1, std::memory_order_relaxed) % m_cpus.size()];
+                if (!PinCurrentThread(cpu))
+                    std::cerr << "[ThreadPool] Failed to pin worker to CPU " << cpu << std::endl;
+
+                t_pinnedFor = &m_pool;
+            }
+
+        private:
+            const ThreadPool& m_pool;
+            const std::vector<int>& m_cpus;
+            std::atomic<size_t>& m_nextCPU;
+        };
+
+        tbb::task_arena::priority ToArenaPriority(JobPriority priority)
+        {
+            switch (priority)
+            {
+            case JobPriority::FrameCritical: return tbb::task_arena::priority::high;
+            case JobPriority::Background: return tbb::task_arena::priority::low;
+            default: return tbb::task_arena::priority::normal;
+            }
+        }
+
+        struct SpinLockGuard
+        {
+            explicit SpinLockGuard(std::atomic_flag& flag) : m_flag(flag)
+            {
+                while (m_flag.test_and_set(std::memory_order_acquire))
+                    std::this_thread::yield();
+            }
+
+            ~SpinLockGuard() { m_flag.clear(std::memory_order_release); }
+
+            std::atomic_flag& m_flag;
+        };
+
+        int64_t NowNanos()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        size_t LatencyBucket(int64_t nanos)
+        {
+            const uint64_t micros = nanos > 0 ? static_cast<uint64_t>(nanos) / 1000 : 0;
+            size_t bucket = 0;
+            for (uint64_t bound = 1; micros >= bound && bucket + 1 < ThreadPoolStats::LatencyBucketCount; bound <<= 1)
+                ++bucket;
+            return bucket;
+        }
+
+        constexpr uint64_t PackFreeHead(uint32_t tag, uint32_t index)
+        {
+            return (static_cast<uint64_t>(tag) << 32) | index;
+        }
+
+        // Shared between the caller of RunChunks and its helper jobs. Helpers that start after every chunk was
+        // claimed only touch this state, never the caller's stack, so it is reference counted and outlives the call.
+        struct ParallelChunkState
+        {
+            std::atomic<uint32_t> references{ 0 };
+            std::atomic<size_t> nextChunk{ 0 };
+            std::atomic<size_t> completedChunks{ 0 };
+            size_t chunkCount = 0;
+
+            void (*function)(void*, size_t) = nullptr;
+            void* context = nullptr;
+
+            void WorkOnChunks()
+            {
+                size_t chunk;
+                while ((chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount)
+                {
+                    function(context, chunk);
+
+                    if (completedChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == chunkCount)
+                        completedChunks.notify_all();
+                }
+            }
+
+            static ParallelChunkState* Create()
+            {
+                void* block = Detail::AllocateTaskStorage(sizeof(ParallelChunkState), alignof(ParallelChunkState));
+                return ::new (block) ParallelChunkState();
+            }
+
+            void Release()
+            {
+                if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    this->~ParallelChunkState();
+                    Detail::FreeTaskStorage(this, sizeof(ParallelChunkState), alignof(ParallelChunkState));
+                }
+            }
+        };
+    }
+
+    ThreadingSystem::ThreadingSystem(size_t completionCapacity)
+        : m_completedTasks(completionCapacity)
+    {
+    }
+
     ThreadingSystem::~ThreadingSystem()
     {
         m_taskGroup.wait();
@@ -11,37 +147,547 @@ namespace BSE
     {
         m_taskGroup.wait();
 
-        std::lock_guard<std::mutex> lock(m_queueMutex);
-        m_completedTasks.clear();
+        TaskFunction discarded;
+        while (PopCompleted(discarded)) {}
+    }
+
+    void ThreadingSystem::AddCompletedTask(TaskFunction&& task)
+    {
+        if (m_completedTasks.TryPush(std::move(task)))
+            return;
+
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflowTasks.push_back(std::move(task));
+        m_overflowCount.fetch_add(1, std::memory_order_release);
+    }
+
+    size_t ThreadingSystem::DrainCompleted(double maxMicros)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        size_t executed = 0;
+        TaskFunction task;
+        while (PopCompleted(task))
+        {
+            task();
+            task = nullptr;
+            ++executed;
+
+            if (std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() >= maxMicros)
+                break;
+        }
+
+        return executed;
     }
 
-    void ThreadingSystem::AddCompletedTask(const std::function<void()>& task)
+    void ThreadingSystem::RetrieveCompletedTasks(std::vector<TaskFunction>& out)
     {
-        std::lock_guard<std::mutex> lock(m_queueMutex);
-        m_completedTasks.push_back(task);
+        TaskFunction task;
+        while (PopCompleted(task))
+            out.push_back(std::move(task));
     }
 
-    std::vector<std::function<void()>> ThreadingSystem::RetrieveCompletedTasks()
+    size_t ThreadingSystem::GetPendingCompletionCount() const
     {
-        std::lock_guard<std::mutex> lock(m_queueMutex);
-        auto tasks = std::move(m_completedTasks);
-        m_completedTasks.clear();
-        return tasks;
+        return m_completedTasks.GetSizeApprox() + m_overflowCount.load(std::memory_order_acquire);
+    }
+
+    bool ThreadingSystem::PopCompleted(TaskFunction& out)
+    {
+        if (m_completedTasks.TryPop(out))
+            return true;
+
+        if (m_overflowCount.load(std::memory_order_acquire) == 0)
+            return false;
+
+        // Swap the overflow list out in one go, both vectors keep their capacity
+        if (m_overflowDrainPosition == m_overflowDrain.size())
+        {
+            m_overflowDrain.clear();
+            m_overflowDrainPosition = 0;
+
+            std::lock_guard<std::mutex> lock(m_overflowMutex);
+            m_overflowDrain.swap(m_overflowTasks);
+        }
+
+        if (m_overflowDrainPosition == m_overflowDrain.size())
+            return false;
+
+        out = std::move(m_overflowDrain[m_overflowDrainPosition++]);
+        m_overflowCount.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
     }
 
     ThreadPool::ThreadPool(ThreadingSystem& threadingSystem, size_t threadCount)
+        : ThreadPool(threadingSystem, MakeSettings(threadCount))
+    {
+    }
+
+    ThreadPool::ThreadPool(ThreadingSystem& threadingSystem, const ThreadPoolSettings& settings)
         : m_threadingSystem(threadingSystem)
-        , m_threadCount(threadCount)
-        , m_arena(static_cast<int>(threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount))
+        , m_threadCount(settings.threadCount)
     {
+        if (settings.pinWorkers)
+        {
+            m_workerCPUs = CPUTopology::Get().SelectWorkerCPUs(settings.reservedCPUs, settings.numaNode, settings.useSMTSiblings);
+            if (m_workerCPUs.empty())
+                std::cerr << "[ThreadPool] No CPUs left for workers, running unpinned" << std::endl;
+            else if (m_threadCount == 0)
+                m_threadCount = m_workerCPUs.size();
+        }
+
         if (m_threadCount == 0)
             m_threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+        // Lanes may overlap, so without a global cap their shares could add up to more threads than CPUs
+        if (!m_workerCPUs.empty())
+            m_parallelismLimit = std::make_unique<tbb::global_control>(tbb::global_control::max_allowed_parallelism, m_threadCount);
+
+        // All arenas draw from TBB's one global set of workers, so lanes never add threads on top of each other
+        for (size_t lane = 0; lane < LaneCount; ++lane)
+        {
+            const float share = std::clamp(settings.workerShare[lane], 0.0f, 1.0f);
+            m_laneConcurrency[lane] = std::max<size_t>(1, static_cast<size_t>(std::lround(share * m_threadCount)));
+            m_arenas[lane] = std::make_unique<tbb::task_arena>(static_cast<int>(m_laneConcurrency[lane]), 1, ToArenaPriority(static_cast<JobPriority>(lane)));
+
+            if (!m_workerCPUs.empty())
+                m_pinObservers[lane] = std::make_unique<WorkerPinObserver>(*m_arenas[lane], *this, m_workerCPUs, m_nextWorkerCPU);
+        }
+
+        m_workerCounters = std::make_unique<Detail::WorkerCounters[]>(MaxWorkers);
+
+        GrowJobPool();
     }
 
     ThreadPool::~ThreadPool()
     {
         m_shuttingDown.store(true, std::memory_order_release);
         WaitAll();
+
+        for (auto& observer : m_pinObservers)
+            observer.reset();
+    }
+
+    bool ThreadPool::AddContinuation(JobHandle antecedent, JobHandle continuation)
+    {
+        if (!continuation.IsValid())
+            return false;
+        if (!antecedent.IsValid())
+            return true;
+
+        Detail::Job& job = GetJob(antecedent.index);
+        Detail::Job& next = GetJob(continuation.index);
+
+        JobHandle relay;
+        bool newRelay = false;
+        {
+            SpinLockGuard lock(job.continuationLock);
+
+            // Already finished, nothing to wait for
+            if (job.generation.load(std::memory_order_relaxed) != antecedent.generation)
+                return true;
+
+            if (job.continuationCount < Detail::Job::MaxContinuations)
+            {
+                next.blockers.fetch_add(1, std::memory_order_relaxed);
+                job.continuations[job.continuationCount++] = continuation.index;
+                return true;
+            }
+
+            // Slots are full, the last one holds a relay whose continuations start once this job completed.
+            // A relay cannot finish before its antecedent, so its generation is still current here.
+            uint32_t& lastSlot = job.continuations[Detail::Job::MaxContinuations - 1];
+            if (GetJob(lastSlot).relay)
+            {
+                relay = JobHandle{ lastSlot, GetJob(lastSlot).generation.load(std::memory_order_relaxed) };
+            }
+            else
+            {
+                relay = AllocateJob(TaskFunction([]() {}), {}, job.priority);
+
+                Detail::Job& relayJob = GetJob(relay.index);
+                relayJob.relay = true;
+                relayJob.blockers.fetch_add(1, std::memory_order_relaxed);
+                relayJob.continuations[relayJob.continuationCount++] = lastSlot;
+                lastSlot = relay.index;
+                newRelay = true;
+            }
+        }
+
+        // A full relay chains the next one the same way
+        const bool added = AddContinuation(relay, continuation);
+        if (newRelay)
+            Run(relay);
+        return added;
     }
-}
 
+    void ThreadPool::Run(JobHandle handle)
+    {
+        if (!handle.IsValid())
+            return;
+
+        if (GetJob(handle.index).blockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            Dispatch(handle.index);
+    }
+
+    bool ThreadPool::IsComplete(JobHandle handle) const
+    {
+        if (!handle.IsValid())
+            return true;
+
+        return GetJob(handle.index).generation.load(std::memory_order_acquire) != handle.generation;
+    }
+
+    void ThreadPool::Wait(JobHandle handle)
+    {
+        if (!handle.IsValid())
+            return;
+
+        Detail::Job& job = GetJob(handle.index);
+        uint32_t current = job.generation.load(std::memory_order_acquire);
+        while (current == handle.generation)
+        {
+            job.generation.wait(current, std::memory_order_acquire);
+            current = job.generation.load(std::memory_order_acquire);
+        }
+    }
+
+    void ThreadPool::WaitAll()
+    {
+        uint32_t inFlight = m_inFlight.load(std::memory_order_acquire);
+        while (inFlight != 0)
+        {
+            m_inFlight.wait(inFlight, std::memory_order_acquire);
+            inFlight = m_inFlight.load(std::memory_order_acquire);
+        }
+
+        for (size_t lane = 0; lane < LaneCount; ++lane)
+            m_arenas[lane]->execute([this, lane]() { m_taskGroups[lane].wait(); });
+    }
+
+    void ThreadPool::GetStats(ThreadPoolStats& out) const
+    {
+        const uint32_t workerCount = std::min(m_workerCount.load(std::memory_order_acquire), MaxWorkers);
+
+        out.workers.resize(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            const Detail::WorkerCounters& counters = m_workerCounters[i];
+            WorkerStats& stats = out.workers[i];
+            stats.tasksRun = counters.tasksRun.load(std::memory_order_relaxed);
+            stats.busyMicros = counters.busyNanos.load(std::memory_order_relaxed) / 1000;
+            stats.idleMicros = counters.idleNanos.load(std::memory_order_relaxed) / 1000;
+            stats.steals = counters.steals.load(std::memory_order_relaxed);
+        }
+
+        for (size_t lane = 0; lane < LaneCount; ++lane)
+        {
+            out.queueDepth[lane] = m_queuedJobs[lane].load(std::memory_order_relaxed);
+            out.queueHighWater[lane] = m_queueHighWater[lane].load(std::memory_order_relaxed);
+        }
+
+        for (size_t bucket = 0; bucket < ThreadPoolStats::LatencyBucketCount; ++bucket)
+            out.latencyHistogram[bucket] = m_latencyHistogram[bucket].load(std::memory_order_relaxed);
+    }
+
+    ThreadPoolStats ThreadPool::GetStats() const
+    {
+        ThreadPoolStats stats;
+        GetStats(stats);
+        return stats;
+    }
+
+    void ThreadPool::ResetStats()
+    {
+        for (uint32_t i = 0; i < MaxWorkers; ++i)
+        {
+            Detail::WorkerCounters& counters = m_workerCounters[i];
+            counters.tasksRun.store(0, std::memory_order_relaxed);
+            counters.busyNanos.store(0, std::memory_order_relaxed);
+            counters.idleNanos.store(0, std::memory_order_relaxed);
+            counters.steals.store(0, std::memory_order_relaxed);
+        }
+
+        for (size_t lane = 0; lane < LaneCount; ++lane)
+            m_queueHighWater[lane].store(m_queuedJobs[lane].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        for (auto& bucket : m_latencyHistogram)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t ThreadPool::GetWorkerIndex()
+    {
+        thread_local const ThreadPool* t_statsPool = nullptr;
+        thread_local uint32_t t_statsWorker = InvalidWorker;
+
+        const std::thread::id self = std::this_thread::get_id();
+
+        // Check the slot as well, a new pool may live at the address of a destroyed one
+        if (t_statsPool == this && (t_statsWorker == InvalidWorker || m_workerThreads[t_statsWorker].load(std::memory_order_relaxed) == self))
+            return t_statsWorker;
+
+        uint32_t worker = InvalidWorker;
+        const uint32_t workerCount = std::min(m_workerCount.load(std::memory_order_acquire), MaxWorkers);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            if (m_workerThreads[i].load(std::memory_order_relaxed) == self)
+            {
+                worker = i;
+                break;
+            }
+        }
+
+        if (worker == InvalidWorker)
+        {
+            const uint32_t claimed = m_workerCount.fetch_add(1, std::memory_order_acq_rel);
+            if (claimed < MaxWorkers)
+            {
+                m_workerThreads[claimed].store(self, std::memory_order_release);
+                worker = claimed;
+            }
+        }
+
+        t_statsPool = this;
+        t_statsWorker = worker;
+        return worker;
+    }
+
+    void ThreadPool::RecordDispatch(Detail::Job& job, size_t lane)
+    {
+        job.dispatchTicks = NowNanos();
+        job.spawnWorker = (t_currentPool == this && static_cast<size_t>(t_currentPriority) == lane) ? GetWorkerIndex() : InvalidWorker;
+
+        const uint32_t depth = m_queuedJobs[lane].fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t highWater = m_queueHighWater[lane].load(std::memory_order_relaxed);
+        while (depth > highWater && !m_queueHighWater[lane].compare_exchange_weak(highWater, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void ThreadPool::RunChunks(size_t chunkCount, ChunkFunction function, void* context)
+    {
+        if (chunkCount == 0)
+            return;
+
+        const size_t helperCount = std::min(m_threadCount, chunkCount) - 1;
+        if (helperCount == 0 || m_shuttingDown.load(std::memory_order_acquire))
+        {
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+                function(context, chunk);
+            return;
+        }
+
+        ParallelChunkState* state = ParallelChunkState::Create();
+        state->references.store(static_cast<uint32_t>(helperCount + 1), std::memory_order_relaxed);
+        state->chunkCount = chunkCount;
+        state->function = function;
+        state->context = context;
+
+        const JobPriority priority = GetCallerPriority();
+        for (size_t i = 0; i < helperCount; ++i)
+        {
+            Schedule([state]() {
+                state->WorkOnChunks();
+                state->Release();
+            }, {}, priority);
+        }
+
+        state->WorkOnChunks();
+
+        size_t completed = state->completedChunks.load(std::memory_order_acquire);
+        while (completed != chunkCount)
+        {
+            state->completedChunks.wait(completed, std::memory_order_acquire);
+            completed = state->completedChunks.load(std::memory_order_acquire);
+        }
+
+        state->Release();
+    }
+
+    JobHandle ThreadPool::AllocateJob(TaskFunction&& work, JobHandle parent, JobPriority priority)
+    {
+        uint32_t index = PopFreeJob();
+        while (index == JobHandle::InvalidIndex)
+        {
+            GrowJobPool();
+            index = PopFreeJob();
+        }
+
+        Detail::Job& job = GetJob(index);
+        job.work = std::move(work);
+        job.unfinished.store(1, std::memory_order_relaxed);
+        job.blockers.store(1, std::memory_order_relaxed);
+        job.continuationCount = 0;
+        job.parent = JobHandle::InvalidIndex;
+        job.priority = priority;
+        job.relay = false;
+
+        if (parent.IsValid() && !IsComplete(parent))
+        {
+            GetJob(parent.index).unfinished.fetch_add(1, std::memory_order_relaxed);
+            job.parent = parent.index;
+        }
+
+        return JobHandle{ index, job.generation.load(std::memory_order_relaxed) };
+    }
+
+    uint32_t ThreadPool::PopFreeJob()
+    {
+        uint64_t head = m_freeJobHead.load(std::memory_order_acquire);
+        while (true)
+        {
+            uint32_t index = static_cast<uint32_t>(head);
+            if (index == JobHandle::InvalidIndex)
+                return JobHandle::InvalidIndex;
+
+            uint32_t next = GetJob(index).nextFree.load(std::memory_order_relaxed);
+            uint64_t newHead = PackFreeHead(static_cast<uint32_t>(head >> 32) + 1, next);
+            if (m_freeJobHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire))
+                return index;
+        }
+    }
+
+    void ThreadPool::PushFreeJob(uint32_t index)
+    {
+        uint64_t head = m_freeJobHead.load(std::memory_order_relaxed);
+        uint64_t newHead;
+        do
+        {
+            GetJob(index).nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            newHead = PackFreeHead(static_cast<uint32_t>(head >> 32) + 1, index);
+        } while (!m_freeJobHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void ThreadPool::GrowJobPool()
+    {
+        std::lock_guard<std::mutex> lock(m_jobChunkMutex);
+
+        // Another thread may have grown the pool while we waited for the lock
+        if (static_cast<uint32_t>(m_freeJobHead.load(std::memory_order_acquire)) != JobHandle::InvalidIndex)
+            return;
+
+        if (m_jobChunkCount == MaxJobChunks)
+            throw std::runtime_error("ThreadPool::GrowJobPool - too many jobs in flight");
+
+        const uint32_t chunk = m_jobChunkCount++;
+        m_jobChunks[chunk] = std::make_unique<Detail::Job[]>(JobChunkSize);
+
+        // Push in reverse so the lowest indices get handed out first
+        const uint32_t first = chunk << JobChunkShift;
+        for (uint32_t i = JobChunkSize; i > 0; --i)
+            PushFreeJob(first + i - 1);
+    }
+
+    JobPriority ThreadPool::GetCallerPriority() const
+    {
+        // A thread outside the pool waiting on helpers is stalled, so its helpers are frame critical
+        return t_currentPool == this ? t_currentPriority : JobPriority::FrameCritical;
+    }
+
+    void ThreadPool::Dispatch(uint32_t index)
+    {
+        const size_t lane = static_cast<size_t>(GetJob(index).priority);
+
+        m_inFlight.fetch_add(1, std::memory_order_relaxed);
+        RecordDispatch(GetJob(index), lane);
+
+        if (t_currentPool == this && static_cast<size_t>(t_currentPriority) == lane)
+        {
+            // On one of our workers in the same lane, spawn into its local deque so idle workers steal it
+            m_taskGroups[lane].run([this, index]() { Execute(index); });
+            return;
+        }
+
+        // Enter the lane's arena first so the job is still tracked by the lane's task group
+        m_arenas[lane]->enqueue([this, index, lane]() {
+            m_taskGroups[lane].run([this, index]() { Execute(index); });
+        });
+    }
+
+    void ThreadPool::Execute(uint32_t index)
+    {
+        thread_local int64_t t_lastJobEnd = 0;
+
+        Detail::Job& job = GetJob(index);
+
+        const int64_t start = NowNanos();
+        const uint32_t worker = GetWorkerIndex();
+
+        m_queuedJobs[static_cast<size_t>(job.priority)].fetch_sub(1, std::memory_order_relaxed);
+        m_latencyHistogram[LatencyBucket(start - job.dispatchTicks)].fetch_add(1, std::memory_order_relaxed);
+
+        if (worker != InvalidWorker)
+        {
+            Detail::WorkerCounters& counters = m_workerCounters[worker];
+            if (job.spawnWorker != InvalidWorker && job.spawnWorker != worker)
+                counters.steals.fetch_add(1, std::memory_order_relaxed);
+            if (t_lastJobEnd != 0 && start > t_lastJobEnd)
+                counters.idleNanos.fetch_add(static_cast<uint64_t>(start - t_lastJobEnd), std::memory_order_relaxed);
+        }
+
+        ThreadPool* previousPool = t_currentPool;
+        JobPriority previousPriority = t_currentPriority;
+        t_currentPool = this;
+        t_currentPriority = job.priority;
+
+        job.work();
+        job.work = nullptr;
+
+        FinishJob(index);
+
+        t_currentPool = previousPool;
+        t_currentPriority = previousPriority;
+
+        const int64_t end = NowNanos();
+        t_lastJobEnd = end;
+
+        if (worker != InvalidWorker)
+        {
+            Detail::WorkerCounters& counters = m_workerCounters[worker];
+            counters.tasksRun.fetch_add(1, std::memory_order_relaxed);
+            counters.busyNanos.fetch_add(static_cast<uint64_t>(end - start), std::memory_order_relaxed);
+        }
+
+        if (m_inFlight.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            m_inFlight.notify_all();
+    }
+
+    void ThreadPool::FinishJob(uint32_t index)
+    {
+        if (GetJob(index).unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            CompleteJob(index);
+    }
+
+    void ThreadPool::CompleteJob(uint32_t index)
+    {
+        Detail::Job& job = GetJob(index);
+
+        std::array<uint32_t, Detail::Job::MaxContinuations> continuations;
+        uint32_t continuationCount = 0;
+        uint32_t parent = JobHandle::InvalidIndex;
+        {
+            SpinLockGuard lock(job.continuationLock);
+
+            continuationCount = job.continuationCount;
+            std::copy_n(job.continuations.begin(), continuationCount, continuations.begin());
+            job.continuationCount = 0;
+
+            parent = job.parent;
+            job.parent = JobHandle::InvalidIndex;
+
+            job.generation.fetch_add(1, std::memory_order_acq_rel);
+        }
+        job.generation.notify_all();
+
+        PushFreeJob(index);
+
+        for (uint32_t i = 0; i < continuationCount; ++i)
+        {
+            if (GetJob(continuations[i]).blockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                Dispatch(continuations[i]);
+        }
+
+        if (parent != JobHandle::InvalidIndex)
+            FinishJob(parent);
+    }
+}
@@ -3,17 +3,27 @@
 #include "../Engine/Define.h"
 #include "../Engine/StandardInclude.h"
 
+#include "CPUTopology.h"
+#include "MPSCQueue.h"
+#include "TaskFunction.h"
+
+#include <thread>
+
+#include <tbb/global_control.h>
 #include <tbb/task_group.h>
 #include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
 
 namespace BSE
 {
     class DLL_EXPORT ThreadingSystem
     {
     public:
-        ThreadingSystem() = default;
+        static constexpr size_t DefaultCompletionCapacity = 4096;
+
+        explicit ThreadingSystem(size_t completionCapacity = DefaultCompletionCapacity);
         ~ThreadingSystem();
-        
+
         template<typename Func>
         void SubmitTask(Func&& task)
         {
@@ -22,70 +32,443 @@ namespace BSE
 
         void WaitAll();
 
-        void AddCompletedTask(const std::function<void()>& task);
-        std::vector<std::function<void()>> RetrieveCompletedTasks();
+        // Safe from any thread, completions only spill into the locked overflow list when the queue is full
+        void AddCompletedTask(TaskFunction&& task);
+
+        // Main thread only. Runs queued completions until maxMicros elapsed, at least one runs if any are queued.
+        // Returns the number of completions that ran, leftovers wait for the next call.
+        size_t DrainCompleted(double maxMicros = std::numeric_limits<double>::infinity());
+
+        // Main thread only, appends every queued completion to out so its capacity is reused between frames
+        void RetrieveCompletedTasks(std::vector<TaskFunction>& out);
+
+        size_t GetPendingCompletionCount() const;
 
     private:
+        bool PopCompleted(TaskFunction& out);
+
         tbb::task_group m_taskGroup;
 
-        std::mutex m_queueMutex;
-        std::vector<std::function<void()>> m_completedTasks;
+        MPSCQueue<TaskFunction> m_completedTasks;
+
+        std::mutex m_overflowMutex;
+        std::vector<TaskFunction> m_overflowTasks;
+        std::vector<TaskFunction> m_overflowDrain;
+        size_t m_overflowDrainPosition = 0;
+        std::atomic<size_t> m_overflowCount{ 0 };
+    };
+
+    // Lanes are separate arenas, idle workers always serve the most important lane that has work
+    enum class JobPriority : uint8_t
+    {
+        FrameCritical = 0,
+        Normal,
+        Background,
+        Count
+    };
+
+    struct DLL_EXPORT ThreadPoolSettings
+    {
+        // 0 uses every hardware thread
+        size_t threadCount = 0;
+        // Fraction of threadCount each lane may occupy at once, every lane gets at least one worker
+        std::array<float, static_cast<size_t>(JobPriority::Count)> workerShare = { 1.0f, 1.0f, 0.5f };
+
+        // Pins every worker to one CPU picked by CPUTopology::SelectWorkerCPUs and caps TBB's worker count
+        // for the whole process to threadCount. A threadCount of 0 then means one thread per selected CPU.
+        bool pinWorkers = false;
+        // Cores kept free for threads that pin themselves, see CPUTopology::SelectDedicatedCPUs
+        std::vector<int> reservedCPUs;
+        // Keep workers on one NUMA node, -1 allows all of them
+        int numaNode = -1;
+        bool useSMTSiblings = true;
+    };
+
+    struct DLL_EXPORT WorkerStats
+    {
+        uint64_t tasksRun = 0;
+        uint64_t busyMicros = 0;
+        // Gaps between two jobs on the same worker
+        uint64_t idleMicros = 0;
+        // Jobs spawned into another worker's local queue and taken from there
+        uint64_t steals = 0;
+    };
+
+    struct DLL_EXPORT ThreadPoolStats
+    {
+        // Bucket 0 counts latencies below 1us, bucket i those in [2^(i-1), 2^i) us, the last one everything above
+        static constexpr size_t LatencyBucketCount = 24;
+
+        // One entry per thread that ran a job, in the order threads first showed up
+        std::vector<WorkerStats> workers;
+        std::array<uint32_t, static_cast<size_t>(JobPriority::Count)> queueDepth{};
+        std::array<uint32_t, static_cast<size_t>(JobPriority::Count)> queueHighWater{};
+        // Time from dispatch until a worker started the job
+        std::array<uint64_t, LatencyBucketCount> latencyHistogram{};
+
+        // Upper bound in microseconds of the bucket holding the given fraction (0..1) of all samples
+        double GetLatencyPercentile(double fraction) const
+        {
+            uint64_t total = 0;
+            for (uint64_t count : latencyHistogram)
+                total += count;
+            if (total == 0)
+                return 0.0;
+
+            const uint64_t target = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * total));
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < LatencyBucketCount; ++bucket)
+            {
+                seen += latencyHistogram[bucket];
+                if (seen >= target && seen > 0)
+                    return std::ldexp(1.0, static_cast<int>(bucket));
+            }
+            return std::ldexp(1.0, static_cast<int>(LatencyBucketCount));
+        }
+    };
+
+    // Generation checked reference to a job slot, stale handles simply read as complete
+    struct DLL_EXPORT JobHandle
+    {
+        static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+        uint32_t index = InvalidIndex;
+        uint32_t generation = 0;
+
+        bool IsValid() const noexcept { return index != InvalidIndex; }
+        bool operator==(const JobHandle&) const = default;
     };
 
+    namespace Detail
+    {
+        struct alignas(64) Job
+        {
+            static constexpr uint32_t MaxContinuations = 8;
+
+            TaskFunction work;
+
+            // Bumped once the job and all of its children finished, handles holding the old value are complete
+            std::atomic<uint32_t> generation{ 0 };
+            // The job itself plus every child that has not finished yet
+            std::atomic<int32_t> unfinished{ 0 };
+            // Antecedents that have not finished yet plus one hold that Run() releases
+            std::atomic<int32_t> blockers{ 0 };
+
+            uint32_t parent = JobHandle::InvalidIndex;
+            JobPriority priority = JobPriority::Normal;
+
+            std::atomic_flag continuationLock = ATOMIC_FLAG_INIT;
+            uint32_t continuationCount = 0;
+            std::array<uint32_t, MaxContinuations> continuations{};
+            // Set on the empty jobs AddContinuation chains behind a job whose slots are full
+            bool relay = false;
+
+            std::atomic<uint32_t> nextFree{ JobHandle::InvalidIndex };
+
+            // Filled in by Dispatch for the statistics
+            int64_t dispatchTicks = 0;
+            uint32_t spawnWorker = 0xFFFFFFFFu;
+        };
+
+        // Counters of one worker, written by that worker only so they never share a cache line with another
+        struct alignas(64) WorkerCounters
+        {
+            std::atomic<uint64_t> tasksRun{ 0 };
+            std::atomic<uint64_t> busyNanos{ 0 };
+            std::atomic<uint64_t> idleNanos{ 0 };
+            std::atomic<uint64_t> steals{ 0 };
+        };
+    }
+
     class DLL_EXPORT ThreadPool
     {
     public:
         ThreadPool(ThreadingSystem& threadingSystem, size_t threadCount = 0);
+        ThreadPool(ThreadingSystem& threadingSystem, const ThreadPoolSettings& settings);
         ~ThreadPool();
 
         ThreadPool(const ThreadPool&) = delete;
         ThreadPool& operator=(const ThreadPool&) = delete;
 
         template<typename Func>
-        void Submit(Func&& task)
+        void Submit(Func&& task, JobPriority priority = JobPriority::Normal)
         {
             if (m_shuttingDown.load(std::memory_order_acquire))
                 return;
 
-            auto work = std::function<void()>(std::forward<Func>(task));
-
-            m_arena.enqueue([this, work = std::move(work)]() {
-                m_taskGroup.run([work = std::move(work)]() {
-                    work();
-                });
-            });
+            Run(CreateJob(std::forward<Func>(task), {}, priority));
         }
 
         template<typename Func, typename Completion>
-        void SubmitWithCompletion(Func&& task, Completion&& onComplete)
+        void SubmitWithCompletion(Func&& task, Completion&& onComplete, JobPriority priority = JobPriority::Normal)
         {
             if (m_shuttingDown.load(std::memory_order_acquire))
                 return;
 
-            auto work = std::function<void()>(std::forward<Func>(task));
-            auto completion = std::function<void()>(std::forward<Completion>(onComplete));
+            // Keep the raw callables in the job so small captures still fit the inline task storage
+            Run(CreateJob([this, work = std::forward<Func>(task), completion = std::forward<Completion>(onComplete)]() mutable {
+                work();
 
-            m_arena.enqueue([this, work = std::move(work), completion = std::move(completion)]() {
-                m_taskGroup.run([this, work = std::move(work), completion = std::move(completion)]() {
-                    work();
+                m_threadingSystem.AddCompletedTask(TaskFunction(std::move(completion)));
+            }, {}, priority));
+        }
 
-                    m_threadingSystem.AddCompletedTask(completion);
-                });
-            });
+        // Creates a job without scheduling it so continuations can be attached before Run().
+        // A valid parent will not complete until this job completed, create children from inside the parent's work.
+        template<typename Func>
+        JobHandle CreateJob(Func&& work, JobHandle parent = {}, JobPriority priority = JobPriority::Normal)
+        {
+            return AllocateJob(TaskFunction(std::forward<Func>(work)), parent, priority);
         }
 
-        void WaitAll()
+        template<typename Func>
+        JobHandle Schedule(Func&& work, JobHandle parent = {}, JobPriority priority = JobPriority::Normal)
         {
-            m_taskGroup.wait();
+            JobHandle handle = CreateJob(std::forward<Func>(work), parent, priority);
+            Run(handle);
+            return handle;
         }
-        
+
+        // Schedules work that starts once every job in dependencies completed
+        template<typename Func>
+        JobHandle ScheduleAfter(std::initializer_list<JobHandle> dependencies, Func&& work, JobHandle parent = {}, JobPriority priority = JobPriority::Normal)
+        {
+            JobHandle handle = CreateJob(std::forward<Func>(work), parent, priority);
+            for (const JobHandle& dependency : dependencies)
+                AddContinuation(dependency, handle);
+            Run(handle);
+            return handle;
+        }
+
+        // continuation must not have been Run() yet, returns false only for an invalid continuation. Once the
+        // antecedent's slots are full further continuations hang off an empty relay job that runs after it.
+        bool AddContinuation(JobHandle antecedent, JobHandle continuation);
+        void Run(JobHandle handle);
+
+        bool IsComplete(JobHandle handle) const;
+        // Blocks the calling thread, inside jobs prefer continuations over waiting
+        void Wait(JobHandle handle);
+
+        void WaitAll();
+
         size_t GetThreadCount() const noexcept { return m_threadCount; }
+        size_t GetLaneConcurrency(JobPriority priority) const noexcept { return m_laneConcurrency[static_cast<size_t>(priority)]; }
+        // Empty unless workers are pinned
+        const std::vector<int>& GetWorkerCPUs() const noexcept { return m_workerCPUs; }
+
+        // Relaxed snapshot, cheap enough to take every frame. out keeps its capacity between calls.
+        void GetStats(ThreadPoolStats& out) const;
+        ThreadPoolStats GetStats() const;
+        // Clears counters, high-water marks and the latency histogram
+        void ResetStats();
+
+        // Long running background jobs poll this between steps and split the rest of their work into a new job
+        bool ShouldYield() const noexcept
+        {
+            return m_queuedJobs[static_cast<size_t>(JobPriority::FrameCritical)].load(std::memory_order_relaxed) != 0;
+        }
+        ThreadingSystem& GetThreadingSystem() noexcept { return m_threadingSystem; }
+
+        // Data parallel helpers. Chunk boundaries only depend on the range and grain size, never on the worker
+        // count or timing, so results are reproducible across machines. The calling thread works on chunks too,
+        // helpers run in the caller's lane, or the frame critical lane when called from outside the pool.
+        static constexpr size_t AutoChunkCount = 64;
+
+        static size_t GetAutoGrainSize(size_t count)
+        {
+            return std::max<size_t>(1, (count + AutoChunkCount - 1) / AutoChunkCount);
+        }
+
+        // body(chunkBegin, chunkEnd) is called once per chunk
+        template<typename Func>
+        void ParallelForRange(size_t begin, size_t end, Func&& body, size_t grainSize = 0)
+        {
+            if (end <= begin)
+                return;
+
+            const size_t count = end - begin;
+            const size_t grain = grainSize == 0 ? GetAutoGrainSize(count) : grainSize;
+            const size_t chunkCount = (count + grain - 1) / grain;
+
+            auto runChunk = [&](size_t chunk) {
+                const size_t chunkBegin = begin + chunk * grain;
+                body(chunkBegin, std::min(end, chunkBegin + grain));
+            };
+
+            RunChunks(chunkCount, &InvokeChunk<decltype(runChunk)>, &runChunk);
+        }
+
+        // body(index) is called once per index
+        template<typename Func>
+        void ParallelFor(size_t begin, size_t end, Func&& body, size_t grainSize = 0)
+        {
+            ParallelForRange(begin, end, [&](size_t chunkBegin, size_t chunkEnd) {
+                for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                    body(i);
+            }, grainSize);
+        }
+
+        // Folds map(index) with combine inside every chunk, then folds the chunk results in chunk order,
+        // so floating point results are bit identical no matter how many workers took part
+        template<typename T, typename Map, typename Combine>
+        T ParallelReduce(size_t begin, size_t end, T identity, Map&& map, Combine&& combine, size_t grainSize = 0)
+        {
+            if (end <= begin)
+                return identity;
+
+            const size_t count = end - begin;
+            const size_t grain = grainSize == 0 ? GetAutoGrainSize(count) : grainSize;
+            const size_t chunkCount = (count + grain - 1) / grain;
+
+            std::vector<T> partials(chunkCount, identity);
+
+            auto runChunk = [&](size_t chunk) {
+                const size_t chunkBegin = begin + chunk * grain;
+                const size_t chunkEnd = std::min(end, chunkBegin + grain);
+
+                T accumulator = identity;
+                for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                    accumulator = combine(accumulator, map(i));
+                partials[chunk] = std::move(accumulator);
+            };
+
+            RunChunks(chunkCount, &InvokeChunk<decltype(runChunk)>, &runChunk);
+
+            T result = identity;
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+                result = combine(result, partials[chunk]);
+            return result;
+        }
+
+        // Stable merge sort, the output is identical to std::stable_sort with the same comparator
+        template<typename RandomIt, typename Compare = std::less<>>
+        void ParallelSort(RandomIt first, RandomIt last, Compare compare = Compare(), size_t grainSize = 0)
+        {
+            using Value = typename std::iterator_traits<RandomIt>::value_type;
+
+            const size_t count = static_cast<size_t>(last - first);
+            if (count < 2)
+                return;
+
+            const size_t grain = std::max<size_t>(grainSize == 0 ? GetAutoGrainSize(count) : grainSize, 2);
+            const size_t chunkCount = (count + grain - 1) / grain;
+
+            ParallelFor(0, chunkCount, [&](size_t chunk) {
+                const size_t chunkBegin = chunk * grain;
+                std::stable_sort(first + chunkBegin, first + std::min(count, chunkBegin + grain), compare);
+            }, 1);
+
+            if (chunkCount == 1)
+                return;
+
+            std::vector<Value> buffer(std::make_move_iterator(first), std::make_move_iterator(last));
+            bool inBuffer = true;
+
+            // Merge neighbouring runs pairwise, ping-ponging between the buffer and the input range
+            for (size_t width = grain; width < count; width *= 2)
+            {
+                const size_t pairCount = (count + 2 * width - 1) / (2 * width);
+
+                ParallelFor(0, pairCount, [&](size_t pair) {
+                    const size_t low = pair * 2 * width;
+                    const size_t middle = std::min(count, low + width);
+                    const size_t high = std::min(count, low + 2 * width);
+
+                    if (inBuffer)
+                        MoveMerge(buffer.begin() + low, buffer.begin() + middle, buffer.begin() + high, first + low, compare);
+                    else
+                        MoveMerge(first + low, first + middle, first + high, buffer.begin() + low, compare);
+                }, 1);
+
+                inBuffer = !inBuffer;
+            }
+
+            if (inBuffer)
+                std::move(buffer.begin(), buffer.end(), first);
+        }
 
     private:
+        using ChunkFunction = void (*)(void* context, size_t chunk);
+
+        template<typename Func>
+        static void InvokeChunk(void* context, size_t chunk)
+        {
+            (*static_cast<Func*>(context))(chunk);
+        }
+
+        // Stable, takes from the left run unless the right element is strictly smaller
+        template<typename InputIt, typename OutputIt, typename Compare>
+        static void MoveMerge(InputIt left, InputIt middle, InputIt end, OutputIt out, Compare& compare)
+        {
+            InputIt right = middle;
+            while (left != middle && right != end)
+            {
+                if (compare(*right, *left))
+                    *out++ = std::move(*right++);
+                else
+                    *out++ = std::move(*left++);
+            }
+
+            out = std::move(left, middle, out);
+            std::move(right, end, out);
+        }
+
+        // Runs function(context, chunk) for every chunk and returns once all of them finished
+        void RunChunks(size_t chunkCount, ChunkFunction function, void* context);
+
+        static constexpr uint32_t JobChunkShift = 10;
+        static constexpr uint32_t JobChunkSize = 1u << JobChunkShift;
+        static constexpr uint32_t MaxJobChunks = 64;
+
+        static constexpr size_t LaneCount = static_cast<size_t>(JobPriority::Count);
+
+        JobHandle AllocateJob(TaskFunction&& work, JobHandle parent, JobPriority priority);
+
+        Detail::Job& GetJob(uint32_t index) const { return m_jobChunks[index >> JobChunkShift][index & (JobChunkSize - 1)]; }
+        uint32_t PopFreeJob();
+        void PushFreeJob(uint32_t index);
+        void GrowJobPool();
+
+        JobPriority GetCallerPriority() const;
+
+        void Dispatch(uint32_t index);
+        void Execute(uint32_t index);
+        void FinishJob(uint32_t index);
+        void CompleteJob(uint32_t index);
+
+        static constexpr uint32_t MaxWorkers = 256;
+        static constexpr uint32_t InvalidWorker = 0xFFFFFFFFu;
+
+        // Stats slot of the calling thread, registers it on first use, InvalidWorker once all slots are taken
+        uint32_t GetWorkerIndex();
+        void RecordDispatch(Detail::Job& job, size_t lane);
+
         ThreadingSystem& m_threadingSystem;
-        tbb::task_arena m_arena;
-        tbb::task_group m_taskGroup;
-        std::atomic<bool> m_shuttingDown{ false };
         size_t m_threadCount{ 0 };
+        std::array<size_t, LaneCount> m_laneConcurrency{};
+        std::array<std::unique_ptr<tbb::task_arena>, LaneCount> m_arenas;
+        std::array<tbb::task_group, LaneCount> m_taskGroups;
+
+        std::vector<int> m_workerCPUs;
+        std::unique_ptr<tbb::global_control> m_parallelismLimit;
+        std::array<std::unique_ptr<tbb::task_scheduler_observer>, LaneCount> m_pinObservers;
+        std::atomic<size_t> m_nextWorkerCPU{ 0 };
+        std::atomic<bool> m_shuttingDown{ false };
+        // Dispatched jobs per lane that no worker picked up yet
+        std::array<std::atomic<uint32_t>, LaneCount> m_queuedJobs{};
+
+        std::array<std::unique_ptr<Detail::Job[]>, MaxJobChunks> m_jobChunks;
+        uint32_t m_jobChunkCount{ 0 };
+        std::mutex m_jobChunkMutex;
+        // Low 32 bits hold the free list head index, high 32 bits an ABA tag
+        std::atomic<uint64_t> m_freeJobHead{ JobHandle::InvalidIndex };
+        // Dispatched jobs that have not returned from Execute yet
+        std::atomic<uint32_t> m_inFlight{ 0 };
+
+        std::unique_ptr<Detail::WorkerCounters[]> m_workerCounters;
+        std::array<std::atomic<std::thread::id>, MaxWorkers> m_workerThreads{};
+        std::atomic<uint32_t> m_workerCount{ 0 };
+        std::array<std::atomic<uint32_t>, LaneCount> m_queueHighWater{};
+        std::array<std::atomic<uint64_t>, ThreadPoolStats::LatencyBucketCount> m_latencyHistogram{};
     };
 }
@@ -0,0 +1,88 @@
+#include "NodeGraph/Node.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace BSE;
+
+// Compares finding a component by name string, by StringId and by type. Every node carries the same set of
+// components so all three paths find what they look for.
+
+template<int N>
+struct BenchComponent : Component
+{
+    int value = N;
+};
+
+static volatile int s_sink = 0;
+
+template<typename Func>
+static double MeasureNanos(size_t lookups, Func&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(lookups);
+}
+
+int main(int argc, char** argv)
+{
+    size_t nodeCount = 10000;
+    size_t rounds = 100;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a(argv[i]);
+        if (a.rfind("-nodes:", 0) == 0) nodeCount = std::stoul(a.substr(7));
+        else if (a.rfind("-rounds:", 0) == 0) rounds = std::stoul(a.substr(8));
+    }
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    nodes.reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i)
+    {
+        auto node = std::make_unique<Node>("Node" + std::to_string(i));
+        node->AddComponent<BenchComponent<0>>("c0");
+        node->AddComponent<BenchComponent<1>>("c1");
+        node->AddComponent<BenchComponent<2>>("c2");
+        node->AddComponent<BenchComponent<3>>("c3");
+        node->AddComponent<BenchComponent<4>>("c4");
+        node->AddComponent<BenchComponent<5>>("target");
+        nodes.push_back(std::move(node));
+    }
+
+    const size_t lookups = nodeCount * rounds;
+    const std::string name = "target";
+    const StringId id = StringId::Intern(name);
+
+    const double byName = MeasureNanos(lookups, [&]() {
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            for (auto& node : nodes)
+                s_sink = s_sink + node->GetComponentAs<BenchComponent<5>>(name)->value;
+        }
+    });
+
+    const double byId = MeasureNanos(lookups, [&]() {
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            for (auto& node : nodes)
+                s_sink = s_sink + node->GetComponentAs<BenchComponent<5>>(id)->value;
+        }
+    });
+
+    const double byType = MeasureNanos(lookups, [&]() {
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            for (auto& node : nodes)
+                s_sink = s_sink + node->Get<BenchComponent<5>>()->value;
+        }
+    });
+
+    std::cout << nodeCount << " nodes, 6 components each, " << lookups << " lookups per path\n";
+    std::cout << "GetComponentAs(std::string) " << byName << " ns\n";
+    std::cout << "GetComponentAs(StringId)    " << byId << " ns\n";
+    std::cout << "Get<T>()                    " << byType << " ns\n";
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include "Engine/Time.h"
 #include "Engine/Window.h"
 #include "Renderer/Model.h"
 #include "Renderer/Material.h"
@@ -27,6 +28,7 @@ int main(int argc, char** argv)
     std::string modelPath;
     std::string matPath;
     int width = 1280, height = 720;
+    double tickRate = 60.0;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -35,6 +37,7 @@ int main(int argc, char** argv)
         else if (a.rfind("-MatFile:", 0) == 0) matPath = a.substr(9);
         else if (a.rfind("-width:", 0) == 0) width = std::stoi(a.substr(7));
         else if (a.rfind("-height:", 0) == 0) height = std::stoi(a.substr(8));
+        else if (a.rfind("-tickRate:", 0) == 0) tickRate = std::stod(a.substr(10));
     }
 
     try
@@ -84,6 +87,10 @@ int main(int argc, char** argv)
 
         ModelRenderer renderer;
 
+        // Input moves the camera once per tick, frames in between draw it blended by the alpha
+        Time time(tickRate);
+        modelPtr->SetTime(&time);
+
         bool running = true;
         bool dragging = false;
         int lastX = 0, lastY = 0;
@@ -121,6 +128,7 @@ int main(int argc, char** argv)
         camComp->FOV = 45.0f;
         camComp->NearPlane = 0.01f;
         camComp->FarPlane = 1000.0f;
+        camComp->SetTime(&time);
         camNode->AddComponent(std::move(camCompUP), "Camera3D");
 
         struct ViewerModelComponent : public Component
@@ -129,7 +137,7 @@ int main(int argc, char** argv)
             std::shared_ptr<Material> mat;
             std::shared_ptr<ShaderProgram> prog;
             ModelRenderer& renderer;
-            glm::mat4 viewProj = glm::mat4(1.0f);
+            const Camera3DComponent* camera = nullptr;
             glm::vec3 cameraPos = glm::vec3(0.0f);
 
             ViewerModelComponent(ModelRenderer& r) : renderer(r) {}
@@ -139,14 +147,14 @@ int main(int argc, char** argv)
             }
             virtual void Render(double Alpha) override
             {
-                if (!prog || !mat || !model) return;
+                if (!prog || !mat || !model || !camera) return;
                 prog->Bind();
                 GLint locCam = glGetUniformLocation(prog->GetID(), "uCameraPos");
                 if (locCam >= 0) glUniform3fv(locCam, 1, &cameraPos[0]);
                 mat->Bind(prog->GetID());
                 if (Lighting::ShaderUsesLighting(prog->GetID()))
                     Lighting::Apply(prog->GetID());
-                model->Render(renderer, viewProj, prog->GetID());
+                model->Render(renderer, camera->GetViewProjMatrix(Alpha), prog->GetID(), Alpha);
                 prog->Unbind();
             }
         };
@@ -156,11 +164,32 @@ int main(int argc, char** argv)
         vmc->model = modelPtr;
         vmc->mat = material;
         vmc->prog = program;
+        vmc->camera = camComp;
         modelNode->AddComponent(std::move(vmcUP), "ViewerModel");
 
         rootNode->AddChild(camNode);
         rootNode->AddChild(modelNode);
 
+        auto placeCamera = [&]() {
+            glm::vec3 camDir;
+            camDir.x = cosf(pitch) * sinf(yaw);
+            camDir.y = sinf(pitch);
+            camDir.z = cosf(pitch) * cosf(yaw);
+            glm::vec3 camPos = center + camDir * distance;
+
+            camComp->Position = camPos;
+            glm::vec3 forward = glm::normalize(center - camPos);
+            camComp->Pitch = glm::degrees(asin(glm::clamp(forward.y, -1.0f, 1.0f)));
+            camComp->Yaw = glm::degrees(atan2(forward.z, forward.x));
+            camComp->AspectRatio = (float)width / (float)height;
+
+            vmc->cameraPos = camComp->Position;
+        };
+
+        // Frames before the first tick need a view too
+        placeCamera();
+        camComp->Update(0.0);
+
         while (running && window.IsOpen())
         {
             // Was faster at the time to use SDL events directly than the Input System while making this
@@ -206,21 +235,13 @@ int main(int argc, char** argv)
             }
 
 
-            glm::vec3 camDir;
-            camDir.x = cosf(pitch) * sinf(yaw);
-            camDir.y = sinf(pitch);
-            camDir.z = cosf(pitch) * cosf(yaw);
-            glm::vec3 camPos = center + camDir * distance;
-
-            camComp->Position = camPos;
-            glm::vec3 forward = glm::normalize(center - camPos);
-            camComp->Pitch = glm::degrees(asin(glm::clamp(forward.y, -1.0f, 1.0f)));
-            camComp->Yaw = glm::degrees(atan2(forward.z, forward.x));
-            camComp->AspectRatio = (float)width / (float)height;
-            camComp->Update(0.0);
-
-            vmc->viewProj = camComp->GetViewProjMatrix();
-            vmc->cameraPos = camComp->Position;
+            time.Update();
+            while (time.ShouldTick())
+            {
+                placeCamera();
+                rootNode->UpdateNode(time.GetTimePerTick());
+                time.ConsumeTick();
+            }
 
             GL::ClearBuffers();
 
@@ -228,8 +249,7 @@ int main(int argc, char** argv)
             glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
             glDepthMask(GL_FALSE);
 
-            rootNode->UpdateNode(0.0);
-            rootNode->RenderNode(0.0);
+            rootNode->RenderNode(time.GetAlpha());
 
             glDepthMask(GL_TRUE);
             glDisable(GL_BLEND);
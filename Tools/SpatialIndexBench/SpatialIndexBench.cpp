@@ -0,0 +1,167 @@
+#include "NodeGraph/Scene.h"
+#include "NodeGraph/SpatialIndex.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace BSE;
+
+// Random walk of many moving boxes. Times the raw index (Move per object, then box queries) and the same
+// workload through Scene::Update, where the index follows the transform pass.
+
+using Clock = std::chrono::steady_clock;
+
+static double MillisSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Walker
+{
+    glm::vec3 position;
+    glm::vec3 velocity;
+};
+
+static void Step(std::vector<Walker>& walkers, float worldSize, float dt)
+{
+    for (Walker& walker : walkers)
+    {
+        walker.position += walker.velocity * dt;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (walker.position[axis] < 0.0f || walker.position[axis] > worldSize)
+                walker.velocity[axis] = -walker.velocity[axis];
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t objectCount = 100000;
+    size_t frames = 120;
+    size_t queries = 1000;
+    float speed = 1.0f;
+    float margin = 0.1f;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a(argv[i]);
+        if (a.rfind("-objects:", 0) == 0) objectCount = std::stoul(a.substr(9));
+        else if (a.rfind("-frames:", 0) == 0) frames = std::stoul(a.substr(8));
+        else if (a.rfind("-queries:", 0) == 0) queries = std::stoul(a.substr(9));
+        else if (a.rfind("-speed:", 0) == 0) speed = std::stof(a.substr(7));
+        else if (a.rfind("-margin:", 0) == 0) margin = std::stof(a.substr(8));
+    }
+
+    // Roughly constant density, about one object per 8 cubic units
+    const float worldSize = std::cbrt(static_cast<float>(objectCount) * 8.0f);
+    const float dt = 1.0f / 60.0f;
+    const AABB localBox = AABB::FromCenterExtents(glm::vec3(0.0f), glm::vec3(0.5f));
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> place(0.0f, worldSize);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+    std::vector<Walker> walkers(objectCount);
+    for (Walker& walker : walkers)
+    {
+        walker.position = glm::vec3(place(rng), place(rng), place(rng));
+        walker.velocity = glm::vec3(direction(rng), direction(rng), direction(rng)) * speed;
+    }
+
+    std::vector<AABB> queryBoxes(queries);
+    for (AABB& box : queryBoxes)
+        box = AABB::FromCenterExtents(glm::vec3(place(rng), place(rng), place(rng)), glm::vec3(4.0f));
+
+    std::cout << objectCount << " objects, " << frames << " frames, speed " << speed << ", margin " << margin << "\n";
+
+    // Raw index
+    {
+        std::vector<Walker> state = walkers;
+        SpatialIndex index(margin);
+        std::vector<int32_t> proxies(objectCount);
+
+        const auto insertStart = Clock::now();
+        for (size_t i = 0; i < objectCount; ++i)
+            proxies[i] = index.Insert(AABB{ state[i].position + localBox.min, state[i].position + localBox.max }, &state[i]);
+        const double insertMillis = MillisSince(insertStart);
+
+        double moveMillis = 0.0;
+        double queryMillis = 0.0;
+        size_t reinserts = 0;
+        size_t hits = 0;
+
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            Step(state, worldSize, dt);
+
+            const auto moveStart = Clock::now();
+            for (size_t i = 0; i < objectCount; ++i)
+            {
+                if (index.Move(proxies[i], AABB{ state[i].position + localBox.min, state[i].position + localBox.max }))
+                    ++reinserts;
+            }
+            moveMillis += MillisSince(moveStart);
+
+            const auto queryStart = Clock::now();
+            for (const AABB& box : queryBoxes)
+            {
+                index.QueryAABB(box, [&](int32_t) {
+                    ++hits;
+                    return true;
+                });
+            }
+            queryMillis += MillisSince(queryStart);
+        }
+
+        std::cout << "SpatialIndex\n";
+        std::cout << "  build          " << insertMillis << " ms, " << insertMillis * 1000.0 / objectCount << " us per insert\n";
+        std::cout << "  move all       " << moveMillis / frames << " ms per frame\n";
+        std::cout << "  reinserts      " << static_cast<double>(reinserts) / frames << " per frame, "
+                  << (reinserts ? moveMillis * 1000.0 / reinserts : 0.0) << " us per reinsert including skipped moves\n";
+        std::cout << "  box queries    " << queryMillis * 1000.0 / (frames * queries) << " us per query, "
+                  << static_cast<double>(hits) / (frames * queries) << " hits\n";
+        std::cout << "  tree height    " << index.GetHeight() << "\n";
+    }
+
+    // Through the scene
+    {
+        std::vector<Walker> state = walkers;
+        Scene scene("Bench");
+        std::vector<Node*> nodes(objectCount);
+
+        for (size_t i = 0; i < objectCount; ++i)
+        {
+            auto node = std::make_unique<Node>("Object" + std::to_string(i));
+            node->SetBounds(localBox);
+            node->GetTransform().SetPosition(state[i].position);
+            nodes[i] = node.get();
+            scene.AddNodeUnique(std::move(node));
+        }
+
+        const auto firstStart = Clock::now();
+        scene.Update(dt);
+        const double firstMillis = MillisSince(firstStart);
+
+        double updateMillis = 0.0;
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            Step(state, worldSize, dt);
+            for (size_t i = 0; i < objectCount; ++i)
+                nodes[i]->GetTransform().SetPosition(state[i].position);
+
+            const auto updateStart = Clock::now();
+            scene.Update(dt);
+            updateMillis += MillisSince(updateStart);
+        }
+
+        std::cout << "Scene::Update\n";
+        std::cout << "  first update   " << firstMillis << " ms\n";
+        std::cout << "  update         " << updateMillis / frames << " ms per frame, transforms and index sync\n";
+        std::cout << "  proxies        " << scene.GetSpatialIndex().GetProxyCount() << "\n";
+    }
+
+    return 0;
+}